@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace dukat
+{
+	// Measures wall clock time in milliseconds.
+	class BenchmarkTimer
+	{
+	private:
+		std::chrono::high_resolution_clock::time_point start;
+
+	public:
+		BenchmarkTimer(void) : start(std::chrono::high_resolution_clock::now()) { }
+		~BenchmarkTimer(void) { }
+
+		void reset(void) { start = std::chrono::high_resolution_clock::now(); }
+		double elapsed_ms(void) const
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+	};
+
+	// Headless benchmarks. Each benchmark logs its results and does not require
+	// a window, GL context or audio device.
+	void benchmark_clipmap(void);
+	void benchmark_particles(void);
+	void benchmark_callbacks(void);
+	void benchmark_skinning(void);
+	void benchmark_messenger(void);
+}
@@ -0,0 +1,52 @@
+// benchmarkapp.cpp : Defines the entry point for the console application.
+//
+
+#include "stdafx.h"
+#include "benchmark.h"
+#include <dukat/log.h>
+#include <dukat/threadpool.h>
+
+namespace dukat
+{
+	struct BenchmarkEntry
+	{
+		const char* name;
+		void (*run)(void);
+	};
+
+	static const BenchmarkEntry benchmarks[] = {
+		{ "clipmap", benchmark_clipmap },
+		{ "particles", benchmark_particles },
+		{ "callbacks", benchmark_callbacks },
+		{ "skinning", benchmark_skinning },
+		{ "messenger", benchmark_messenger },
+	};
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		// Run all benchmarks unless names are passed on the command line
+		dukat::log->info("Running benchmarks with {} threads", dukat::ThreadPool::shared().get_concurrency());
+		for (const auto& b : dukat::benchmarks)
+		{
+			auto selected = (argc <= 1);
+			for (auto i = 1; i < argc; i++)
+			{
+				selected = selected || (std::string(argv[i]) == b.name);
+			}
+			if (selected)
+			{
+				dukat::log->info("Running benchmark: {}", b.name);
+				b.run();
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		dukat::log->error("Benchmark failed with error: {}", e.what());
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "benchmark.h"
+#include <atomic>
+#include <new>
+#include <dukat/delegate.h>
+#include <dukat/log.h>
+#include <dukat/timermanager.h>
+
+// Counts all heap allocations made by the benchmark process.
+static std::atomic<long> heap_allocations(0l);
+
+void* operator new(std::size_t size)
+{
+	heap_allocations.fetch_add(1l, std::memory_order_relaxed);
+	if (auto p = std::malloc(size > 0 ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace dukat
+{
+	static constexpr float frame_time = 1.0f / 60.0f;
+
+	// Creates and calls callbacks capturing three pointers, which is beyond
+	// the inline storage of std::function on common implementations.
+	template <typename Callback>
+	static void run_calls(const char* name, int count)
+	{
+		int a = 0, b = 1, c = 2;
+		Callback callback;
+		const auto before = heap_allocations.load();
+		BenchmarkTimer timer;
+		for (auto i = 0; i < count; i++)
+		{
+			callback = [&a, &b, &c](void) { a += b + c; };
+			callback();
+		}
+		const auto ms = timer.elapsed_ms();
+		const auto allocs = heap_allocations.load() - before;
+		log->info("{:<22}: {:.2f}ns per create and call, {} allocations (result {})",
+			name, ms * 1e6 / count, allocs, a);
+	}
+
+	// Runs a timer manager in steady state: recurring timers plus one-shot
+	// timers that are re-created from callbacks every frame.
+	static void run_timers(int recurring, int one_shot)
+	{
+		TimerManager timers(nullptr);
+		long fired = 0;
+		for (auto i = 0; i < recurring; i++)
+		{
+			timers.create_timer(0.1f + 0.01f * static_cast<float>(i % 50), [&fired](void) { fired++; }, true);
+		}
+		// Each one-shot timer schedules its successor.
+		struct Chain
+		{
+			TimerManager* timers;
+			long* fired;
+			void operator()(void) const
+			{
+				(*fired)++;
+				timers->create_timer(frame_time, *this);
+			}
+		};
+		for (auto i = 0; i < one_shot; i++)
+		{
+			timers.create_timer(frame_time * static_cast<float>(i % 4), Chain{ &timers, &fired });
+		}
+
+		// Let storage reach its steady-state size first
+		for (auto i = 0; i < 120; i++)
+		{
+			timers.update(frame_time);
+		}
+
+		const auto frames = 600;
+		const auto before = heap_allocations.load();
+		const auto delegate_before = delegate_allocations();
+		fired = 0;
+		BenchmarkTimer timer;
+		for (auto i = 0; i < frames; i++)
+		{
+			timers.update(frame_time);
+		}
+		const auto ms = timer.elapsed_ms();
+		const auto allocs = heap_allocations.load() - before;
+		log->info("timers {:>6} + {:>6}: {:.3f}ms per frame, {} callbacks per frame, {:.2f} allocations per frame ({} by delegates)",
+			recurring, one_shot, ms / frames, fired / frames, static_cast<double>(allocs) / frames,
+			delegate_allocations() - delegate_before);
+	}
+
+	void benchmark_callbacks(void)
+	{
+		const auto calls = 1 << 22;
+		run_calls<std::function<void(void)>>("std::function", calls);
+		run_calls<Delegate<void(void)>>("Delegate", calls);
+
+		for (auto count : { 1024, 16384, 131072 })
+		{
+			run_timers(count, count / 4);
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#include "stdafx.h"
+#include "benchmark.h"
+#include <dukat/fractalnoisegenerator.h>
+#include <dukat/heightmap.h>
+#include <dukat/log.h>
+#include <dukat/softwareclipmap.h>
+
+namespace dukat
+{
+	static constexpr int num_levels = 10;
+	static constexpr int level_size = 255;
+	static constexpr int num_frames = 600;
+	static constexpr float frame_time = 1.0f / 60.0f;
+
+	// Flies observer in a straight line over the terrain and measures cost of
+	// keeping all samplers up to date.
+	static void run_flight(const HeightMap& height_map, float speed, bool prefetching)
+	{
+		SoftwareClipMap clip_map(num_levels, level_size, &height_map);
+		clip_map.prefetching = prefetching;
+
+		Vector3 pos{ 0.0f, 100.0f, 0.0f };
+		BenchmarkTimer timer;
+		clip_map.update(pos, frame_time);
+		const auto init_ms = timer.elapsed_ms();
+
+		// diagonal flight path
+		const Vector3 velocity{ speed * 0.8f, 0.0f, speed * 0.6f };
+		auto total_ms = 0.0;
+		auto max_ms = 0.0;
+		int64_t texels = 0;
+		for (auto i = 0; i < num_frames; i++)
+		{
+			pos += velocity * frame_time;
+			timer.reset();
+			clip_map.update(pos, frame_time);
+			const auto ms = timer.elapsed_ms();
+			total_ms += ms;
+			max_ms = std::max(max_ms, ms);
+			for (const auto& u : clip_map.get_updates())
+			{
+				texels += u.world.w * u.world.h;
+			}
+		}
+
+		const auto& stats = clip_map.get_prefetcher()->get_stats();
+		log->info("speed {:>6.0f} prefetch {}: init {:.2f}ms, frame avg {:.3f}ms max {:.3f}ms, {:.1f} Mtexels/s, hits {} misses {}",
+			speed, prefetching ? "on " : "off", init_ms, total_ms / num_frames, max_ms,
+			total_ms > 0.0 ? (double)texels / (total_ms * 1000.0) : 0.0, stats.hits, stats.misses);
+	}
+
+	// Measures throughput of CPU normal map generation for a single level.
+	static void run_normals(void)
+	{
+		const auto texture_size = level_size + 1;
+		std::vector<float> elevation(texture_size * texture_size);
+		for (auto i = 0u; i < elevation.size(); i++)
+		{
+			elevation[i] = hash_random(0.0f, 1.0f, 42u, i, 0u);
+		}
+		std::vector<float> normals(2 * (2 * texture_size) * (2 * texture_size));
+
+		const auto iterations = 100;
+		BenchmarkTimer timer;
+		for (auto i = 0; i < iterations; i++)
+		{
+			generate_clipmap_normals(elevation.data(), texture_size, i % texture_size, (3 * i) % texture_size, 200.0f, normals.data());
+		}
+		const auto ms = timer.elapsed_ms() / (double)iterations;
+		const auto texels = (double)(2 * texture_size) * (double)(2 * texture_size);
+		log->info("normals {}x{}: {:.3f}ms per level, {:.1f} Mtexels/s", 2 * texture_size, 2 * texture_size, ms, texels / (ms * 1000.0));
+	}
+
+	void benchmark_clipmap(void)
+	{
+		FractalNoiseGenerator gen(42);
+		gen.set_type(FractalNoiseGenerator::Ridged);
+		gen.set_warp(64.0f, 1.0f / 512.0f);
+		HeightMap height_map(num_levels, 200.0f);
+		height_map.generate_unbounded(&gen);
+
+		run_normals();
+		for (auto speed : { 50.0f, 500.0f, 5000.0f })
+		{
+			run_flight(height_map, speed, false);
+			run_flight(height_map, speed, true);
+		}
+	}
+}
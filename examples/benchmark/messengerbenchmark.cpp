@@ -0,0 +1,107 @@
+#include "stdafx.h"
+#include "benchmark.h"
+#include <dukat/log.h>
+#include <dukat/messenger.h>
+
+namespace dukat
+{
+	// Messenger as implemented before subscriptions were stored in a table.
+	class MapMessenger
+	{
+	private:
+		std::unordered_map<Event, std::set<Recipient*>> subscriptions;
+
+	public:
+		void trigger(const Message& message)
+		{
+			if (subscriptions.count(message.event))
+			{
+				for (auto r : subscriptions[message.event])
+				{
+					r->receive(message);
+				}
+			}
+		}
+
+		void subscribe(Recipient* recipient, Event ev)
+		{
+			subscriptions[ev].insert(recipient);
+		}
+
+		void subscribe_all(Recipient* recipient)
+		{
+			for (auto it = Events::None; it != Events::Any; ++it)
+			{
+				subscribe(recipient, it);
+			}
+		}
+	};
+
+	class CountingRecipient : public Recipient
+	{
+	public:
+		long count;
+
+		CountingRecipient(void) : count(0l) { }
+		void receive(const Message& msg) { count += msg.event; }
+	};
+
+	static constexpr int messages_per_run = 1 << 22;
+
+	// Triggers events on a messenger with a number of recipients per event.
+	// Half of the triggered events have no recipients.
+	template<typename M>
+	static double run_trigger(int recipients, long& result)
+	{
+		M messenger;
+		std::vector<CountingRecipient> targets(recipients);
+		for (auto& r : targets)
+		{
+			messenger.subscribe(&r, Events::TransformChanged);
+			messenger.subscribe(&r, Events::CollisionBegin);
+		}
+
+		const Event events[] = { Events::TransformChanged, Events::Created, Events::CollisionBegin, Events::LayerChanged };
+		BenchmarkTimer timer;
+		for (auto i = 0; i < messages_per_run; i++)
+		{
+			messenger.trigger(Message{ events[i & 3] });
+		}
+		const auto ms = timer.elapsed_ms();
+		for (const auto& r : targets)
+		{
+			result += r.count;
+		}
+		return ms * 1e6 / messages_per_run;
+	}
+
+	template<typename M>
+	static double run_subscribe_all(int count)
+	{
+		CountingRecipient r;
+		BenchmarkTimer timer;
+		for (auto i = 0; i < count; i++)
+		{
+			M messenger;
+			messenger.subscribe_all(&r);
+		}
+		return timer.elapsed_ms() * 1e3 / count;
+	}
+
+	void benchmark_messenger(void)
+	{
+		for (auto recipients : { 1, 4, 16 })
+		{
+			long result = 0l;
+			const auto map_ns = run_trigger<MapMessenger>(recipients, result);
+			const auto table_ns = run_trigger<Messenger>(recipients, result);
+			log->info("trigger {:>2} recipients: map {:.2f}ns, table {:.2f}ns per message ({:.1f}x) (result {})",
+				recipients, map_ns, table_ns, map_ns / table_ns, result);
+		}
+
+		const auto count = 16384;
+		const auto map_us = run_subscribe_all<MapMessenger>(count);
+		const auto table_us = run_subscribe_all<Messenger>(count);
+		log->info("subscribe_all: map {:.2f}us, table {:.2f}us per messenger", map_us, table_us);
+	}
+}
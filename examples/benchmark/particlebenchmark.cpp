@@ -0,0 +1,165 @@
+#include "stdafx.h"
+#include "benchmark.h"
+#include <dukat/log.h>
+#include <dukat/particledata.h>
+#include <dukat/rand.h>
+#include <dukat/threadpool.h>
+
+namespace dukat
+{
+	static constexpr float frame_time = 1.0f / 60.0f;
+	static constexpr float gravity = 25.0f;
+	static constexpr float dampening = 0.99f;
+	// Total number of particle updates per measurement
+	static constexpr int64_t updates_per_run = 1 << 26;
+	// Particles per job for threaded integration, as used by ParticleManager
+	static constexpr int particles_per_job = 8192;
+
+	static Particle random_particle(Random& rng, float min_ttl, float max_ttl)
+	{
+		Particle p;
+		p.flags = Particle::Alive | Particle::Linear;
+		const auto behavior = rng.range(0, 3);
+		if (behavior == 1)
+			p.flags |= Particle::Gravitational;
+		else if (behavior == 2)
+			p.flags |= Particle::Dampened;
+		p.pos = Vector2{ rng.range(-500.0f, 500.0f), rng.range(-500.0f, 500.0f) };
+		p.dp = Vector2{ rng.range(-50.0f, 50.0f), rng.range(-50.0f, 50.0f) };
+		p.ry = p.pos.y + rng.range(0.0f, 100.0f);
+		p.color = Color{ 1.0f, rng.next_float(), 0.0f, 1.0f };
+		p.dc = Color{ 0.0f, -0.5f, 0.0f, -0.1f };
+		p.size = rng.range(1.0f, 6.0f);
+		p.ttl = rng.range(min_ttl, max_ttl);
+		return p;
+	}
+
+	// Array-of-structures update with per-particle flag branches, as used by
+	// ParticleManager before particles were stored in SoA form.
+	static void update_aos(std::vector<Particle>& particles, float delta)
+	{
+		for (auto& p : particles)
+		{
+			if ((p.flags & Particle::Alive) != Particle::Alive)
+				continue;
+			p.ttl -= delta;
+			if ((p.flags & Particle::Linear) == Particle::Linear)
+				p.pos += p.dp * delta;
+			if ((p.flags & Particle::Gravitational) == Particle::Gravitational)
+			{
+				if (p.pos.y < p.ry)
+					p.dp.y += gravity * delta;
+				else
+					p.pos.y = p.ry;
+			}
+			if ((p.flags & Particle::Dampened) == Particle::Dampened)
+				p.dp *= dampening;
+			p.color += p.dc * delta;
+			p.size += p.dsize * delta;
+		}
+	}
+
+	static void run_particles(int count)
+	{
+		// Particles are re-created every 10 simulated seconds so dampened
+		// velocities do not decay into denormals.
+		const auto frames = 600;
+		const auto rounds = static_cast<int>(std::max<int64_t>(1, updates_per_run / ((int64_t)count * frames)));
+		Random rng(count);
+
+		// Baseline
+		std::vector<Particle> aos(count);
+		double aos_ms = 0.0;
+		for (auto r = 0; r < rounds; r++)
+		{
+			for (auto& p : aos)
+			{
+				p = random_particle(rng, 1e6f, 1e6f);
+			}
+			BenchmarkTimer timer;
+			for (auto i = 0; i < frames; i++)
+			{
+				update_aos(aos, frame_time);
+			}
+			aos_ms += timer.elapsed_ms();
+		}
+		const auto updates = (double)rounds * frames * count;
+		const auto aos_ns = aos_ms * 1e6 / updates;
+
+		// SoA, no particles expire
+		ParticleData data(count);
+		double soa_ms = 0.0;
+		for (auto r = 0; r < rounds; r++)
+		{
+			data.clear();
+			for (auto i = 0; i < count; i++)
+			{
+				data.add(random_particle(rng, 1e6f, 1e6f), 0);
+			}
+			BenchmarkTimer timer;
+			for (auto i = 0; i < frames; i++)
+			{
+				data.update(frame_time, gravity, dampening);
+			}
+			soa_ms += timer.elapsed_ms();
+		}
+		const auto soa_ns = soa_ms * 1e6 / updates;
+
+		// SoA, integrated in jobs on the shared thread pool
+		double mt_ms = 0.0;
+		for (auto r = 0; r < rounds; r++)
+		{
+			data.clear();
+			for (auto i = 0; i < count; i++)
+			{
+				data.add(random_particle(rng, 1e6f, 1e6f), 0);
+			}
+			BenchmarkTimer timer;
+			for (auto i = 0; i < frames; i++)
+			{
+				data.compact();
+				parallel_for(0, data.get_count(), particles_per_job, [&](int begin, int end) {
+					data.integrate(begin, end, frame_time, gravity, dampening);
+				});
+			}
+			mt_ms += timer.elapsed_ms();
+		}
+		const auto mt_ns = mt_ms * 1e6 / updates;
+
+		// SoA with particles expiring after 1-3 seconds and being replaced, so
+		// compaction is part of the measurement
+		double churn_ms = 0.0;
+		int64_t processed = 0;
+		for (auto r = 0; r < rounds; r++)
+		{
+			data.clear();
+			for (auto i = 0; i < count; i++)
+			{
+				data.add(random_particle(rng, 0.0f, 3.0f), 0);
+			}
+			BenchmarkTimer timer;
+			for (auto i = 0; i < frames; i++)
+			{
+				data.update(frame_time, gravity, dampening);
+				processed += data.get_count();
+				while (!data.full())
+				{
+					data.add(random_particle(rng, 1.0f, 3.0f), 0);
+				}
+			}
+			churn_ms += timer.elapsed_ms();
+		}
+		const auto churn_ns = churn_ms * 1e6 / (double)processed;
+
+		log->info("particles {:>8}: aos {:.2f}ns, soa {:.2f}ns ({:.1f}x), soa threaded {:.2f}ns ({:.1f}x), soa with churn {:.2f}ns per particle",
+			count, aos_ns, soa_ns, aos_ns / soa_ns, mt_ns, aos_ns / mt_ns, churn_ns);
+	}
+
+	void benchmark_particles(void)
+	{
+		for (auto count : { 4096, 65536, 1 << 20 })
+		{
+			run_particles(count);
+		}
+	}
+}
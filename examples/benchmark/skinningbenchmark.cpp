@@ -0,0 +1,147 @@
+#include "stdafx.h"
+#include "benchmark.h"
+#include <dukat/log.h>
+#include <dukat/rand.h>
+#include <dukat/skeleton.h>
+#include <dukat/skinnedmesh.h>
+#include <dukat/threadpool.h>
+
+namespace dukat
+{
+	static constexpr float frame_time = 1.0f / 60.0f;
+	// Synthetic character: limbs made of chained joints
+	static constexpr int num_limbs = 4;
+	static constexpr int joints_per_limb = 8;
+	static constexpr int vertices_per_mesh = 4096;
+	static constexpr int frames = 60;
+
+	static void create_character(Random& rng, Skeleton& skeleton, AnimationClip& clip)
+	{
+		Matrix4 local;
+		local.identity();
+		skeleton.add_joint(-1, local);
+		clip.add_joint();
+		for (auto l = 0; l < num_limbs; l++)
+		{
+			auto parent = 0;
+			for (auto j = 0; j < joints_per_limb; j++)
+			{
+				local.setup_translation(Vector3{ j == 0 ? rng.range(-1.0f, 1.0f) : 0.0f, 0.5f, 0.0f });
+				parent = skeleton.add_joint(parent, local);
+				clip.add_joint();
+				for (auto k = 0; k <= 4; k++)
+				{
+					const auto axis = Vector3{ rng.range(-1.0f, 1.0f), rng.range(-1.0f, 1.0f), 1.0f }.normalize();
+					clip.add_rotation_key(0.5f * static_cast<float>(k), Quaternion{ axis, rng.range(-0.5f, 0.5f) });
+				}
+			}
+		}
+	}
+
+	static void create_mesh(Random& rng, SkinnedMesh& mesh, int palette_size, std::vector<int>& joints,
+		std::vector<Vector3>& positions, std::vector<Vector3>& normals)
+	{
+		for (auto i = 0; i < vertices_per_mesh; i++)
+		{
+			positions.push_back(Vector3{ rng.range(-1.0f, 1.0f), rng.range(0.0f, 16.0f), rng.range(-1.0f, 1.0f) });
+			normals.push_back(Vector3{ rng.range(-1.0f, 1.0f), rng.range(-1.0f, 1.0f), 1.0f }.normalize());
+			// neighbouring vertices mostly share a joint, as in modelled meshes
+			joints.push_back(rng.range(0, 8) == 0 ? rng.range(0, palette_size) : i * palette_size / vertices_per_mesh);
+		}
+		mesh.set_vertices(positions.data(), normals.data(), joints.data(), vertices_per_mesh);
+	}
+
+	static void run_skinning(int instances)
+	{
+		Random rng(instances);
+		Skeleton skeleton;
+		AnimationClip clip;
+		create_character(rng, skeleton, clip);
+		const auto palette_size = skeleton.get_palette_size();
+
+		SkinnedMesh mesh;
+		std::vector<int> joints;
+		std::vector<Vector3> positions, normals;
+		create_mesh(rng, mesh, palette_size, joints, positions, normals);
+
+		std::vector<Matrix4> palettes(palette_size * instances);
+		std::vector<Model3::Vertex> out(vertices_per_mesh * instances);
+		std::vector<float> offsets(instances);
+		for (auto& o : offsets)
+		{
+			o = rng.range(0.0f, clip.get_duration());
+		}
+		auto build_palettes = [&](int begin, int end, float time) {
+			for (auto i = begin; i < end; i++)
+			{
+				const auto t = std::fmod(time + offsets[i], clip.get_duration());
+				skeleton.build_palette(clip, t, palettes.data() + i * palette_size);
+			}
+		};
+
+		// Palettes only
+		BenchmarkTimer timer;
+		for (auto f = 0; f < frames; f++)
+		{
+			build_palettes(0, instances, frame_time * f);
+		}
+		const auto palette_ms = timer.elapsed_ms() / frames;
+
+		// Baseline: per-vertex matrix lookup in original vertex order
+		timer.reset();
+		for (auto f = 0; f < frames; f++)
+		{
+			for (auto i = 0; i < instances; i++)
+			{
+				const auto palette = palettes.data() + i * palette_size;
+				auto v = out.data() + i * vertices_per_mesh;
+				for (auto k = 0; k < vertices_per_mesh; k++, v++)
+				{
+					const auto& m = palette[joints[k]];
+					const auto p = positions[k] * m;
+					v->pos[0] = p.x; v->pos[1] = p.y; v->pos[2] = p.z;
+					const auto n = normals[k];
+					v->nor[0] = n.x * m.m[0] + n.y * m.m[4] + n.z * m.m[8];
+					v->nor[1] = n.x * m.m[1] + n.y * m.m[5] + n.z * m.m[9];
+					v->nor[2] = n.x * m.m[2] + n.y * m.m[6] + n.z * m.m[10];
+				}
+			}
+		}
+		const auto base_ms = timer.elapsed_ms() / frames;
+
+		// Sorted SoA kernel on calling thread
+		timer.reset();
+		for (auto f = 0; f < frames; f++)
+		{
+			for (auto i = 0; i < instances; i++)
+			{
+				mesh.skin(palettes.data() + i * palette_size, out.data() + i * vertices_per_mesh);
+			}
+		}
+		const auto soa_ms = timer.elapsed_ms() / frames;
+
+		// Palettes and skinning spread across the shared thread pool
+		timer.reset();
+		for (auto f = 0; f < frames; f++)
+		{
+			parallel_for(0, instances, 4, [&](int begin, int end) {
+				build_palettes(begin, end, frame_time * f);
+			});
+			mesh.skin(palettes.data(), palette_size, out.data(), instances);
+		}
+		const auto mt_ms = timer.elapsed_ms() / frames;
+
+		const auto vertices = static_cast<double>(instances) * vertices_per_mesh;
+		log->info("skinning {:>4} x {} vertices, {} joints: palettes {:.3f}ms, baseline {:.3f}ms ({:.0f}M vertices/s), soa {:.3f}ms ({:.0f}M vertices/s), threaded with palettes {:.3f}ms ({:.0f}M vertices/s)",
+			instances, vertices_per_mesh, skeleton.get_joint_count(), palette_ms,
+			base_ms, vertices / base_ms * 1e-3, soa_ms, vertices / soa_ms * 1e-3, mt_ms, vertices / mt_ms * 1e-3);
+	}
+
+	void benchmark_skinning(void)
+	{
+		for (auto count : { 16, 128, 512 })
+		{
+			run_skinning(count);
+		}
+	}
+}
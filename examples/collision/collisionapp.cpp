@@ -198,7 +198,8 @@ namespace dukat
 		case Events::CollisionBegin:
 		{
 			auto other_body = static_cast<const CollisionManager2::Body*>(msg.param1);
-			auto collision = static_cast<const Collision*>(msg.param2);
+			auto contact = static_cast<const CollisionManager2::Contact*>(msg.param2);
+			auto collision = &contact->collision;
 			if (body->dynamic && body->solid && other_body->solid)
 			{
 				auto nx = std::abs(collision->normal.x);
@@ -9,12 +9,12 @@ namespace dukat
 		float max_speed; // max speed
 		float max_force; // max steering force
 		bool predator;
-		Particle* p;
+		Particle p; // position, velocity and appearance
 
-		Boid(Particle* p, bool predator = false);
+		Boid(const Particle& p, bool predator = false);
 		~Boid(void) { }
 
-		void update(const std::vector<Boid>& boids);
+		void update(const std::vector<Boid>& boids, float delta);
 		// Steer away from nearby boids.
 		virtual Vector2 seperate(const std::vector<Boid>& boids) const;
 		virtual Vector2 align(const std::vector<Boid>& boids) const;
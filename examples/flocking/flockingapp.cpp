@@ -82,21 +82,21 @@ namespace dukat
 
 	void FlockingScene::add_boid(const Vector2& pos, bool predator)
 	{
-		auto p = game->get<ParticleManager>()->create_particle();
-		p->pos = pos;
+		Particle p;
+		p.pos = pos;
 		if (predator)
 		{
-			p->color = { 1.0f, 0.0f, 0.0f, random(0.5f, 1.0f) };
+			p.color = { 1.0f, 0.0f, 0.0f, random(0.5f, 1.0f) };
 		}
 		else
 		{
-			p->color = { 1.0f, 1.0f, 1.0f, random(0.5f, 1.0f) };
+			p.color = { 1.0f, 1.0f, 1.0f, random(0.5f, 1.0f) };
 		}
-		p->size = 4.0f;
-		p->dp = Vector2{ 1.0f, 0.0f };
-		p->dc = { 0.0f, 0.0f, 0.0f, 0.0f };
-		p->ttl = 1800.0f;
-		particle_layer->add(p);
+		p.size = 4.0f;
+		p.dp = Vector2{ 1.0f, 0.0f };
+		p.dc = { 0.0f, 0.0f, 0.0f, 0.0f };
+		// boids move themselves and are re-emitted every frame
+		p.flags = Particle::Alive;
 		boids.push_back(Boid{ p, predator });
 	}
 
@@ -121,21 +121,29 @@ namespace dukat
 		cursor->p.x = dev->rxa - 0.5f * window_width;
 		cursor->p.y = dev->rya - 0.5f * window_height;
 
-		std::for_each(boids.begin(), boids.end(), [&](Boid& b) { b.update(boids);  });
+		std::for_each(boids.begin(), boids.end(), [&](Boid& b) { b.update(boids, delta);  });
 		
 		Scene2::update(delta);
 
 		// wrap around
 		std::for_each(boids.begin(), boids.end(), [](Boid& b) {
-			if (b.p->pos.x < 0.0f)
-				b.p->pos.x += window_width;
-			else if (b.p->pos.x > window_width)
-				b.p->pos.x -= window_width;
-			if (b.p->pos.y < 0.0f)
-				b.p->pos.y += window_height;
-			else if (b.p->pos.y > window_height)
-				b.p->pos.y -= window_height;
+			if (b.p.pos.x < 0.0f)
+				b.p.pos.x += window_width;
+			else if (b.p.pos.x > window_width)
+				b.p.pos.x -= window_width;
+			if (b.p.pos.y < 0.0f)
+				b.p.pos.y += window_height;
+			else if (b.p.pos.y > window_height)
+				b.p.pos.y -= window_height;
 		});
+
+		// emit particles that live for this frame only
+		auto pm = game->get<ParticleManager>();
+		for (auto& b : boids)
+		{
+			b.p.ttl = delta;
+			pm->add_particle(b.p, particle_layer);
+		}
 	}
 }
 
@@ -50,7 +50,7 @@ namespace dukat
 		gen.set_range(0.0f, 0.1f);
 		gen.set_roughness(10.0f);
 		//heatmap->generate(gen);
-		std::srand(28);
+		seed_random(28);
 		heatmap->add_emitters(24, 36);
 //		heatmap->add_emitters(12, 64);
 
@@ -94,7 +94,7 @@ namespace dukat
 
 		for (auto i = 0u; i < cells.size(); i++)
 		{
-			auto is_emitter = (rand() % chance == 0);
+			auto is_emitter = (random(0, chance) == 0);
 			cells[i].active = cells[i].emitter = is_emitter;
 			cells[i].delta = 0.0f;
 			cells[i].z = 0.0f;
@@ -154,7 +154,7 @@ namespace dukat
 			if (cell.emitter)
 			{
 				// small chance that emitter status flips...
-				if (rand() % 1000 == 0)
+				if (random(0, 1000) == 0)
 				{
 					cell.active = !cell.active;
 				}
@@ -118,14 +118,14 @@ namespace dukat
 
 		// spawn particles
 		auto pm = game->get<ParticleManager>();
-		auto p = pm->create_particle();
-		p->pos = Vector2{ random(-4.0f, 4.0f), -random(32.0f, 34.0f) };
-		p->ry = -32.0f;
-		p->dp = Vector2{ random(-4.0f, 4.0f), -random(12.0f, 16.0f) };
-		p->color = Color{ 1.0f, 1.0f, 1.0f, random(0.75f, 1.0f) };
-		p->dc = Color{ 0.0f, 0.0f, 0.0f, -0.1f };
-		p->ttl = 1.0f;
-		game->get_renderer()->get_layer("scene")->add(p);
+		Particle p;
+		p.pos = Vector2{ random(-4.0f, 4.0f), -random(32.0f, 34.0f) };
+		p.ry = -32.0f;
+		p.dp = Vector2{ random(-4.0f, 4.0f), -random(12.0f, 16.0f) };
+		p.color = Color{ 1.0f, 1.0f, 1.0f, random(0.75f, 1.0f) };
+		p.dc = Color{ 0.0f, 0.0f, 0.0f, -0.1f };
+		p.ttl = 1.0f;
+		pm->add_particle(p, game->get_renderer()->get_layer("scene"));
 
 		Scene2::update(delta);
 	}
@@ -39,12 +39,15 @@ namespace dukat
 			std::stringstream ss;
 			auto window = game->get_window();
 			auto cam = game->get_renderer()->get_camera();
+			auto pm = game->get<ParticleManager>();
 			ss << "WIN: " << window->get_width() << "x" << window->get_height()
 				<< " VIR: " << cam->transform.dimension.x << "x" << cam->transform.dimension.y
 				<< " FPS: " << game->get_fps()
 				<< " MESH: " << perfc.avg(PerformanceCounter::MESHES)
 				<< " VERT: " << perfc.avg(PerformanceCounter::VERTICES) 
 				<< " PART: " << perfc.avg(PerformanceCounter::PARTICLES)
+				<< " CAP: " << pm->get_particle_capacity()
+				<< " DROP: " << pm->get_particle_overflow()
 				<< std::endl;
 			debug_text->set_text(ss.str());
 		}, true);
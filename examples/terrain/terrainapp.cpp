@@ -3,9 +3,22 @@
 
 #include "stdafx.h"
 #include "terrainapp.h"
+#include <sys/stat.h>
 
 namespace dukat
 {
+	// Identifies a heightmap source by modification time, size and number of levels.
+	static uint64_t height_map_key(const std::string& filename, int num_levels)
+	{
+		struct stat st;
+		if (stat(filename.c_str(), &st) != 0)
+			return 0;
+		auto key = static_cast<uint64_t>(st.st_mtime);
+		key = key * 1000003 ^ static_cast<uint64_t>(st.st_size);
+		key = key * 1000003 ^ static_cast<uint64_t>(num_levels);
+		return key;
+	}
+
 	TerrainScene::TerrainScene(Game3* game) : game(game)
 	{
 		MeshBuilder2 builder2;
@@ -78,7 +91,7 @@ namespace dukat
 		   << "<F4> Toggle Stitching" << std::endl
 		   << "<F5> Toggle Normals" << std::endl
 		   << "<F11> Toggle Info" << std::endl
-		   << "<1-4> Switch Terain" << std::endl
+		   << "<1-5> Switch Terain" << std::endl
 		   << "<WASD> Move Camera" << std::endl
 		   << "<QE> Change altitude" << std::endl
 			<< std::endl;
@@ -149,13 +162,54 @@ namespace dukat
 		palette[palette_size - 1] = Color{ 1.0f, 1.0f, 1.0f, 1.0f };
 	}
 
+	void TerrainScene::load_height_map(const std::string& filename)
+	{
+		// Prefer binary heightmap next to the PNG source; rebuild it if it is
+		// missing, invalid or was created from a different source.
+		const auto binary_file = filename.substr(0, filename.rfind('.')) + ".dhm";
+		const auto key = height_map_key(filename, max_levels);
+		try
+		{
+			const auto start = SDL_GetPerformanceCounter();
+			height_map->load_binary(binary_file, key);
+			const auto end = SDL_GetPerformanceCounter();
+			log->info("Loaded {} in {:.2f}ms", binary_file, 1000.0 * (double)(end - start) / (double)SDL_GetPerformanceFrequency());
+			return;
+		}
+		catch (const std::exception& e)
+		{
+			log->info("Rebuilding {}: {}", binary_file, e.what());
+		}
+
+		const auto start = SDL_GetPerformanceCounter();
+		height_map->load(filename);
+		const auto end = SDL_GetPerformanceCounter();
+		log->info("Loaded {} in {:.2f}ms", filename, 1000.0 * (double)(end - start) / (double)SDL_GetPerformanceFrequency());
+		try
+		{
+			height_map->save_binary(binary_file, key);
+		}
+		catch (const std::exception& e)
+		{
+			log->warn("Failed to write {}: {}", binary_file, e.what());
+		}
+	}
+
+	void TerrainScene::release_terrain(void)
+	{
+		clip_map = nullptr;
+		height_map = nullptr;
+		noise_gen = nullptr;
+	}
+
 	void TerrainScene::load_mtrainier(void)
 	{
+		release_terrain();
 		// Mt Rainier data set is 10m horizontal resolution, 102.4m vertical for every 0.1f.
 		// Note: the data source acknowledges that the data is "squised" when the max range > 1024, so we 
 		// stretch it by a factor of 2.
 		height_map = std::make_unique<HeightMap>(max_levels, 2.0f * 102.4f);
-		height_map->load("../assets/heightmaps/mt_rainier_1k.png");
+		load_height_map("../assets/heightmaps/mt_rainier_1k.png");
 		clip_map = std::make_unique<ClipMap>(game, max_levels, level_size, height_map.get());
 		clip_map->set_program(game->get_shaders()->get_program("sc_clipmap.vsh", "sc_clipmap.fsh"));
 		clip_map->set_palette(palette);
@@ -165,9 +219,10 @@ namespace dukat
 
 	void TerrainScene::load_pugetsound(void)
 	{
+		release_terrain();
 		// Puget sound data set: 160m horizontal resolution, 0.1m vertical for every 1/65536
 		height_map = std::make_unique<HeightMap>(max_levels, 0.1f * 65536.0f / 160.0f);
-		height_map->load("../assets/heightmaps/ps_elevation_1k.png");
+		load_height_map("../assets/heightmaps/ps_elevation_1k.png");
 		//height_map->load("../assets/heightmaps/ps_elevation_4k.png", 0.1f * 65536.0f / 40.0f);
 		clip_map = std::make_unique<ClipMap>(game, max_levels, level_size, height_map.get());
 		clip_map->set_program(game->get_shaders()->get_program("sc_clipmap.vsh", "sc_clipmap.fsh"));
@@ -178,8 +233,9 @@ namespace dukat
 
 	void TerrainScene::load_blank(void)
 	{
+		release_terrain();
 		height_map = std::make_unique<HeightMap>(max_levels, 0.1f * 65536.0f / 160.0f);
-		height_map->load("../assets/heightmaps/blank_1k.png");
+		load_height_map("../assets/heightmaps/blank_1k.png");
 		clip_map = std::make_unique<ClipMap>(game, max_levels, level_size, height_map.get());
 		clip_map->set_program(game->get_shaders()->get_program("sc_clipmap.vsh", "sc_clipmap.fsh"));
 		clip_map->set_palette(palette);
@@ -189,10 +245,29 @@ namespace dukat
 
 	void TerrainScene::generate_terrain(void)
 	{
+		release_terrain();
 		height_map = std::make_unique<HeightMap>(max_levels, 100.0f);
 		DiamondSquareGenerator gen(42);
 		gen.set_roughness(250.0f);
 		height_map->generate(513, gen);
+		Erosion erosion(42);
+		erosion.set_droplets(50000);
+		height_map->erode(erosion);
+		clip_map = std::make_unique<ClipMap>(game, max_levels, level_size, height_map.get());
+		clip_map->set_program(game->get_shaders()->get_program("sc_clipmap.vsh", "sc_clipmap.fsh"));
+		clip_map->set_palette(palette);
+
+		switch_camera_mode(Terrain);
+	}
+
+	void TerrainScene::generate_noise_terrain(void)
+	{
+		release_terrain();
+		noise_gen = std::make_unique<FractalNoiseGenerator>(42);
+		noise_gen->set_type(FractalNoiseGenerator::Ridged);
+		noise_gen->set_warp(64.0f, 1.0f / 512.0f);
+		height_map = std::make_unique<HeightMap>(max_levels, 200.0f);
+		height_map->generate_unbounded(noise_gen.get());
 		clip_map = std::make_unique<ClipMap>(game, max_levels, level_size, height_map.get());
 		clip_map->set_program(game->get_shaders()->get_program("sc_clipmap.vsh", "sc_clipmap.fsh"));
 		clip_map->set_palette(palette);
@@ -324,6 +399,9 @@ namespace dukat
 		case SDLK_4:
 			generate_terrain();
 			break;
+		case SDLK_5:
+			generate_noise_terrain();
+			break;
 
 		case SDLK_h: // show heightmap texture
 			texture->id = clip_map->get_elevation_map()->id;
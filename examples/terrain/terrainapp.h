@@ -44,14 +44,22 @@ namespace dukat
 		CameraMode camera_mode;
 		bool direct_camera_control;
 
-		std::unique_ptr<ClipMap> clip_map;
+		// Declared so that the clip map is destroyed first; its prefetcher
+		// samples the height map and noise generator from worker threads.
+		std::unique_ptr<FractalNoiseGenerator> noise_gen;
 		std::unique_ptr<HeightMap> height_map;
+		std::unique_ptr<ClipMap> clip_map;
 
 		void build_palette(void);
+		// Loads heightmap from binary file, converting from PNG source if needed.
+		void load_height_map(const std::string& filename);
+		// Destroys current terrain, waiting for pending prefetches.
+		void release_terrain(void);
 		void load_mtrainier(void);
 		void load_pugetsound(void);
 		void load_blank(void);
 		void generate_terrain(void);
+		void generate_noise_terrain(void);
 		void switch_camera_mode(CameraMode mode);
 
 	public:
@@ -2,20 +2,42 @@
 
 #include <memory>
 #include <list>
+#include <vector>
 
 #include "animation.h"
+#include "color.h"
 #include "manager.h"
+#include "tweenpool.h"
+#include "vector2.h"
 
 namespace dukat
 {
+	// Runs animations. Animations over float, Vector2 and Color values can be
+	// added as tweens, which are kept in typed pools and stepped in batches;
+	// other animations are stepped individually.
 	class AnimationManager : public Manager
 	{
+	public:
+		// Handle of a tween; 0 is never a valid handle.
+		typedef uint32_t Handle;
+
 	private:
+		// Tags stored in tween handles to identify their pool
+		enum PoolTag { FloatTag, Vector2Tag, ColorTag };
+
 		std::list<std::unique_ptr<Animation>> animations;
+		TweenPool<float> float_tweens;
+		TweenPool<Vector2> vector2_tweens;
+		TweenPool<Color> color_tweens;
 		uint8_t active_group;
 
+		TweenPool<float>& pool(float*) { return float_tweens; }
+		TweenPool<Vector2>& pool(Vector2*) { return vector2_tweens; }
+		TweenPool<Color>& pool(Color*) { return color_tweens; }
+
 	public:
-		AnimationManager(GameBase* game) : Manager(game), active_group(0u) { }
+		AnimationManager(GameBase* game) : Manager(game), float_tweens(FloatTag), vector2_tweens(Vector2Tag),
+			color_tweens(ColorTag), active_group(0u) { }
 		~AnimationManager(void) { }
 
 		void update(float delta);
@@ -24,9 +46,37 @@ namespace dukat
 		Animation* add(std::unique_ptr<Animation> animation);
 		// Cancels an existing animation.
 		void cancel(Animation* animation);
+
+		// Animates target from its current value to value over duration seconds.
+		// Callback is called once target reaches value.
+		template<typename T>
+		Handle tween(T* target, const T& value, float duration, Easing easing = Easing::Linear,
+			Delegate<void(void)> callback = nullptr)
+		{
+			const AnimationKey<T> key{ duration, value };
+			return pool(target).add(target, &key, 1, easing, active_group, false, std::move(callback));
+		}
+		// Animates target through keys ordered by time. If looping, the callback
+		// is called at the end of each cycle.
+		template<typename T>
+		Handle tween(T* target, const std::vector<AnimationKey<T>>& keys, Easing easing = Easing::Linear,
+			bool loop = false, Delegate<void(void)> callback = nullptr)
+		{
+			return pool(target).add(target, keys.data(), static_cast<int>(keys.size()), easing, active_group,
+				loop, std::move(callback));
+		}
+		// Cancels a tween without calling its callback. Stale handles are ignored.
+		void cancel(Handle handle);
+		// Returns true if a tween has not finished or been cancelled.
+		bool is_running(Handle handle) const;
+		void pause(Handle handle);
+		void resume(Handle handle);
+		// Moves a tween to a point in time and updates its target.
+		void seek(Handle handle, float time);
+
 		// Clears all active animations.
-		void clear(void) { animations.clear(); }
+		void clear(void);
 		// Set active animation group
 		void set_active_group(uint8_t group) { this->active_group = group; }
 	};
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include "messenger.h"
@@ -19,12 +20,20 @@ namespace dukat
 		static constexpr auto max_frame_delta = 1.0f / 15.0f;
 		const std::string title; // Window title
 		int last_fps; // Most recent FPS value
-		float runtime; // time since program start in seconds
+		double runtime; // time since program start in seconds
 		bool paused; // If set, will not execute update method
 		bool done; // If set, will exit application
+		bool headless; // If set, runs without window, rendering, audio and input
+		bool uncapped; // If set, fixed updates run back to back instead of in real time
+		int tick_rate; // Fixed updates per second, or 0 to update once per frame
+		int max_steps; // Max fixed updates per frame; time beyond is dropped
+		double accumulator; // Time not yet simulated by fixed updates
+		float alpha; // Fraction of a fixed update not yet simulated
+		uint64_t ticks; // Number of fixed updates so far
 
 	protected:
-		uint32_t last_update; // Ticks at last update
+		using Clock = std::chrono::steady_clock;
+		Clock::time_point last_update; // Time of last update
 		Settings& settings;
 		std::unique_ptr<Window> window;
 #ifndef __ANDROID__
@@ -42,6 +51,9 @@ namespace dukat
 		virtual void update(float delta) = 0;
 		// Called to render to the screen.
 		virtual void render(void) = 0;
+		// Restarts frame timing so that time spent since the last update,
+		// e.g. loading a scene, is not simulated.
+		void reset_clock(void);
 
 	public:
 		// Called to initialize the application.
@@ -57,8 +69,24 @@ namespace dukat
 		bool is_done(void) const { return done; }
 		void set_done(bool done) { this->done = done; }
 		int get_fps(void) const { return last_fps; }
-		float get_time(void) const { return runtime; }
+		float get_time(void) const { return static_cast<float>(runtime); }
+		// Sets number of fixed updates per second. If 0, update is called
+		// once per frame with the time passed since the last frame.
+		void set_tick_rate(int tick_rate);
+		int get_tick_rate(void) const { return tick_rate; }
+		// Returns how far the current frame is between the last fixed update
+		// and the next one. Renderers can use this to interpolate between the
+		// previous and current simulation state. Always 1 without fixed updates.
+		float get_alpha(void) const { return alpha; }
+		// If set, the loop performs one fixed update per iteration without
+		// waiting for real time to pass. Used to load-test the simulation.
+		void set_uncapped(bool uncapped) { this->uncapped = uncapped; }
+		bool is_uncapped(void) const { return uncapped; }
+		uint64_t get_ticks(void) const { return ticks; }
+		// Returns true if running without window, rendering, audio and input.
+		bool is_headless(void) const { return headless; }
 
+		// Not available in headless mode.
 		Window* get_window(void) const { return window.get(); }
 #ifndef __ANDROID__
 		AudioManager* get_audio(void) const { return audio_manager.get(); }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "aabb3.h"
+#include "frustum.h"
 #include "matrix4.h"
 #include "plane.h"
 #include "recipient.h"
@@ -40,8 +41,8 @@ namespace dukat
 		float near_clip;
 		float far_clip;
 
-		// Clip planes
-		Plane left_clip_plane, right_clip_plane;
+		// View frustum in world space
+		Frustum frustum;
 
 		void compute_horizontal_fov(void);
 
@@ -56,14 +57,17 @@ namespace dukat
 		float get_horizontal_fov(void) const { return fov_h; }
 		float get_aspect_ratio(void) const { return aspect_ratio; }
 		void set_clip(float near, float far) { near_clip = near; far_clip = far; }
-		const Plane& get_left_clip_plane(void) const { return left_clip_plane; }
-		const Plane& get_right_clip_plane(void) const { return right_clip_plane; }
+		const Plane& get_left_clip_plane(void) const { return frustum.get_plane(Frustum::Left); }
+		const Plane& get_right_clip_plane(void) const { return frustum.get_plane(Frustum::Right); }
+		const Frustum& get_frustum(void) const { return frustum; }
 		float get_near_clip(void) const { return near_clip; }
 		float get_far_clip(void) const { return far_clip; }
 		void refresh(void) { resize(window->get_width(), window->get_height()); }
 
 		// Returns true if a AABB3 is not visible to this camera.
-		inline bool is_clipped(const AABB3& bb) const { return (bb.classify_plane(left_clip_plane) < 0 || bb.classify_plane(right_clip_plane) < 0); }
+		inline bool is_clipped(const AABB3& bb) const { return frustum.classify(bb) == Frustum::Outside; }
+		// Returns true if a bounding sphere is not visible to this camera.
+		inline bool is_clipped(const Vector3& center, float radius) const { return frustum.classify(center, radius) == Frustum::Outside; }
 
 		// Updates the camera's view matrix. Subclasses of camera should update
 		// the camera axes and call this method to update the view matrix.
@@ -77,8 +81,6 @@ namespace dukat
 		Ray3 pick_ray_screen(int x, int y);
 		// Computes a pick ray for a set of coordinates in view space.
 		Ray3 pick_ray_view(float x, float y);
-		// Computes left and right clip planes.
-		static void compute_clip_planes(const CameraTransform3& transform, float fov, Plane& left_plane, Plane& right_plane);
 
 		void receive(const Message& msg);
 	};
@@ -5,6 +5,9 @@
 #include <vector>
 #include "aabb3.h"
 #include "buffers.h"
+#include "clipmaplevel.h"
+#include "clipmapprefetcher.h"
+#include "clipmapstate.h"
 #include "color.h"
 #include "game3.h"
 #include "plane.h"
@@ -18,43 +21,6 @@ namespace dukat
     struct VertexAttribute;
     class HeightMap;
 
-    struct ClipMapLevel
-    {
-        static const uint8_t bottom_right = 0;
-        static const uint8_t top_right = 1;
-        static const uint8_t bottom_left = 2;
-        static const uint8_t top_left = 3;
-
-        const int index;
-        Vector2 origin; // current origin of this level
-        int u, v; // origin in texture space 
-        Vector2 last_shift; // last change to origin to this level
-        uint8_t orientation; // flag indicating position of this level within next coarser level
-        bool is_dirty;
-
-        // Commonly used values
-        float scale;
-        float width;
-        float half_width;
-
-        // Precomputed bounding boxes for each level 
-        static constexpr int bb_inner_idx = 0;
-        static constexpr int bb_block_idx = 4;
-		std::array<AABB3, 16> bounding_boxes;
-
-        ClipMapLevel(int index) : index(index), origin(0.0f, 0.0f), u(0), v(0), last_shift(0.0f, 0.0f), is_dirty(true) { }
-        ~ClipMapLevel(void) { }
-
-        // Shifts origin and attached bounding boxes
-        void translate(const Vector2& offset);
-
-		// Orientation helpers
-		inline bool is_left(void) const { return (orientation & 0x2) == 0x2; }
-		inline bool is_right(void) const { return (orientation & 0x2) == 0x0; }
-		inline bool is_top(void) const { return (orientation & 0x1) == 0x1; }
-		inline bool is_bottom(void) const { return (orientation & 0x1) == 0x0; }
-    };
-
     class ClipMap : public Mesh
     {
     private:
@@ -63,8 +29,8 @@ namespace dukat
 		const int texture_size;
 		Game3* game;
 		HeightMap* height_map; // Height map data
-		std::vector<ClipMapLevel> levels;
-		int min_level; // min level to render - based on height of observer
+		ClipMapState state; // level bookkeeping
+		std::vector<ClipMapUpdate> updates; // pending elevation sampler updates
 
 		// Clipmap meshes
         std::unique_ptr<MeshData> inner_mesh;
@@ -72,8 +38,6 @@ namespace dukat
         std::unique_ptr<MeshData> ring_mesh;
         std::array<std::unique_ptr<MeshData>, 4> fill_mesh;
         std::unique_ptr<MeshData> perimeter_mesh;
-		std::array<Vector2, 4> inner_offsets; // Offsets for <I> blocks
-		std::array<Vector2, 12> block_offsets; // Offsets for <B> blocks
 
 		ShaderProgram* program; // used to render final terrain
 		std::unique_ptr<Texture> elevation_maps; // 1-channel GL_R32F texture array for elevation data
@@ -82,6 +46,7 @@ namespace dukat
 
         ShaderProgram* update_program; // used to update elevation sampler 
 		std::vector<GLfloat> buffer; // Buffer used to update elevation samplers.
+		std::unique_ptr<ClipMapPrefetcher> prefetcher; // samples elevation data ahead of level shifts
         std::unique_ptr<FrameBuffer> fb_update; // frame buffer to update elevation sampler 
         std::unique_ptr<MeshData> quad_update; // quad mesh used to update elevation sampler
 		std::unique_ptr<Texture> update_texture; // 1-channel GL_R32F texture used to update elevation maps.
@@ -90,14 +55,14 @@ namespace dukat
 		std::unique_ptr<FrameBuffer> fb_normal; // frame buffer to generate normal textures
 		std::unique_ptr<MeshData> quad_normal; // quad mesh used to update normal shader
 
-		void build_levels(void);
         void build_color_sampler(void);
         void build_buffers(void);
         void build_ring_buffer(int block_size);
         void build_fill_buffer(int block_size);
         void build_perimeter_buffer(void);
 
-        void update_levels(void);
+        // Fills buffer with elevation data for a rect, using prefetched data if available.
+        void load_elevation(int level, const Rect& r);
         // Updates elevation samplers and returns index of coarsest level that was updated.
         int update_elevation_maps(void);
         // Updates normal samplers starting at max_index to finest grained level.
@@ -109,6 +74,7 @@ namespace dukat
         bool stitching;
 		bool blending;
         bool lighting;
+        bool prefetching; // if set, elevation data is sampled ahead of time on a worker thread
         // Observer (i.e., camera) position in world space
 		Vector3 observer_pos;
         
@@ -124,7 +90,9 @@ namespace dukat
         void render(Renderer* renderer);
         
         // Testing
+        const ClipMapState& get_state(void) const { return state; }
         Texture* get_elevation_map(void) { return elevation_maps.get(); }
         Texture* get_normal_map(void) { return normal_maps.get(); }
+        ClipMapPrefetcher* get_prefetcher(void) { return prefetcher.get(); }
     };
 }
\ No newline at end of file
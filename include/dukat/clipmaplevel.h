@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "aabb3.h"
+#include "vector2.h"
+
+namespace dukat
+{
+    struct ClipMapLevel
+    {
+        static const uint8_t bottom_right = 0;
+        static const uint8_t top_right = 1;
+        static const uint8_t bottom_left = 2;
+        static const uint8_t top_left = 3;
+
+        const int index;
+        Vector2 origin; // current origin of this level
+        int u, v; // origin in texture space 
+        Vector2 last_shift; // last change to origin to this level
+        uint8_t orientation; // flag indicating position of this level within next coarser level
+        bool is_dirty;
+
+        // Commonly used values
+        float scale;
+        float width;
+        float half_width;
+
+        // Precomputed bounding boxes for each level 
+        static constexpr int bb_inner_idx = 0;
+        static constexpr int bb_block_idx = 4;
+        static constexpr int bb_level_idx = 16; // encloses all blocks of this level
+		std::array<AABB3, 17> bounding_boxes;
+
+        ClipMapLevel(int index) : index(index), origin(0.0f, 0.0f), u(0), v(0), last_shift(0.0f, 0.0f), is_dirty(true) { }
+        ~ClipMapLevel(void) { }
+
+        // Shifts origin and attached bounding boxes
+        void translate(const Vector2& offset)
+        {
+            last_shift = offset / scale;
+            origin += offset;
+            for (auto& bb : bounding_boxes)
+            {
+                bb.min.x += offset.x;
+                bb.min.z += offset.y;
+                bb.max.x += offset.x;
+                bb.max.z += offset.y;
+            }
+        }
+
+		// Orientation helpers
+		inline bool is_left(void) const { return (orientation & 0x2) == 0x2; }
+		inline bool is_right(void) const { return (orientation & 0x2) == 0x0; }
+		inline bool is_top(void) const { return (orientation & 0x1) == 0x1; }
+		inline bool is_bottom(void) const { return (orientation & 0x1) == 0x0; }
+    };
+}
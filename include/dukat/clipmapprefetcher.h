@@ -0,0 +1,82 @@
+#pragma once
+
+#include <future>
+#include <memory>
+#include <vector>
+#include "rect.h"
+#include "threadpool.h"
+#include "vector2.h"
+#include "vector3.h"
+
+namespace dukat
+{
+	class HeightMap;
+	struct ClipMapLevel;
+
+	// Background prefetch stage for clipmap elevation data.
+	//
+	// Based on the observer's velocity, predicts the strip of elevation data each
+	// level will need for its next toroidal shift and samples it from the height
+	// map on a worker thread. When the level actually shifts, the update only has
+	// to copy the prefetched data instead of sampling the height map on the render
+	// thread. Has no dependency on a GL context.
+	class ClipMapPrefetcher
+	{
+	public:
+		struct Stats
+		{
+			int requests; // No# of strips queued for prefetch
+			int hits; // No# of fetches served from prefetched data
+			int misses; // No# of fetches not covered by prefetched data
+			int discarded; // No# of strips dropped after misprediction
+		};
+
+	private:
+		// Block of elevation data sampled from the height map.
+		struct Block
+		{
+			int level;
+			Rect rect;
+			std::vector<float> data;
+			std::shared_future<void> pending;
+			bool used;
+		};
+
+		const HeightMap* height_map;
+		const int num_levels;
+		const int texture_size;
+		std::unique_ptr<ThreadPool> worker; // null if running synchronously
+		std::vector<std::vector<std::shared_ptr<Block>>> blocks; // staged blocks per level
+		Vector2 velocity; // smoothed observer velocity on x/z plane
+		Vector2 last_pos;
+		bool has_last_pos;
+		Stats stats;
+
+		// Queues a rect for sampling unless it is already staged.
+		void request(int level, const Rect& rect, std::vector<std::shared_ptr<Block>>& keep);
+
+	public:
+		// Min speed along an axis before shifts in that direction are predicted.
+		static constexpr float min_speed = 0.01f;
+
+		// Creates a new prefetcher. If async is false, strips are sampled
+		// immediately on the calling thread.
+		ClipMapPrefetcher(const HeightMap* height_map, int num_levels, int texture_size, bool async = true);
+		~ClipMapPrefetcher(void);
+
+		// Tracks observer position to estimate velocity.
+		void update_observer(const Vector3& pos, float delta);
+		// Predicts next shift of every level and queues prefetch of new strips.
+		// Staged strips that no longer match the prediction are dropped.
+		void predict(const std::vector<ClipMapLevel>& levels);
+		// Copies elevation data for a rect into buffer if the rect is covered by
+		// a staged block. Waits for the block if it is still being sampled.
+		bool fetch(int level, const Rect& rect, std::vector<float>& buffer);
+		// Drops all staged data. Needs to be called if the height map changes.
+		void clear(void);
+
+		const Vector2& get_velocity(void) const { return velocity; }
+		const Stats& get_stats(void) const { return stats; }
+		void reset_stats(void) { stats = Stats{ 0, 0, 0, 0 }; }
+	};
+}
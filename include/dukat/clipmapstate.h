@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "clipmaplevel.h"
+#include "rect.h"
+#include "vector2.h"
+#include "vector3.h"
+
+namespace dukat
+{
+	class HeightMap;
+
+	// Region of a level's elevation sampler that needs to be refreshed.
+	struct ClipMapUpdate
+	{
+		int level;
+		Rect world; // rect to sample from height map in level texel space
+		Rect texture; // destination rect in sampler; may extend past the sampler edge and wraps around
+		bool full; // set if the whole sampler is rebuilt
+	};
+
+	// CPU-side bookkeeping of a clipmap: level origins, toroidal texture offsets,
+	// dirty levels and the rects that need to be refreshed. Does not depend on a
+	// GL context, so it can be driven headless.
+	class ClipMapState
+	{
+	private:
+		const int num_levels;
+		const int level_size;
+		const int texture_size;
+		const HeightMap* height_map;
+		std::vector<ClipMapLevel> levels;
+		int min_level; // min level to render - based on height of observer
+		std::array<Vector2, 4> inner_offsets; // Offsets for <I> blocks
+		std::array<Vector2, 12> block_offsets; // Offsets for <B> blocks
+
+		void build_offsets(void);
+		void build_levels(void);
+		void update_levels(const Vector3& observer_pos);
+
+	public:
+		ClipMapState(int num_levels, int level_size, const HeightMap* height_map);
+		~ClipMapState(void) { }
+
+		// Selects min level and shifts level origins to follow the observer.
+		void update(const Vector3& observer_pos);
+		// Appends elevation sampler updates for all dirty levels and clears their
+		// dirty flags. Returns index of coarsest level that was updated, or -1.
+		int collect_updates(std::vector<ClipMapUpdate>& updates);
+
+		int get_num_levels(void) const { return num_levels; }
+		int get_level_size(void) const { return level_size; }
+		int get_texture_size(void) const { return texture_size; }
+		int get_min_level(void) const { return min_level; }
+		const std::vector<ClipMapLevel>& get_levels(void) const { return levels; }
+		const ClipMapLevel& get_level(int index) const { return levels[index]; }
+		const std::array<Vector2, 4>& get_inner_offsets(void) const { return inner_offsets; }
+		const std::array<Vector2, 12>& get_block_offsets(void) const { return block_offsets; }
+	};
+}
@@ -3,6 +3,7 @@
 #include <list>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include "game2.h"
 #include "manager.h"
@@ -47,6 +48,11 @@ namespace dukat
 
 		std::unique_ptr<QuadTree<Body>> tree;
 		std::list<std::unique_ptr<Body>> bodies;
+		// Messages posted with a body are delivered when the event bus is
+		// drained at the end of the frame, so destroyed bodies are kept until
+		// a drain has happened since they were retired.
+		std::vector<std::unique_ptr<Body>> destroyed; // since last update
+		std::vector<std::unique_ptr<Body>> retired; // before last update
 		std::unordered_map<uint32_t, Contact> contacts;
 
 		friend class DebugEffect2;
@@ -75,6 +81,8 @@ namespace dukat
 		void set_world_depth(int world_depth) { this->world_depth = world_depth; create_tree(); }
 
 		Body* create_body(bool dynamic = true);
+		// Removes a body. Its memory stays valid until pending collision
+		// messages that refer to it have been delivered.
 		void destroy_body(Body* body);
 
 		// Returns the number of collision bodies.
@@ -87,6 +95,9 @@ namespace dukat
 		std::list<Contact*> get_contacts(Body* b) const;
 		// Returns all bodies at point p.
 		std::list<Body*> get_bodies(const Vector2& p) const;
+		// Collects active, solid, static bodies from the broad-phase tree as of
+		// the last update.
+		void collect_static_bodies(std::vector<const Body*>& res) const;
 
 		void update(float delta);
 	};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace dukat
+{
+	// Default number of bytes a delegate can store inline.
+	static constexpr std::size_t delegate_size = 32;
+
+	// Returns number of heap allocations made by delegates for callables that
+	// did not fit their inline storage.
+	long delegate_allocations(void);
+	// Counts a delegate heap allocation.
+	void count_delegate_allocation(void);
+
+	template<typename Signature, std::size_t Size = delegate_size>
+	class Delegate;
+
+	// Type-erased callable similar to std::function. Callables of up to Size
+	// bytes, such as lambdas capturing a few references or pointers, are
+	// stored inline, so creating, copying and calling a delegate does not
+	// allocate. Larger callables are stored on the heap.
+	template<typename R, typename... Args, std::size_t Size>
+	class Delegate<R(Args...), Size>
+	{
+	private:
+		enum Operation { Copy, Move, Destroy };
+		typedef R(*Invoker)(void* storage, Args... args);
+		typedef void(*Manager)(Operation op, void* dst, void* src);
+		typedef typename std::aligned_storage<Size, alignof(std::max_align_t)>::type Storage;
+
+		template<typename F>
+		struct Inline
+		{
+			static R invoke(void* storage, Args... args)
+			{
+				return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+			}
+
+			static void manage(Operation op, void* dst, void* src)
+			{
+				switch (op)
+				{
+				case Copy:
+					new (dst) F(*static_cast<const F*>(src));
+					break;
+				case Move:
+					new (dst) F(std::move(*static_cast<F*>(src)));
+					static_cast<F*>(src)->~F();
+					break;
+				case Destroy:
+					static_cast<F*>(dst)->~F();
+					break;
+				}
+			}
+		};
+
+		template<typename F>
+		struct Heap
+		{
+			static R invoke(void* storage, Args... args)
+			{
+				return (**static_cast<F**>(storage))(std::forward<Args>(args)...);
+			}
+
+			static void manage(Operation op, void* dst, void* src)
+			{
+				switch (op)
+				{
+				case Copy:
+					count_delegate_allocation();
+					*static_cast<F**>(dst) = new F(**static_cast<F* const*>(src));
+					break;
+				case Move:
+					*static_cast<F**>(dst) = *static_cast<F**>(src);
+					break;
+				case Destroy:
+					delete *static_cast<F**>(dst);
+					break;
+				}
+			}
+		};
+
+		template<typename F>
+		struct fits_inline : std::integral_constant<bool, sizeof(F) <= Size
+			&& alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<F>::value> { };
+
+		Storage storage;
+		Invoker invoker;
+		Manager manager;
+
+		template<typename F>
+		void store(F&& f, std::true_type)
+		{
+			typedef typename std::decay<F>::type T;
+			new (&storage) T(std::forward<F>(f));
+			invoker = &Inline<T>::invoke;
+			manager = &Inline<T>::manage;
+		}
+
+		template<typename F>
+		void store(F&& f, std::false_type)
+		{
+			typedef typename std::decay<F>::type T;
+			count_delegate_allocation();
+			*reinterpret_cast<T**>(&storage) = new T(std::forward<F>(f));
+			invoker = &Heap<T>::invoke;
+			manager = &Heap<T>::manage;
+		}
+
+		void reset(void)
+		{
+			if (manager != nullptr)
+				manager(Destroy, &storage, nullptr);
+			invoker = nullptr;
+			manager = nullptr;
+		}
+
+	public:
+		Delegate(void) : invoker(nullptr), manager(nullptr) { }
+		Delegate(std::nullptr_t) : invoker(nullptr), manager(nullptr) { }
+		Delegate(const Delegate& other) : invoker(other.invoker), manager(other.manager)
+		{
+			if (manager != nullptr)
+				manager(Copy, &storage, const_cast<Storage*>(&other.storage));
+		}
+		Delegate(Delegate&& other) noexcept : invoker(other.invoker), manager(other.manager)
+		{
+			if (manager != nullptr)
+				manager(Move, &storage, &other.storage);
+			other.invoker = nullptr;
+			other.manager = nullptr;
+		}
+		template<typename F, typename = typename std::enable_if<
+			!std::is_same<typename std::decay<F>::type, Delegate>::value>::type>
+		Delegate(F&& f) : invoker(nullptr), manager(nullptr)
+		{
+			store(std::forward<F>(f), fits_inline<typename std::decay<F>::type>());
+		}
+		~Delegate(void) { reset(); }
+
+		Delegate& operator=(const Delegate& other)
+		{
+			if (this != &other)
+			{
+				Delegate tmp(other);
+				*this = std::move(tmp);
+			}
+			return *this;
+		}
+		Delegate& operator=(Delegate&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				invoker = other.invoker;
+				manager = other.manager;
+				if (manager != nullptr)
+					manager(Move, &storage, &other.storage);
+				other.invoker = nullptr;
+				other.manager = nullptr;
+			}
+			return *this;
+		}
+		Delegate& operator=(std::nullptr_t) { reset(); return *this; }
+
+		R operator()(Args... args) const
+		{
+			return invoker(const_cast<Storage*>(&storage), std::forward<Args>(args)...);
+		}
+
+		explicit operator bool(void) const { return invoker != nullptr; }
+		bool operator==(std::nullptr_t) const { return invoker == nullptr; }
+		bool operator!=(std::nullptr_t) const { return invoker != nullptr; }
+	};
+}
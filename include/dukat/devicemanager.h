@@ -19,7 +19,7 @@ namespace dukat
 	public:
 		InputDevice* active;
 
-		DeviceManager(const Settings& settings) : settings(settings) { }
+		DeviceManager(const Settings& settings) : settings(settings), active(nullptr) { }
 		~DeviceManager(void) { }
 
 		void add_keyboard(Window* window);
@@ -4,6 +4,9 @@
 
 namespace dukat
 {
+	// Diamond-square fractal terrain generator. Runs one pass per scale; random
+	// offsets are derived from (seed, x, y, pass) so that every pass can be 
+	// evaluated in parallel and output does not depend on the number of threads.
 	class DiamondSquareGenerator : public HeightMapGenerator
 	{
 	private:
@@ -11,17 +14,28 @@ namespace dukat
 		float roughness;
 		float min_val, max_val; // range of output values [0..1]
 
-		void divide(HeightMap::Level& level, int size) const;
-		void square(HeightMap::Level& level, int x, int y, int size, float offset) const;
-		void diamond(HeightMap::Level& level, int x, int y, int size, float offset) const;
+		// Returns random offset for a sample in a given pass.
+		float offset(int x, int y, int pass, float scale) const;
+		// Computes center points of all squares of a given step size.
+		void square_pass(HeightMap::Level& level, int period, int step, int pass, bool wrap) const;
+		// Computes center points of all diamonds of a given step size.
+		void diamond_pass(HeightMap::Level& level, int period, int step, int pass, bool wrap) const;
 
 	public:
-		DiamondSquareGenerator(int seed = 0) : seed(seed), min_val(0.0f), max_val(1.0f) { }
+		DiamondSquareGenerator(int seed = 0) : seed(seed), roughness(1.0f), min_val(0.0f), max_val(1.0f) { }
 		~DiamondSquareGenerator(void) { }
 
+		// Generates terrain for a level. Levels of size 2^n wrap around at the edges 
+		// and can be tiled, levels of size 2^n+1 are bounded.
 		void generate(HeightMap::Level& level) const;
+		// Generates a tile of a seamless map of map_size x map_size samples, with the
+		// tile's lower left corner at (x, y). map_size must be a power of 2; x and y 
+		// may lie outside of the map and will wrap around. Samples match those of
+		// generate for a level of map_size, except that tiles are normalized against 
+		// the maximum possible elevation range rather than the actual min / max of the map. 
+		void generate_tile(HeightMap::Level& tile, int map_size, int x, int y) const;
 
 		void set_roughness(float roughness) { this->roughness = roughness; }
 		void set_range(float min_val, float max_val) { this->min_val = min_val; this->max_val = max_val; }
 	};
-}
\ No newline at end of file
+}
@@ -42,6 +42,7 @@
 #include "matrix4.h"
 #include "plane.h"
 #include "quaternion.h"
+#include "rand.h"
 #include "ray2.h"
 #include "ray3.h"
 #include "rect.h"
@@ -60,6 +61,7 @@
 #include "boundingbody3.h"
 #include "boundingcircle.h"
 #include "boundingsphere.h"
+#include "frustum.h"
 #ifndef __ANDROID__
 #include "box2dmanager.h"
 #endif
@@ -70,13 +72,20 @@
 // System
 #include "animation.h"
 #include "animationmanager.h"
+#include "easing.h"
+#include "tweenpool.h"
 #include "application.h"
 #include "assetloader.h"
 #include "bytestream.h"
+#include "eventbus.h"
+#include "framearena.h"
+#include "histogram.h"
 #include "log.h"
 #include "perfcounter.h"
+#include "profiler.h"
 #include "settings.h"
 #include "sysutil.h"
+#include "threadpool.h"
 #include "timermanager.h"
 #include "window.h"
 
@@ -85,16 +94,21 @@
 #ifndef __ANDROID__
 #include "dds.h"
 #include "diamondsquaregenerator.h"
+#include "erosion.h"
+#include "fractalnoisegenerator.h"
 #include "heightmap.h"
 #include "heightmapgenerator.h"
 #include "mapgraph.h"
 #include "mapshape.h"
+#include "mappedfile.h"
 #include "model3.h"
 #include "modelconverter.h"
 #include "ms3dmodel.h"
 #include "octreenode.h"
 #endif
 #include "shape.h"
+#include "skeleton.h"
+#include "skinnedmesh.h"
 #include "string.h"
 #include "textureutil.h"
 #ifndef __ANDROID__
@@ -112,6 +126,9 @@
 #include "cameraeffect2.h"
 #ifndef __ANDROID__
 #include "clipmap.h"
+#include "clipmaplevel.h"
+#include "clipmapprefetcher.h"
+#include "clipmapstate.h"
 #endif
 #include "color.h"
 #include "debugeffect2.h"
@@ -138,6 +155,8 @@
 #include "orbitallight.h"
 #include "orbitcamera3.h"
 #include "particle.h"
+#include "particlecollider.h"
+#include "particledata.h"
 #include "particleemitter.h"
 #include "particlemanager.h"
 #include "renderer.h"
@@ -148,6 +167,9 @@
 #include "shadercache.h"
 #include "shaderprogram.h"
 #include "shadoweffect2.h"
+#ifndef __ANDROID__
+#include "softwareclipmap.h"
+#endif
 #include "sprite.h"
 #include "surface.h"
 #include "textmeshbuilder.h"
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include "mathutil.h"
+
+namespace dukat
+{
+	// Easing curves mapping normalized time [0..1] to progress [0..1].
+	enum class Easing : uint8_t
+	{
+		Linear,
+		Step,		// jumps to target at end of segment
+		QuadIn,
+		QuadOut,
+		QuadInOut,
+		CubicIn,
+		CubicOut,
+		CubicInOut,
+		SineInOut
+	};
+
+	inline float ease(Easing easing, float t)
+	{
+		switch (easing)
+		{
+		case Easing::Linear:
+			return t;
+		case Easing::Step:
+			return t < 1.0f ? 0.0f : 1.0f;
+		case Easing::QuadIn:
+			return t * t;
+		case Easing::QuadOut:
+			return t * (2.0f - t);
+		case Easing::QuadInOut:
+			return t < 0.5f ? 2.0f * t * t : -1.0f + (4.0f - 2.0f * t) * t;
+		case Easing::CubicIn:
+			return t * t * t;
+		case Easing::CubicOut:
+		{
+			const auto u = t - 1.0f;
+			return u * u * u + 1.0f;
+		}
+		case Easing::CubicInOut:
+		{
+			if (t < 0.5f)
+				return 4.0f * t * t * t;
+			const auto u = 2.0f * t - 2.0f;
+			return 0.5f * u * u * u + 1.0f;
+		}
+		case Easing::SineInOut:
+			return 0.5f - 0.5f * std::cos(t * pi);
+		default:
+			return t;
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "heightmap.h"
+
+namespace dukat
+{
+	// Hydraulic and thermal erosion filter for height map levels.
+	//
+	// Hydraulic erosion simulates water droplets that pick up and deposit sediment
+	// as they run downhill. The level is split into square tiles which are processed
+	// in four passes (2x2 checkerboard), so that tiles of a pass never touch each
+	// other and can run on different threads. Droplets may travel up to half a tile
+	// beyond the tile they were spawned in, and the tile grid is shifted between
+	// rounds to avoid seams.
+	//
+	// Thermal erosion moves material from cells whose slope to a neighbor exceeds
+	// the talus threshold. Each iteration reads from a copy of the level, so rows
+	// can be updated in parallel.
+	class Erosion
+	{
+	private:
+		int seed;
+		bool deterministic; // if set, output only depends on seed and parameters
+		int tile_size; // size of hydraulic erosion tiles
+		int rounds; // number of rounds with shifted tile grid
+
+		// Hydraulic erosion parameters
+		int droplets; // total number of droplets
+		int max_lifetime; // max steps per droplet
+		int radius; // erosion brush radius
+		float inertia; // [0..1] how much droplets keep their direction
+		float capacity; // sediment capacity factor
+		float min_capacity; // minimum sediment capacity
+		float erode_speed; // [0..1] fraction of free capacity to erode per step
+		float deposit_speed; // [0..1] fraction of excess sediment to deposit per step
+		float evaporate_speed; // [0..1] fraction of water evaporating per step
+		float gravity;
+
+		// Thermal erosion parameters
+		int thermal_iterations;
+		float talus; // max stable elevation difference between neighbors
+		float thermal_rate; // [0..1] fraction of excess material moved per iteration
+
+		// Runs all droplets of one tile.
+		void erode_tile(HeightMap::Level& level, uint32_t run_seed, int round, int tile_index, int num_droplets,
+			int min_x, int min_y, int max_x, int max_y) const;
+
+	public:
+		Erosion(int seed = 0);
+		~Erosion(void) { }
+
+		// Runs hydraulic erosion followed by thermal erosion.
+		void apply(HeightMap::Level& level) const;
+		// Runs hydraulic (droplet-based) erosion.
+		void hydraulic(HeightMap::Level& level) const;
+		// Runs thermal erosion.
+		void thermal(HeightMap::Level& level) const;
+
+		void set_deterministic(bool deterministic) { this->deterministic = deterministic; }
+		void set_tile_size(int tile_size) { this->tile_size = tile_size; }
+		void set_rounds(int rounds) { this->rounds = rounds; }
+		void set_droplets(int droplets) { this->droplets = droplets; }
+		void set_max_lifetime(int max_lifetime) { this->max_lifetime = max_lifetime; }
+		void set_radius(int radius) { this->radius = radius; }
+		void set_inertia(float inertia) { this->inertia = inertia; }
+		void set_capacity(float capacity, float min_capacity) { this->capacity = capacity; this->min_capacity = min_capacity; }
+		void set_erode_speed(float speed) { this->erode_speed = speed; }
+		void set_deposit_speed(float speed) { this->deposit_speed = speed; }
+		void set_evaporate_speed(float speed) { this->evaporate_speed = speed; }
+		void set_gravity(float gravity) { this->gravity = gravity; }
+		void set_thermal(int iterations, float talus, float rate) { this->thermal_iterations = iterations; this->talus = talus; this->thermal_rate = rate; }
+	};
+}
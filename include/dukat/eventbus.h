@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "framearena.h"
+#include "messenger.h"
+
+namespace dukat
+{
+	// Message queued on a messenger by an event bus.
+	struct PostedMessage
+	{
+		PostedMessage* next;
+		Messenger* target;
+		Message message;
+		uint32_t key;
+		uint64_t sequence;
+	};
+
+	// Queues messages for delivery at a defined point of the frame. Messages
+	// can be posted from any thread; each target messenger holds a lock-free
+	// multi-producer queue of the messages posted to it. drain() is called
+	// on the main thread and triggers all queued messages in one batch;
+	// GameBase drains its bus at the end of each update, after the scene and
+	// all managers have been updated.
+	//
+	// The batch is ordered by a key chosen by the poster and then by order of
+	// posting within a thread. Messages posted from the main thread with the
+	// default key are delivered in posting order. Workers should pass a key
+	// that identifies their work item, such as a job or entity index, so the
+	// order does not depend on thread scheduling.
+	//
+	// Payloads are copied into a frame arena and stay valid until their
+	// message has been delivered; destructors of payloads are not called.
+	// Messages to a messenger that is destroyed before delivery are dropped.
+	class EventBus
+	{
+	private:
+		// Posts are allocated from one arena while the other one is drained.
+		std::array<FrameArena, 2> arenas;
+		std::array<std::atomic<int>, 2> users;
+		std::atomic<int> active;
+
+		std::mutex mtx;
+		// Messengers with queued messages
+		std::vector<Messenger*> ready;
+		// Messengers and messages being delivered
+		std::vector<Messenger*> targets;
+		std::vector<PostedMessage*> batch;
+
+		// Returns index of arena to post to and marks it as in use.
+		int enter(void);
+		// Queues message on target and releases arena.
+		void push(int arena, Messenger* target, const Message& message, uint32_t key);
+
+	public:
+		EventBus(void);
+		~EventBus(void);
+
+		EventBus(const EventBus&) = delete;
+		EventBus& operator=(const EventBus&) = delete;
+
+		// Posts a message. Parameters are passed as is and have to remain
+		// valid until the message is delivered.
+		void post(Messenger* target, const Message& message, uint32_t key = 0)
+		{
+			push(enter(), target, message, key);
+		}
+
+		// Posts a message with a copy of payload as param1.
+		template<typename T>
+		void post(Messenger* target, Event ev, const T& payload, uint32_t key = 0)
+		{
+			const auto arena = enter();
+			auto copy = new (arenas[arena].allocate(sizeof(T))) T(payload);
+			push(arena, target, Message{ ev, copy }, key);
+		}
+
+		// Posts a message with param1 and a copy of payload as param2.
+		template<typename T>
+		void post(Messenger* target, Event ev, const void* param1, const T& payload, uint32_t key = 0)
+		{
+			const auto arena = enter();
+			auto copy = new (arenas[arena].allocate(sizeof(T))) T(payload);
+			push(arena, target, Message{ ev, param1, copy }, key);
+		}
+
+		// Delivers all messages posted so far. Messages posted while draining
+		// are delivered by the next call. Must be called on the main thread.
+		void drain(void);
+
+		// Drops messages queued for a messenger. Called when a messenger with
+		// queued messages is destroyed.
+		void detach(Messenger* target);
+	};
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "heightmapgenerator.h"
+
+namespace dukat
+{
+	// Fractal gradient noise terrain generator. Samples are a pure function of world
+	// position, so tiles generated at different times or levels of detail line up
+	// seamlessly and terrain can be generated without bounds. Rows are evaluated
+	// 8 samples at a time using AVX2 where available.
+	class FractalNoiseGenerator : public HeightMapGenerator
+	{
+	public:
+		enum Type
+		{
+			FBM, // fractional Brownian motion
+			Ridged, // ridged multifractal
+			Billow // absolute value of noise
+		};
+
+	private:
+		int seed;
+		Type type;
+		int octaves;
+		float frequency; // frequency of first octave in samples per world unit
+		float lacunarity; // frequency multiplier between octaves
+		float gain; // amplitude multiplier between octaves
+		float warp_strength; // domain warp displacement in world units
+		float warp_frequency; // frequency of domain warp noise
+		float min_val, max_val; // range of output values [0..1]
+
+		// Evaluates count samples of a row starting at (x, y) with sample spacing dx.
+		void sample_row(float x, float y, float dx, int count, float* out) const;
+		// Fills a level with samples starting at sample (x, y), spaced 2^lod world units apart.
+		void fill(HeightMap::Level& level, int x, int y, int lod) const;
+
+	public:
+		FractalNoiseGenerator(int seed = 0) : seed(seed), type(FBM), octaves(8), frequency(1.0f / 256.0f),
+			lacunarity(2.0f), gain(0.5f), warp_strength(0.0f), warp_frequency(1.0f / 512.0f),
+			min_val(0.0f), max_val(1.0f) { }
+		~FractalNoiseGenerator(void) { }
+
+		// Fills level with samples of the region [0..size) x [0..size).
+		void generate(HeightMap::Level& level) const;
+		// Fills a tile with samples starting at sample (x, y) of a given level of detail.
+		void generate_tile(HeightMap::Level& tile, int x, int y, int lod = 0) const;
+		bool is_unbounded(void) const { return true; }
+		void generate_rect(int level, const Rect& rect, std::vector<GLfloat>& buffer) const;
+		float sample(float x, float y) const;
+
+		void set_type(Type type) { this->type = type; }
+		void set_octaves(int octaves) { this->octaves = octaves; }
+		void set_frequency(float frequency) { this->frequency = frequency; }
+		void set_lacunarity(float lacunarity) { this->lacunarity = lacunarity; }
+		void set_gain(float gain) { this->gain = gain; }
+		void set_warp(float strength, float frequency) { this->warp_strength = strength; this->warp_frequency = frequency; }
+		void set_range(float min_val, float max_val) { this->min_val = min_val; this->max_val = max_val; }
+	};
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace dukat
+{
+	// Bump allocator for data that lives until the arena is reset, usually
+	// once per frame. Allocation is lock-free and may happen from any thread;
+	// a lock is only taken when another chunk of memory is needed. Chunks are
+	// kept across resets, so the arena stops allocating once it has grown to
+	// its steady-state size. Destructors of allocated objects are not called.
+	class FrameArena
+	{
+	private:
+		struct Chunk
+		{
+			Chunk* next;
+			std::size_t size;
+			std::atomic<std::size_t> used;
+			std::max_align_t* data;
+		};
+
+		const std::size_t chunk_size;
+		Chunk* first;
+		std::atomic<Chunk*> current;
+		std::mutex mtx;
+
+		// Moves on to the chunk after c, adding one of at least size bytes if needed.
+		void grow(Chunk* c, std::size_t size);
+
+	public:
+		FrameArena(std::size_t chunk_size = 64 * 1024);
+		~FrameArena(void);
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		// Returns storage for size bytes, aligned for any fundamental type.
+		void* allocate(std::size_t size);
+		// Releases all allocations. Must not be called while other threads allocate.
+		void reset(void);
+		// Returns number of bytes reserved by the arena.
+		std::size_t capacity(void) const;
+	};
+}
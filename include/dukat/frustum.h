@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "plane.h"
+#include "vector3.h"
+
+namespace dukat
+{
+	class AABB3;
+	class BoundingSphere;
+
+	// View frustum defined by 6 planes with normals pointing inwards.
+	//
+	// Bounding volumes are classified against all planes at once using AVX2
+	// where available. Classification takes a mask of planes to test and can
+	// return the mask of planes a volume straddles; children of a volume only
+	// need to be tested against the planes their parent straddles.
+	class Frustum
+	{
+	public:
+		enum PlaneIndex
+		{
+			Left,
+			Right,
+			Bottom,
+			Top,
+			Near,
+			Far,
+			NumPlanes
+		};
+
+		enum Result
+		{
+			Outside = -1, // completely outside of frustum
+			Intersect = 0, // straddles one or more planes
+			Inside = 1 // completely inside of frustum
+		};
+
+		// Mask with bits set for all planes.
+		static constexpr uint8_t all_planes = (1 << NumPlanes) - 1;
+
+	private:
+		std::array<Plane, NumPlanes> planes;
+		// Planes in SoA layout, padded to 8 lanes: n.x, n.y, n.z, |n.x|, |n.y|, |n.z|, d
+		std::array<float, 7 * 8> lanes;
+
+		void update_lanes(void);
+
+	public:
+		Frustum(void);
+		~Frustum(void) { }
+
+		// Computes planes from camera position, orthonormal direction and up vector,
+		// horizontal and vertical field of view in degrees and clip distances.
+		void setup(const Vector3& pos, const Vector3& dir, const Vector3& up,
+			float fov_h, float fov_v, float near_clip, float far_clip);
+		const Plane& get_plane(int index) const { return planes[index]; }
+
+		// Classifies a single bounding volume against the planes in in_mask.
+		// If out_mask is set, receives the planes the volume straddles.
+		Result classify(const AABB3& bb, uint8_t in_mask = all_planes, uint8_t* out_mask = nullptr) const;
+		Result classify(const Vector3& center, float radius, uint8_t in_mask = all_planes, uint8_t* out_mask = nullptr) const;
+
+		// Classifies count bounding volumes against the planes in in_mask and
+		// writes one Result per volume to results. If out_masks is set, receives
+		// the planes each volume straddles. Returns number of volumes not outside.
+		int classify(const AABB3* boxes, int count, int8_t* results,
+			uint8_t in_mask = all_planes, uint8_t* out_masks = nullptr) const;
+		int classify(const BoundingSphere* spheres, int count, int8_t* results,
+			uint8_t in_mask = all_planes, uint8_t* out_masks = nullptr) const;
+	};
+}
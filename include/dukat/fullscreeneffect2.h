@@ -1,11 +1,11 @@
 #pragma once
 
 #include "color.h"
+#include "delegate.h"
 
 namespace dukat
 {
 	class Game2;
-	class Animation;
 	class ShaderProgram;
 
     class FullscreenEffect2
@@ -15,7 +15,7 @@ namespace dukat
 		static constexpr auto default_fsh = "fx_default.fsh";
 
 		Game2* game;
-		Animation* anim;
+		uint32_t anim; // handle of fade animation
 		ShaderProgram* last_sp;
 		Color color; // target color
 		float alpha;
@@ -24,8 +24,8 @@ namespace dukat
 		FullscreenEffect2(Game2* game);
       	~FullscreenEffect2(void);
 
-		void fade_in(float duration, std::function<void(void)> callback = nullptr);
-		void fade_out(float duration, std::function<void(void)> callback = nullptr);
+		void fade_in(float duration, Delegate<void(void)> callback = nullptr);
+		void fade_out(float duration, Delegate<void(void)> callback = nullptr);
 		void set_color(Color color) { this->color = color; }
 		void set_composite_program(ShaderProgram* sp, std::function<void(ShaderProgram*)> composite_binder = nullptr);
 		void reset_composite_program(void);
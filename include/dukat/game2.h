@@ -15,6 +15,7 @@ namespace dukat
 		std::unique_ptr<Renderer2> renderer;
 		std::unique_ptr<FullscreenEffect2> effect;
 		virtual void update(float delta);
+		virtual void render(void);
 		void toggle_debug(void);
 
 	public:
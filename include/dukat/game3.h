@@ -13,6 +13,7 @@ namespace dukat
 		MeshGroup debug_meshes;
 
 		virtual void update(float delta);
+		virtual void render(void);
 		virtual void update_debug_text(void);
 		void toggle_debug(void);
 
@@ -9,6 +9,7 @@
 #endif
 #include "animationmanager.h"
 #include "application.h"
+#include "eventbus.h"
 #include "meshcache.h"
 #include "messenger.h"
 #include "textmeshinstance.h"
@@ -24,7 +25,9 @@ namespace dukat
 	class Controller;
 	class Manager;
 
-	// Abstract base class for game implementations.
+	// Abstract base class for game implementations. With "game.headless"
+	// set, scenes and managers run without window, rendering, audio or
+	// input, e.g. for simulation on a dedicated server.
 	class GameBase : public Application
 	{
 	protected:
@@ -34,6 +37,7 @@ namespace dukat
 		std::unique_ptr<ShaderCache> shader_cache;
 		std::unique_ptr<TextureCache> texture_cache;
 		std::unique_ptr<MeshCache> mesh_cache;
+		std::unique_ptr<EventBus> event_bus;
 		std::map<std::type_index, std::unique_ptr<Manager>> managers;
 		std::unordered_map<std::string, std::unique_ptr<Scene>> scenes;
 		std::stack<Scene*> scene_stack;
@@ -75,12 +79,15 @@ namespace dukat
 		template <typename T>
 		void remove_manager(void);
 
+		// Caches return nullptr in headless mode.
 #ifndef __ANDROID__
 		AudioCache* get_samples(void) const { return audio_cache.get(); }
 #endif
 		ShaderCache* get_shaders(void) const { return shader_cache.get(); }
 		TextureCache* get_textures(void) const { return texture_cache.get(); }
 		MeshCache* get_meshes(void) const { return mesh_cache.get(); }
+		// Messages posted to the bus are delivered at the end of update.
+		EventBus* get_events(void) const { return event_bus.get(); }
 	};
 
 	// Define template methods here:
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
 namespace dukat
@@ -7,6 +9,7 @@ namespace dukat
     struct Rect;
     class Surface;
 	class HeightMapGenerator;
+	class Erosion;
 	class Ray3;
 
     class HeightMap
@@ -32,23 +35,40 @@ namespace dukat
         int level_size; // width / height of each level
 		float scale_factor; // Scale factor used to compute grid height from normalized elevation data. 
         std::vector<Level> levels; // height level data
+		const HeightMapGenerator* source; // generates elevation data on demand if set
 
         // Generates levels 1..n based on level 0
         void generate_levels(void);
 
     public:
         HeightMap(int num_levels, float scale_factor = 1.0f) 
-            : num_levels(num_levels), level_size(0), scale_factor(scale_factor) { }
+            : num_levels(num_levels), level_size(0), scale_factor(scale_factor), source(nullptr) { }
         ~HeightMap(void) { }
 
 		// Loads height data from a 16-bit grayscale PNG file.
 		void load(const std::string& filename);
 		// Saves height data as 16-bit grayscale PNG file.
 		void save(const std::string& filename) const;
+		// Loads height data for all levels from a binary heightmap file. The file is 
+		// memory-mapped and validated; no decoding or level generation is performed.
+		// Throws if the file is invalid or was saved with a different source key,
+		// leaving current height data unchanged.
+		void load_binary(const std::string& filename, uint64_t source_key = 0);
+		// Saves height data for all levels as binary heightmap file. The source key
+		// identifies the data it was created from, e.g. a hash of source file and
+		// parameters, so that stale files can be detected when loading.
+		void save_binary(const std::string& filename, uint64_t source_key = 0) const;
+		// Converts a 16-bit grayscale PNG file into a binary heightmap file.
+		static void convert(const std::string& png_file, const std::string& binary_file, int num_levels);
         // Allocates a blank heightmap of a given size.
         void allocate(int level_size);
 		// Generates random fractal terrain.
 		void generate(int level_size, const HeightMapGenerator& generator);
+		// Runs erosion on level 0 and regenerates all other levels from it.
+		void erode(const Erosion& erosion);
+		// Makes this an unbounded height map that produces elevation data on demand. Any 
+		// stored levels are released. The generator must be unbounded and outlive this map.
+		void generate_unbounded(const HeightMapGenerator* generator);
 
         // Copies data at a given level within a rect into a provided buffer. If the
         // buffer is not large enough to contain the requested rect, partial data
@@ -56,6 +76,7 @@ namespace dukat
         void get_data(int level, const Rect& rect, std::vector<GLfloat>& buffer) const;
         // Returns reference to a level for direct access.
         Level& get_level(int level) { return levels[level]; }
+        const Level& get_level(int level) const { return levels[level]; }
 
 		// Returns the normalized elevation at a given set of coordinates and level.
 		float get_elevation(int x, int y, int level) const;
@@ -70,6 +91,8 @@ namespace dukat
 		float intersect_ray(const Ray3& ray, float min_t = 0.0f, float max_t = 1000.0f) const;
 
         // Getters and setters
+        int get_num_levels(void) const { return num_levels; }
+        int get_level_size(void) const { return level_size; }
         float get_scale_factor(void) const { return scale_factor; }
         void set_scale_factor(float factor) { this->scale_factor = factor; }
 	};
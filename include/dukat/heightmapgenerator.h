@@ -5,6 +5,8 @@
 
 namespace dukat
 {
+	struct Rect;
+
 	class HeightMapGenerator
 	{
 	public:
@@ -12,5 +14,14 @@ namespace dukat
 		virtual ~HeightMapGenerator(void) { }
 
 		virtual void generate(HeightMap::Level& level) const = 0;
+
+		// Returns true if this generator can produce samples at arbitrary coordinates, 
+		// allowing a HeightMap to generate unbounded terrain on demand.
+		virtual bool is_unbounded(void) const { return false; }
+		// Fills buffer with samples within rect at a given level of detail. Samples of 
+		// level n are spaced 2^n world units apart. Only supported by unbounded generators.
+		virtual void generate_rect(int, const Rect&, std::vector<GLfloat>&) const { }
+		// Returns a single sample at a world position. Only supported by unbounded generators.
+		virtual float sample(float, float) const { return 0.0f; }
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace dukat
+{
+	// Percentile summary of recorded values.
+	struct Percentiles
+	{
+		uint64_t count;
+		double mean;
+		double p50;
+		double p95;
+		double p99;
+		double max;
+	};
+
+	// Histogram of non-negative integer values with log-linear buckets in the
+	// style of HdrHistogram. Each power of two is split into 16 buckets and
+	// values are reported as the upper limit of their bucket, so they are at
+	// most 1/16 (6.25%) above their recorded value while the histogram uses a
+	// fixed amount of memory. Values up to 2^40 are tracked;
+	// larger values are counted in the highest bucket.
+	class Histogram
+	{
+	public:
+		static constexpr int sub_bucket_bits = 5;
+		static constexpr int max_value_bits = 40;
+
+	private:
+		std::vector<uint32_t> buckets;
+		uint64_t count;
+		uint64_t max_value;
+		double sum;
+
+	public:
+		Histogram(void);
+		~Histogram(void) { }
+
+		// Returns index of the bucket a value is counted in.
+		static int bucket_index(uint64_t value);
+		// Returns highest value counted in a bucket.
+		static uint64_t bucket_limit(int index);
+
+		void record(uint64_t value);
+		// Adds all values recorded in another histogram.
+		void merge(const Histogram& h);
+		void reset(void);
+
+		uint64_t get_count(void) const { return count; }
+		uint64_t get_max(void) const { return max_value; }
+		double get_mean(void) const { return count > 0 ? sum / static_cast<double>(count) : 0.0; }
+		// Returns value below or at which p percent of recorded values fall.
+		uint64_t percentile(double p) const;
+		// Returns p50, p95, p99 and max, multiplied by scale.
+		Percentiles summarize(double scale = 1.0) const;
+	};
+
+	// Histogram over a sliding window of recent values. The window is split
+	// into intervals; once the current interval is full, the oldest interval
+	// is discarded and reused.
+	class SlidingHistogram
+	{
+	public:
+		static constexpr int num_intervals = 4;
+
+	private:
+		std::array<Histogram, num_intervals> intervals;
+		int current;
+		int interval_size;
+		int interval_count;
+
+	public:
+		SlidingHistogram(int window_size = 600);
+		~SlidingHistogram(void) { }
+
+		// Sets number of values in the window and discards all values.
+		void set_window(int window_size);
+		void record(uint64_t value);
+		void reset(void);
+		// Returns histogram of all values in the window.
+		Histogram collect(void) const;
+	};
+}
@@ -3,6 +3,7 @@
 #include <array>
 #include <functional>
 #include <map>
+#include "delegate.h"
 
 namespace dukat
 {
@@ -35,7 +36,7 @@ namespace dukat
 		};
 
 	private:
-		static std::map<VirtualButton, std::function<void(void)>> handlers;
+		static std::array<Delegate<void(void)>, VirtualButton::_Count> handlers;
 		std::array<bool, VirtualButton::_Count> buttons;
 
 	protected:
@@ -66,7 +67,7 @@ namespace dukat
 		// Returns a unique ID for this device.
 		virtual int id(void) const = 0;
 		const std::string& get_name(void) const { return name; }
-		void on_press(VirtualButton button, std::function<void(void)> handler) { handlers[button] = handler; }
-		void unbind(VirtualButton button) { handlers.erase(button); }
+		void on_press(VirtualButton button, Delegate<void(void)> handler) { handlers[button] = std::move(handler); }
+		void unbind(VirtualButton button) { handlers[button] = nullptr; }
 	};
 }
\ No newline at end of file
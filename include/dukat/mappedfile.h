@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+namespace dukat
+{
+	// Read-only memory mapping of a file.
+	class MappedFile
+	{
+	private:
+		const uint8_t* data;
+		size_t size;
+#ifdef _WIN32
+		void* file_handle;
+		void* map_handle;
+#else
+		int fd;
+#endif
+
+	public:
+		MappedFile(void);
+		MappedFile(const std::string& filename);
+		~MappedFile(void) { close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Maps a file into memory. Will throw if the file cannot be mapped.
+		void open(const std::string& filename);
+		// Unmaps the file.
+		void close(void);
+
+		bool is_open(void) const { return data != nullptr; }
+		const uint8_t* get_data(void) const { return data; }
+		size_t get_size(void) const { return size; }
+	};
+}
@@ -6,6 +6,8 @@
 
 namespace dukat
 {
+    class AABB3;
+
     // Abstract base class for objects that can be rendered.
     class Mesh
     {
@@ -22,5 +24,8 @@ namespace dukat
         virtual void update(float delta) = 0;
         // Renders this mesh. 
         virtual void render(Renderer* renderer) = 0;
+        // Returns world-space bounds used for view frustum culling, or nullptr
+        // if this mesh should never be culled.
+        virtual const AABB3* get_world_bb(void) const { return nullptr; }
     };
 }
\ No newline at end of file
@@ -14,9 +14,10 @@ namespace dukat
 	{
 	private:
 		std::vector<std::unique_ptr<MeshInstance>> instances;
+		AABB3 world_bb; // bb transformed by model matrix
 
 	public:
-        AABB3 bb;
+        AABB3 bb; // bounds in model space; culling is disabled if empty
 
 		MeshGroup(void);
 		~MeshGroup(void) { }
@@ -29,6 +30,7 @@ namespace dukat
 		void clear(void) { instances.clear(); }
 
 		void update(float delta);
+		const AABB3* get_world_bb(void) const { return bb.empty() ? nullptr : &world_bb; }
 		// TODO: revisit - we may want to batch these calls
 		void render(Renderer* renderer);
 	};
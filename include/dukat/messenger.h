@@ -1,7 +1,8 @@
 #pragma once
 
-#include <unordered_map>
-#include <set>
+#include <array>
+#include <atomic>
+#include <vector>
 #include "recipient.h"
 
 namespace dukat
@@ -36,37 +37,72 @@ namespace dukat
 		static constexpr Event TransformChanged = 17;
 		static constexpr Event VisibilityChanged = 18;
 		static constexpr Event LayerChanged = 19;
+		// Collision events are posted to the game's event bus and delivered
+		// at the end of the frame. Bodies they refer to stay valid until
+		// then, even if destroyed in the meantime.
 		// Marks begin of a collision.
 		// param1: Body* that entity collided with.
-		// param2: Contact* contact of this collision.
+		// param2: Contact* copy of the contact of this collision.
 		static constexpr Event CollisionBegin = 20;
 		// Marks end of a collision.
 		// param1: Body* that entity collided with.
 		static constexpr Event CollisionEnd = 21;
 		// Indicates that a collision was resolved.
 		// param1: Vector2* direction of resolution.
-		static constexpr Event CollisionResolve = 22; 
+		static constexpr Event CollisionResolve = 22;
 		// Indicates that a collision body was created.
 		// param1: Body* collision body
 		static constexpr Event BodyCreated = 23;
 		// Indicates that a collision body was destroyed.
 		// param1: Body* collision body
 		static constexpr Event BodyDestroyed = 24;
-		// catch-all to allow subscription to all supported events
-		// TODO: review - I don't like the hard-coded max ID here
+		// catch-all to allow subscription to all supported events; event
+		// IDs have to be below this value
 		static constexpr Event Any = 64;
 	};
 
-	// Messenging class
+	class EventBus;
+	struct PostedMessage;
+
+	// Messenging class. Recipients of each event are stored in a table
+	// indexed by event and are called in order of subscription.
+	//
+	// Subscriptions may change while an event is dispatched. Recipients
+	// that unsubscribe are not called anymore, while recipients that
+	// subscribe are added once the outermost trigger returns.
 	class Messenger
 	{
 	private:
-		// Map of subscribers, indexed by event type
-		std::unordered_map<Event, std::set<Recipient*>> subscriptions;
+		friend class EventBus;
+
+		struct Pending
+		{
+			Recipient* recipient;
+			Event ev;
+		};
+
+		// Subscribers, indexed by event type. Removed subscribers are set
+		// to nullptr during dispatch.
+		std::array<std::vector<Recipient*>, Events::Any> subscriptions;
+		// Subscriptions added during dispatch
+		std::vector<Pending> pending;
+		// Depth of nested trigger calls
+		int dispatching;
+		bool dirty;
+
+		// Messages posted through an event bus, most recent first
+		std::atomic<PostedMessage*> inbox;
+		// Set while this messenger is on a bus's list of pending messengers
+		std::atomic<bool> scheduled;
+		// Bus with messages for this messenger
+		std::atomic<EventBus*> bus;
+
+		// Applies changes made during dispatch.
+		void flush(void);
 
 	public:
-		Messenger(void) { }
-		virtual ~Messenger(void) { }
+		Messenger(void) : dispatching(0), dirty(false), inbox(nullptr), scheduled(false), bus(nullptr) { }
+		virtual ~Messenger(void);
 
 		// Triggers an event for all recievers subscribed to this entity.
 		void trigger(const Message& message);
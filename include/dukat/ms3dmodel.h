@@ -9,8 +9,12 @@
 
 namespace dukat
 {
+	class AnimationClip;
 	class Model3;
-	
+	class Skeleton;
+	class SkinnedMesh;
+
+
 	class MS3DModel : public ModelConverter
 	{
 	private:
@@ -71,21 +75,23 @@ namespace dukat
 			char alphamap[128];
 		};
 
+		struct Keyframe
+		{
+			float time; // in seconds
+			float parameter[3]; // Euler angles or translation
+		};
+
 		struct Joint
 		{
 			uint8_t flags;
 			char name[32];
 			char parent_nname[32];
-			float rotation[3];
+			float rotation[3]; // Euler angles, in radians
 			float translation[3];
-			int16_t num_rotation_keyframes;
-			int16_t num_translation_keyframes;
-		};
-
-		struct Keyframe
-		{
-			float time;
-			float parameter[3]; // ?
+			uint16_t num_rotation_keyframes;
+			uint16_t num_translation_keyframes;
+			std::vector<Keyframe> rotation_keys;
+			std::vector<Keyframe> translation_keys;
 		};
 
 		Header header;
@@ -93,13 +99,26 @@ namespace dukat
 		std::vector<Triangle> triangles;
 		std::vector<Mesh> meshes;
 		std::vector<Material> materials;
+		float fps;
+		int32_t total_frames;
+		std::vector<Joint> joints;
 
 	public:
-		MS3DModel(void) { };
+		MS3DModel(void) : fps(0.0f), total_frames(0) { };
 		~MS3DModel(void) { };
 
 		// Creates a frontier model from this model.
 		std::unique_ptr<Model3> convert(void);
+		// Creates joint hierarchy in bind pose. The skeleton's root transform
+		// applies the same change of coordinate system as convert().
+		std::unique_ptr<Skeleton> create_skeleton(void) const;
+		// Creates clip holding the keyframes of all joints.
+		std::unique_ptr<AnimationClip> create_clip(void) const;
+		// Creates bind pose of a mesh for CPU skinning. Vertices are in the
+		// same order as the vertices of the converted model's mesh.
+		std::unique_ptr<SkinnedMesh> create_skinned_mesh(int mesh) const;
+		int get_mesh_count(void) const { return static_cast<int>(meshes.size()); }
+		int get_joint_count(void) const { return static_cast<int>(joints.size()); }
 		// Reads MS3D model from stream.
 		friend std::istream& operator>>(std::istream& is, MS3DModel& v);
 	};
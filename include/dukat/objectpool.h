@@ -1,6 +1,10 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
 
 namespace dukat
 {
@@ -10,38 +14,184 @@ namespace dukat
 		void init(T& t) { t.alive = true; }
 		bool is_alive(T& t) { return t.alive; }
 		void free(T& t) { t.alive = false; }
+		// Stores index of the slot holding an object.
+		void set_index(T& t, uint32_t index) { t.pool_index = index; }
+		uint32_t get_index(const T& t) const { return t.pool_index; }
 	};
 
-	// Simple object pool.
+	// Object pool with O(1) acquire and release. Objects live in chunks of N
+	// and never move, so pointers stay valid until an object is released.
+	// Free slots are linked in a free list; live slots are kept in a dense
+	// list so iteration only touches live objects.
+	//
+	// The allocator stores each object's slot index in the object, so the slot
+	// of an object can be found in O(1). Objects can also be referred to by 32-bit handles made up of the slot
+	// index and a generation that changes whenever the slot is released, so
+	// stale handles are detected. A growable pool adds another chunk once full.
 	template<class T, std::size_t N, class Allocator = ObjectAllocator<T> >
-	struct ObjectPool
+	class ObjectPool
 	{
-		std::array<T, N> data;
-		std::size_t free_index;
-		std::size_t capacity;
+	public:
+		typedef uint32_t Handle;
+		static constexpr Handle null_handle = 0u;
+
+	private:
+		static constexpr uint32_t index_bits = 20u;
+		static constexpr uint32_t index_mask = (1u << index_bits) - 1u;
+		static constexpr uint32_t generation_mask = (1u << (32u - index_bits)) - 1u;
+		static constexpr uint32_t no_slot = 0xffffffffu;
+
+		struct Slot
+		{
+			uint32_t generation;
+			uint32_t next_free; // next slot on free list
+			uint32_t live_pos; // position in live list, no_slot if free
+		};
+
+		std::vector<std::unique_ptr<std::array<T, N>>> chunks;
+		std::vector<Slot> slots;
+		std::vector<uint32_t> live;
+		std::vector<Handle> scratch;
+		uint32_t free_head;
+		bool growable;
 		Allocator alloc;
 
-		ObjectPool(void) : free_index(0u), capacity(N) { }
+		void grow(void)
+		{
+			const auto first = static_cast<uint32_t>(slots.size());
+			if (first + N > index_mask + 1u)
+				throw std::runtime_error("Exceeded maximum object pool size.");
+			chunks.emplace_back(new std::array<T, N>());
+			slots.resize(first + N);
+			for (auto i = first; i < first + N; i++)
+			{
+				slots[i].generation = 1u;
+				slots[i].next_free = (i + 1 < first + N) ? i + 1 : free_head;
+				slots[i].live_pos = no_slot;
+			}
+			free_head = first;
+		}
+
+		T& at(uint32_t index) const { return (*chunks[index / N])[index % N]; }
+
+		uint32_t index_of(const T* t) const
+		{
+			const auto index = alloc.get_index(*t);
+			// reject objects from other pools
+			if (index >= slots.size() || &at(index) != t)
+				return no_slot;
+			return index;
+		}
+
+		Handle make_handle(uint32_t index) const { return (slots[index].generation << index_bits) | index; }
+
+	public:
+		ObjectPool(bool growable = false) : free_head(no_slot), growable(growable) { grow(); }
 		~ObjectPool(void) { }
 
+		// Returns a free object or nullptr if the pool is full and cannot grow.
 		T* acquire(void)
 		{
-			while (free_index < N && capacity > 0u)
+			if (free_head == no_slot)
 			{
-				auto& e = data[free_index];
-				if (!alloc.is_alive(e))
-				{
-					alloc.init(e);
-					capacity--;
-					return &e;
-				}
-				free_index++;
+				if (!growable)
+					return nullptr;
+				grow();
 			}
-			return nullptr;
+			const auto index = free_head;
+			auto& slot = slots[index];
+			free_head = slot.next_free;
+			slot.live_pos = static_cast<uint32_t>(live.size());
+			live.push_back(index);
+			auto& t = at(index);
+			alloc.init(t);
+			alloc.set_index(t, index);
+			return &t;
 		}
 
+		// Returns an object to the pool. Releasing a dead object has no effect.
 		void release(T* t) { release(*t); }
-		void release(T& t) { alloc.free(t); capacity++; }
-		void clear(void) { std::for_each(data.begin(), data.end(), [&](T& t) { alloc.free(t); }); free_index = 0u; capacity = N; }
+		void release(T& t)
+		{
+			if (!alloc.is_alive(t))
+				return;
+			const auto index = index_of(&t);
+			if (index == no_slot)
+				return;
+			alloc.free(t);
+
+			// swap-remove from live list
+			auto& slot = slots[index];
+			const auto last = live.back();
+			live[slot.live_pos] = last;
+			slots[last].live_pos = slot.live_pos;
+			live.pop_back();
+
+			slot.live_pos = no_slot;
+			slot.generation = (slot.generation + 1u) & generation_mask;
+			if (slot.generation == 0u) // keep null_handle invalid
+				slot.generation = 1u;
+			slot.next_free = free_head;
+			free_head = index;
+		}
+		void release(Handle h)
+		{
+			auto t = get(h);
+			if (t != nullptr)
+				release(*t);
+		}
+
+		// Returns handle of a live object or null_handle.
+		Handle handle(const T* t) const
+		{
+			const auto index = index_of(t);
+			if (index == no_slot || slots[index].live_pos == no_slot)
+				return null_handle;
+			return make_handle(index);
+		}
+		// Returns object a handle refers to, or nullptr if it has been released since.
+		T* get(Handle h) const
+		{
+			const auto index = h & index_mask;
+			if (index >= slots.size())
+				return nullptr;
+			const auto& slot = slots[index];
+			if (slot.live_pos == no_slot || slot.generation != (h >> index_bits))
+				return nullptr;
+			return &at(index);
+		}
+
+		// Calls fn for each live object. Objects released during iteration are
+		// skipped, objects acquired during iteration are not visited. Calls must
+		// not be nested.
+		template<typename Fn>
+		void for_each(Fn fn)
+		{
+			scratch.resize(live.size());
+			for (std::size_t i = 0; i < live.size(); i++)
+			{
+				scratch[i] = make_handle(live[i]);
+			}
+			for (auto h : scratch)
+			{
+				auto t = get(h);
+				if (t != nullptr)
+					fn(*t);
+			}
+		}
+
+		void clear(void)
+		{
+			while (!live.empty())
+			{
+				release(at(live.back()));
+			}
+		}
+
+		// Returns number of live objects.
+		std::size_t size(void) const { return live.size(); }
+		// Returns number of objects allocated.
+		std::size_t capacity(void) const { return slots.size(); }
+		bool full(void) const { return free_head == no_slot && !growable; }
 	};
-}
\ No newline at end of file
+}
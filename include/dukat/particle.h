@@ -5,6 +5,8 @@
 
 namespace dukat
 {
+	// Particle attributes. Particles are stored by ParticleManager in
+	// structure-of-arrays form; this struct is used to spawn and inspect them.
 	struct Particle
 	{
 		enum Flags
@@ -14,6 +16,7 @@ namespace dukat
 			Linear = 4,			// Update position based on dp
 			Dampened = 8,		// Update dp based on dampening constant until it reaches 0.
 			Gravitational = 16,	// Update dp based on gravity constant
+			Colliding = 32,		// Test against ParticleCollider, if one is set
 		};
 
 		Vector2 pos;	// Position in world space
@@ -26,6 +29,6 @@ namespace dukat
 		float ry;		// Axis of reflection
 		uint8_t	flags;	// Flags
 
-		Particle() : pos(), ry(0.0f), color(), size(1.0f), dp(), dc(), dsize(0.0f), ttl(0.0f), flags(0x4) { }	
+		Particle() : pos(), dp(), color(), dc(), size(1.0f), dsize(0.0f), ttl(0.0f), ry(0.0f), flags(Alive | Linear) { }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include "vector2.h"
+
+namespace dukat
+{
+	class CollisionManager2;
+	class HeightMap;
+	class ParticleData;
+
+	// Collision stage for particles flagged as Particle::Colliding. Particles
+	// are tested against a snapshot of static collision bodies and against a
+	// terrain profile taken from a height map.
+	//
+	// Bodies are binned into a uniform grid with the boxes of each cell stored
+	// in SoA blocks of 8, so a particle is tested against 8 boxes at once.
+	// Terrain tests run 8 particles at once. Only particles that hit anything
+	// are resolved individually.
+	class ParticleCollider
+	{
+	public:
+		enum Response
+		{
+			Bounce, // reflect velocity off the surface
+			Stick,	// stop at the surface and stay there
+			Kill	// expire the particle
+		};
+
+	private:
+		// Body grid
+		Vector2 grid_origin;
+		float cell_size;
+		float inv_cell_size;
+		int grid_width;
+		int grid_height;
+		// Offsets of each cell into the box arrays; cell c spans [cell_start[c], cell_start[c+1]).
+		std::vector<int> cell_start;
+		std::vector<float> box_min_x, box_min_y, box_max_x, box_max_y;
+
+		// Terrain profile: surface y at x = terrain_origin.x + i * terrain_spacing
+		std::vector<float> ground;
+		Vector2 terrain_origin;
+		float terrain_spacing;
+
+		Response response;
+		// Fraction of velocity kept along the surface normal when bouncing
+		float restitution;
+		// Fraction of velocity kept along the surface when bouncing
+		float friction;
+
+		void resolve(ParticleData& data, int index, const Vector2& surface, const Vector2& normal) const;
+		void resolve_box(ParticleData& data, int index, int box) const;
+		void resolve_terrain(ParticleData& data, int index) const;
+		// Returns index of first box containing p or -1.
+		int find_box(float px, float py) const;
+		int collide_terrain(ParticleData& data, int begin, int end) const;
+
+	public:
+		// Cells of the body grid will be at least cell_size wide.
+		ParticleCollider(float cell_size = 64.0f);
+		~ParticleCollider(void) { }
+
+		// Takes a snapshot of the static bodies of a collision manager. Bodies
+		// changed afterwards are not seen until the next snapshot.
+		void snapshot(const CollisionManager2& cm);
+		// Uses a row of a height map level as terrain profile. Sample i is placed
+		// at origin.x + i * spacing; an elevation of e puts the surface at
+		// origin.y - e * height.
+		void set_terrain(const HeightMap& hm, int level, int row, const Vector2& origin, float spacing, float height);
+		// Removes bodies and terrain.
+		void clear(void);
+
+		void set_response(Response response, float restitution = 0.5f, float friction = 0.8f);
+		Response get_response(void) const { return response; }
+
+		// Tests particles in [begin, end) and applies the collision response.
+		// Returns number of collisions.
+		int collide(ParticleData& data, int begin, int end) const;
+	};
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "particle.h"
+
+namespace dukat
+{
+	// Structure-of-arrays storage for particles. Live particles are kept
+	// compacted in [0, get_count()), so updates only touch live particles.
+	//
+	// Each particle stores the index of the layer it is rendered on. Particles
+	// are grouped by layer index, so every layer owns a contiguous range that
+	// it can render with a linear walk. Expired particles are swap-removed
+	// within their range and ranges are moved down to close gaps.
+	//
+	// Storage grows in chunks of chunk_size particles as needed. An optional
+	// budget limits the number of particles; particles added beyond the budget
+	// are dropped and counted as overflow.
+	class ParticleData
+	{
+	private:
+		int count;
+		int capacity;
+		int budget;
+		int overflow;
+		// End of the range of each layer index; a range starts where the
+		// previous one ends.
+		std::vector<int> layer_end;
+
+		// Adds another chunk of storage. Returns false if at budget.
+		bool grow(void);
+		// Copies particle at index from to index to.
+		void move(int from, int to);
+		// Opens n slots at the end of a layer's range by shifting later ranges.
+		// Returns index of the first slot.
+		int insert(int layer_index, int n);
+
+	public:
+		// Number of particles processed per SIMD step.
+		static constexpr int block_size = 8;
+		// Number of particles storage grows by.
+		static constexpr int chunk_size = 4096;
+
+		// Range of particle indices [begin, end).
+		struct Range
+		{
+			int begin;
+			int end;
+
+			int size(void) const { return end - begin; }
+		};
+
+		std::vector<float> px, py; // position
+		std::vector<float> dx, dy; // change in position / velocity per second
+		std::vector<float> cr, cg, cb, ca; // color
+		std::vector<float> dr, dg, db, da; // change in color per second
+		std::vector<float> size, dsize; // size and change in size per second
+		std::vector<float> ttl; // time-to-live
+		std::vector<float> ry; // axis of reflection
+		std::vector<uint8_t> flags; // Particle::Flags
+		std::vector<uint16_t> layer; // index of layer the particle is rendered on
+
+		// Creates storage limited to budget particles, or unbounded if budget is 0.
+		ParticleData(int budget = 0);
+		~ParticleData(void) { }
+
+		int get_count(void) const { return count; }
+		// Returns number of particles storage is currently allocated for.
+		int get_capacity(void) const { return capacity; }
+		int get_budget(void) const { return budget; }
+		// Sets maximum number of particles, 0 for unbounded. Does not remove
+		// particles if count already exceeds the new budget.
+		void set_budget(int budget) { this->budget = budget; }
+		bool full(void) const { return budget > 0 && count >= budget; }
+		// Returns number of particles dropped because budget was exhausted.
+		int get_overflow(void) const { return overflow; }
+		void reset_overflow(void) { overflow = 0; }
+
+		// Adds a particle to the range of a layer. Returns index of the particle
+		// or -1 if at budget. Moves up to one particle per later layer range.
+		int add(const Particle& p, int layer_index);
+		// Adds n uninitialized particles to the range of a layer and returns
+		// their indices. The range is smaller than n if the budget is exhausted.
+		Range spawn(int layer_index, int n);
+		// Adds all particles of another storage to their layer ranges, subject
+		// to budget. Returns number of particles added.
+		int append(const ParticleData& src);
+		// Returns a copy of the particle at index.
+		Particle get(int index) const;
+		// Removes all particles.
+		void clear(void);
+
+		// Returns range [begin, end) of particles on a layer.
+		int get_layer_begin(int layer_index) const
+		{
+			if (layer_index <= 0)
+				return 0;
+			return layer_index <= static_cast<int>(layer_end.size()) ? layer_end[layer_index - 1] : count;
+		}
+		int get_layer_end(int layer_index) const
+		{
+			return layer_index < static_cast<int>(layer_end.size()) ? layer_end[layer_index] : count;
+		}
+
+		// Removes particles whose time-to-live has expired, then integrates
+		// the remaining particles. Uses AVX2 where available.
+		void update(float delta, float gravity, float dampening);
+		// Removes particles whose time-to-live has expired.
+		void compact(void);
+		// Integrates particles in [begin, end). Runs 8 particles per step with
+		// behavior flags applied as lane masks.
+		void integrate(int begin, int end, float delta, float gravity, float dampening);
+	};
+}
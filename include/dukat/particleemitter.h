@@ -2,12 +2,14 @@
 
 #include <array>
 #include "color.h"
+#include "delegate.h"
 #include "vector2.h"
 #include "particle.h"
+#include "rand.h"
 
 namespace dukat
 {
-    class ParticleManager;
+    class ParticleData;
     class RenderLayer2;
 
     // Abstract particle emitter base class.
@@ -29,6 +31,8 @@ namespace dukat
 				Radial,
 				Layered
 			};
+			// Number of recipe types
+			static constexpr int num_types = Layered + 1;
 
 			Type type;
 			// Flags of particles to create.
@@ -68,8 +72,12 @@ namespace dukat
 
 		// Particle recipe
         Recipe recipe;
-		// Update function (called once per frame)
-		std::function<void(ParticleManager& pm, ParticleEmitter& em, float delta)> update;
+		// Update function for custom emitters of type None (called once per frame).
+		// Built-in recipe types are updated by update_emitter_group instead. Custom
+		// emitters are updated one after another on the thread that updates the
+		// particle manager, so they may access game state and create or remove
+		// emitters; new particles are added to out.
+		Delegate<void(ParticleData& out, ParticleEmitter& em, float delta)> update;
 		// Emitter world pos
         Vector2 pos;
 		// Offsets at which to emit particles
@@ -86,16 +94,25 @@ namespace dukat
         float accumulator;
 		// Generic value holder - can be used by update function
 		float value;
+		// Random generator used by update function; seeded by particle manager
+		Random rng;
 		// Will only generate particles if active
 		bool active;
 		// Used by object pool
 		bool alive;
+		uint32_t pool_index;
 
         ParticleEmitter(void) : update(nullptr), mirror_offset(0.0f), target_layer(nullptr), ttl(0.0f), 
-			age(0.0f), accumulator(0.0f), value(0.0f), active(true), alive(false) { }
+			age(0.0f), accumulator(0.0f), value(0.0f), active(true), alive(false), pool_index(0u) { }
         ~ParticleEmitter(void) { }
     };
 
 	// Factory method for particle emitters.
 	void init_emitter(ParticleEmitter& emitter, const ParticleEmitter::Recipe& recipe);
+	// Updates count emitters that share a built-in recipe type and spawns their
+	// particles into out. Each type runs its own loop specialized at compile time,
+	// drawing random attributes in batches per emitter. Can be called from any
+	// thread; custom emitters are skipped.
+	void update_emitter_group(ParticleEmitter::Recipe::Type type, ParticleEmitter* const* emitters, int count,
+		ParticleData& out, float delta);
 }
\ No newline at end of file
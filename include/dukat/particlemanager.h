@@ -1,72 +1,114 @@
 #pragma once
 
-#include <deque>
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
-#include "objectpool.h"
 #include "particle.h"
+#include "particledata.h"
 #include "particleemitter.h"
 #include "manager.h"
+#include "objectpool.h"
 
 namespace dukat
 {
+	class ParticleCollider;
+
 	// Manager in charge of all particles on screen. 
 	class ParticleManager : public Manager
 	{
 	private:
-		struct ParticleAllocator 
+		// Particle storage
+		ParticleData particles;
+		// Number of emitters storage grows by.
+		static constexpr std::size_t emitter_chunk_size = 64;
+		// Emitter storage; grows as needed, dead emitters are reused.
+		ObjectPool<ParticleEmitter, emitter_chunk_size> emitters;
+		// Maximum number of live emitters, 0 for unbounded
+		int emitter_budget;
+		// Seed and number of emitters created with it; emitter generators are
+		// derived from both so results do not depend on thread count.
+		uint64_t seed;
+		uint32_t emitter_serial;
+		// Number of layer indices handed out
+		int layer_count;
+		// Live emitters grouped by recipe type
+		std::array<std::vector<ParticleEmitter*>, ParticleEmitter::Recipe::num_types> emitter_groups;
+		// Set if emitters were added or removed since groups were built
+		bool groups_dirty;
+		// Fixed ranges of a group updated by one job
+		struct EmitterJob
 		{
-			void init(Particle& p) 
-			{ 
-				p.flags = Particle::Alive | Particle::Linear; 
-				p.dp.x = p.dp.y = p.dc.r = p.dc.g = p.dc.b = p.dc.a = p.dsize = 0.0f; 
-			}
-			bool is_alive(Particle& p) { return (p.flags & Particle::Alive) == Particle::Alive; }
-			void free(Particle& p) { p.flags = 0; }
+			ParticleEmitter::Recipe::Type type;
+			int begin;
+			int end;
 		};
+		std::vector<EmitterJob> emitter_jobs;
+		// Particles spawned by each job of emitters, merged in job order.
+		std::vector<ParticleData> spawn_buffers;
+		// Particles spawned by custom emitters, merged first.
+		ParticleData custom_buffer;
 
-		struct ParticleEmitterAllocator
-		{
-			void init(ParticleEmitter& em) 
-			{ 
-				em.active = em.alive = true; 
-				em.accumulator = em.age = em.mirror_offset = em.ttl = em.value = 0.0f;
-				em.offsets.clear();
-				em.target_layer = nullptr;
-				em.update = nullptr;
-			}
-			bool is_alive(ParticleEmitter& em) { return em.alive; }
-			void free(ParticleEmitter& em) { em.alive = false; }
-		};
+		// Number of emitters updated per job.
+		static constexpr int emitters_per_job = 8;
+		// Number of particles integrated per job.
+		static constexpr int particles_per_job = 8192;
 
-		// Global limit to number of particles.
-		static constexpr auto max_particles = 4096;
-		static constexpr auto max_emitters = 512;
-		// Particle pool
-		ObjectPool<Particle, max_particles, ParticleAllocator> particles;
-		// Emitter pool
-		ObjectPool<ParticleEmitter, max_emitters, ParticleEmitterAllocator> emitters;
+		void update_emitters(float delta);
+		// Runs update functions of custom emitters on the calling thread.
+		void update_custom_emitters(float delta);
+		// Rebuilds emitter groups and jobs.
+		void build_emitter_jobs(void);
+		// Connects a layer to particle storage and assigns it an index on first use.
+		int attach_layer(RenderLayer2* layer);
 
 		// Gravitational constant applied to particles' vertical motion.
 		float gravity;
 		// Dampening factor.
 		float dampening;
+		// Optional collision stage run after integration; not owned.
+		const ParticleCollider* collider;
 
 	public:
-		ParticleManager(GameBase* game) : Manager(game), gravity(25.0f), dampening(0.99f) { }
+		ParticleManager(GameBase* game) : Manager(game), emitters(true), emitter_budget(0),
+			seed(0u), emitter_serial(0u), layer_count(0), groups_dirty(false), gravity(25.0f), dampening(0.99f), collider(nullptr) { }
 		~ParticleManager(void) { }
 
 		void set_gravity(float gravity) { this->gravity = gravity; }
 		void set_dampening(float dampening) { this->dampening = dampening; }
+		// Sets collider for particles flagged as Particle::Colliding, or nullptr
+		// to disable collisions. Collider must outlive its use by this manager.
+		void set_collider(const ParticleCollider* collider) { this->collider = collider; }
+		// Sets seed for emitters created from now on.
+		void set_seed(uint64_t seed) { this->seed = seed; emitter_serial = 0u; }
 
-		// Updates all particles position in space.
+		// Updates emitters and integrates particles. Work is spread across the
+		// shared thread pool in fixed-size jobs; for a given seed the result is
+		// the same regardless of the number of threads.
 		void update(float delta);
-		// Creates a new particle. May return null if pool is at capacity.
-		Particle* create_particle(void) { return particles.acquire(); }
-		// Creates a new particle emitter from a recipe. May return null if pool is at capacity.
+		// Adds a new particle to be rendered on a layer. Returns false if particle budget is exhausted.
+		bool add_particle(const Particle& p, RenderLayer2* layer);
+		// Returns particle storage.
+		const ParticleData& get_particles(void) const { return particles; }
+		// Limits number of particles, 0 for unbounded.
+		void set_particle_budget(int budget) { particles.set_budget(budget); }
+		int get_particle_capacity(void) const { return particles.get_capacity(); }
+		// Returns number of particles dropped because the budget was exhausted.
+		int get_particle_overflow(void) const { return particles.get_overflow(); }
+		// Limits number of live emitters, 0 for unbounded.
+		void set_emitter_budget(int budget) { emitter_budget = budget; }
+		int get_emitter_count(void) const { return static_cast<int>(emitters.size()); }
+		int get_emitter_capacity(void) const { return static_cast<int>(emitters.capacity()); }
+		// Creates a new particle emitter from a recipe. May return null if emitter budget is exhausted.
 		ParticleEmitter* create_emitter(const ParticleEmitter::Recipe& recipe);
 		// Frees up a particle emitter.
 		void remove_emitter(ParticleEmitter* emitter);
+		// Returns a handle for a live emitter. Unlike a pointer, a handle can be
+		// checked after the emitter has been removed.
+		uint32_t get_emitter_handle(const ParticleEmitter* emitter) const { return emitters.handle(emitter); }
+		// Returns emitter a handle refers to, or nullptr if it is no longer live.
+		ParticleEmitter* get_emitter(uint32_t handle) const { return emitters.get(handle); }
 		// Removes all particles and emitters
 		void clear(void);
 	};
@@ -1,20 +1,91 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "histogram.h"
+
 namespace dukat
 {
 	// Simple performance counter to collect engine metrics.
+	//
+	// Counters can be changed from any thread. Each thread writes to its own
+	// shard of counters, which are merged into the frame totals by reset() at
+	// the end of each frame. Frame times and selected counters are recorded
+	// in histograms covering a sliding window of recent frames.
 	class PerformanceCounter
 	{
-	private:
+	public:
 		static const int max_counters = 256;
+
+		// Distribution of a counter's per-frame values.
+		struct CounterStats
+		{
+			int counter;
+			double mean; // last average
+			Percentiles values; // over sliding window
+		};
+
+		// Statistics for telemetry.
+		struct Snapshot
+		{
+			uint64_t frames; // frames since start
+			Percentiles frame_time; // milliseconds, over sliding window
+			std::vector<CounterStats> counters; // tracked counters
+		};
+
+	private:
+		struct Shard
+		{
+			std::thread::id thread;
+			// running totals; only written by owning thread
+			std::array<std::atomic<long>, max_counters> values;
+			// totals at last merge
+			std::array<long, max_counters> merged;
+		};
+
+		// distinguishes instances in the thread-local shard cache
+		const int id;
+		std::mutex mtx;
+		std::vector<std::unique_ptr<Shard>> shards;
 		// current counters
 		long counters[max_counters];
 		// accumulator
 		long sums[max_counters];
 		// last average
-		long averages[max_counters];
+		double averages[max_counters];
 		// number of samples collected
 		long samples;
+		// number of frames since start
+		uint64_t frames;
+		// end of last frame
+		std::chrono::steady_clock::time_point last_reset;
+		// frame times in microseconds
+		SlidingHistogram frame_times;
+		// per-frame values of tracked counters
+		std::array<std::unique_ptr<SlidingHistogram>, max_counters> histograms;
+		int window_size;
+
+		Shard* create_shard(void);
+		// Returns shard of the calling thread.
+		Shard* get_shard(void)
+		{
+			static thread_local int cached_id = -1;
+			static thread_local Shard* cached_shard = nullptr;
+			if (cached_id != id)
+			{
+				cached_shard = create_shard();
+				cached_id = id;
+			}
+			return cached_shard;
+		}
+		// Adds changes made to shards since last merge to current counters.
+		void merge(void);
 
 	public:
 		// Well-known counters
@@ -46,17 +117,34 @@ namespace dukat
 		PerformanceCounter(void);
 		~PerformanceCounter(void);
 
+		// Ends the current frame. Must be called on the main thread.
 		void reset(void);
-		// collects average values for all counters
+		// collects average values for all counters over frames since last call
 		void collect_stats(void);
 
-		void set(int counter, long value) { counters[counter] = value; }
-		long get(int counter) const { return counters[counter]; }
-		void inc(int counter, int val = 1) { counters[counter] += val; }
-		void dec(int counter, int val = 1) { counters[counter] += val; }
-		long sum(int counter) { return sums[counter]; }
-		long avg(int counter) { return averages[counter]; }
+		// Sets current value of a counter, discarding changes made so far this frame.
+		void set(int counter, long value);
+		// Returns current value of a counter.
+		long get(int counter);
+		void inc(int counter, long val = 1)
+		{
+			auto& v = get_shard()->values[counter];
+			v.store(v.load(std::memory_order_relaxed) + val, std::memory_order_relaxed);
+		}
+		void dec(int counter, long val = 1) { inc(counter, -val); }
+		// Returns total of a counter over frames since last collect_stats().
+		long sum(int counter);
+		// Returns average of a counter as of last collect_stats().
+		long avg(int counter) { return static_cast<long>(std::round(mean(counter))); }
+		double mean(int counter);
+
+		// Records per-frame values of a counter in a histogram.
+		void track(int counter);
+		// Sets number of frames covered by histograms and discards their values.
+		void set_window(int frames);
+		// Returns frame time and tracked counter percentiles. Can be called from any thread.
+		Snapshot snapshot(void);
 	};
 
 	extern PerformanceCounter perfc;
-}
\ No newline at end of file
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Instrumentation macros. Zones are only recorded if the library and
+// application are built with DUKAT_PROFILE defined; otherwise the macros
+// expand to nothing.
+//
+// PROFILE_SCOPE(name) - records time spent until the end of the enclosing
+//		scope. name has to be a string literal or otherwise outlive the profiler.
+// PROFILE_FRAME() - marks the end of a frame.
+#ifdef DUKAT_PROFILE
+#define DUKAT_PROFILE_CONCAT_(a, b) a##b
+#define DUKAT_PROFILE_CONCAT(a, b) DUKAT_PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ::dukat::ProfileScope DUKAT_PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_FRAME() ::dukat::Profiler::get().frame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FRAME()
+#endif
+
+#ifdef DUKAT_PROFILE
+namespace dukat
+{
+	// Collects timed zones from all threads. Each thread writes completed
+	// zones to its own ring buffer without locking; once full, the oldest
+	// zones are overwritten. Buffers can be read while threads are running;
+	// zones that are overwritten while being read are skipped.
+	class Profiler
+	{
+	public:
+		struct Zone
+		{
+			const char* name;
+			uint64_t begin; // nanoseconds since profiler start
+			uint64_t end;
+		};
+
+		// Zone statistics aggregated by name.
+		struct Summary
+		{
+			const char* name;
+			int count;
+			double total_ms;
+			double max_ms;
+		};
+
+		// Number of zones kept per thread
+		static constexpr uint32_t buffer_size = 1u << 16;
+		// Number of frame markers kept
+		static constexpr uint32_t frame_buffer_size = 1u << 12;
+
+	private:
+		// Ring buffer entry. sequence is odd while the slot is being written
+		// and 2 * (i + 1) once zone i has been stored.
+		struct Slot
+		{
+			std::atomic<uint64_t> sequence;
+			std::atomic<const char*> name;
+			std::atomic<uint64_t> begin;
+			std::atomic<uint64_t> end;
+		};
+
+		struct ThreadBuffer
+		{
+			int tid;
+			std::string thread_name;
+			std::unique_ptr<Slot[]> slots;
+			// Number of zones written so far; zone i is stored at i % buffer_size.
+			std::atomic<uint64_t> written;
+		};
+
+		const std::chrono::steady_clock::time_point start;
+		std::mutex mtx;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		// Times of frame markers; written by main thread only
+		std::unique_ptr<std::atomic<uint64_t>[]> frames;
+		std::atomic<uint64_t> frame_count;
+		// Zones and frames starting before this time have been cleared
+		std::atomic<uint64_t> epoch;
+
+		Profiler(void);
+		ThreadBuffer* create_buffer(void);
+		ThreadBuffer* thread_buffer(void);
+		// Copies completed zones of a buffer that have not been overwritten while reading.
+		void copy_zones(const ThreadBuffer& buffer, std::vector<Zone>& out) const;
+
+	public:
+		~Profiler(void) { }
+
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+
+		static Profiler& get(void);
+
+		// Returns nanoseconds since profiler start.
+		uint64_t now(void) const;
+		// Records a zone on the calling thread.
+		void record(const char* name, uint64_t begin, uint64_t end);
+		// Marks the end of the current frame.
+		void frame(void);
+		// Names the calling thread in exported traces.
+		void set_thread_name(const std::string& name);
+
+		// Returns number of frames marked so far.
+		uint64_t get_frame_count(void) const { return frame_count.load(); }
+		// Aggregates zones of all threads over the last frames, sorted by
+		// total time. Passing 0 frames includes all buffered zones.
+		std::vector<Summary> summarize(int last_frames = 0);
+		// Writes all buffered zones and frame markers in Chrome trace event
+		// format, which can be loaded with chrome://tracing or Perfetto.
+		void write_trace(std::ostream& os);
+		void save_trace(const std::string& filename);
+		// Discards all recorded zones and frames.
+		void clear(void);
+	};
+
+	// Records a zone from construction to destruction.
+	class ProfileScope
+	{
+	private:
+		const char* name;
+		uint64_t begin;
+
+	public:
+		ProfileScope(const char* name) : name(name), begin(Profiler::get().now()) { }
+		~ProfileScope(void) { Profiler::get().record(name, begin, Profiler::get().now()); }
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	};
+}
+#endif
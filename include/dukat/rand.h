@@ -1,19 +1,112 @@
 #pragma once
 
-#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
 
 namespace dukat
 {
+	// xoshiro128+ pseudo random number generator. Small, fast and seedable; every
+	// instance is an independent stream, so subsystems can own their own generator
+	// instead of sharing global state.
+	class Random
+	{
+	private:
+		uint32_t s[4];
+
+		static inline uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+	public:
+		Random(uint64_t seed = 0u) { this->seed(seed); }
+		// Creates generator for one of several non-overlapping streams sharing a seed.
+		Random(uint64_t seed, uint32_t stream);
+
+		// Resets state from a 64-bit seed.
+		void seed(uint64_t seed);
+		// Advances state by 2^64 steps. Used to create non-overlapping streams.
+		void jump(void);
+
+		// Returns next 32-bit random value.
+		inline uint32_t next(void)
+		{
+			const auto res = s[0] + s[3];
+			const auto t = s[1] << 9;
+			s[2] ^= s[0];
+			s[3] ^= s[1];
+			s[1] ^= s[2];
+			s[0] ^= s[3];
+			s[2] ^= t;
+			s[3] = rotl(s[3], 11);
+			return res;
+		}
+
+		// Returns a random number in [0..1).
+		inline float next_float(void) { return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f); }
+		// Returns a random number in [min..max).
+		inline float range(float min, float max) { return min + (max - min) * next_float(); }
+		// Returns a random integer in [min..max).
+		inline int range(int min, int max)
+		{
+			if (max <= min) // protect against empty range
+				return min;
+			const auto span = static_cast<uint64_t>(static_cast<uint32_t>(max - min));
+			return min + static_cast<int>((static_cast<uint64_t>(next()) * span) >> 32);
+		}
+
+		// Fills an array with random numbers in [min..max). Large arrays are filled
+		// from 8 parallel streams derived from this generator, using SIMD where
+		// available; results do not depend on whether SIMD is used.
+		void fill(float* out, std::size_t count, float min, float max);
+	};
+
+	// Returns seed for the next thread-local generator.
+	uint64_t next_thread_seed(void);
+
+	// Returns the random generator of the calling thread. Each thread starts with
+	// a distinct, fixed seed.
+	inline Random& thread_random(void)
+	{
+		static thread_local Random rng(next_thread_seed());
+		return rng;
+	}
+
+	// Seeds the random generator of the calling thread.
+	inline void seed_random(uint64_t seed) { thread_random().seed(seed); }
+
 	inline float random(float min, float max)
 	{
-		return min + (max - min) * (static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX));
+		return thread_random().range(min, max);
 	}
 
 	inline int random(int min, int max)
 	{
-		if (min == max) // protect against / 0
-			return min;
-		else
-			return min + std::rand() % (max - min);
+		return thread_random().range(min, max);
+	}
+
+	// Counter-based random number: hashes a seed and a set of coordinates into a
+	// 32-bit value. The result only depends on the inputs, not on call order, so
+	// it can be evaluated in parallel.
+	inline uint32_t hash_random(uint32_t seed, uint32_t x, uint32_t y, uint32_t z = 0u)
+	{
+		auto h = seed * 0x9e3779b9u;
+		h ^= x * 0x85ebca6bu;
+		h = (h << 13) | (h >> 19);
+		h ^= y * 0xc2b2ae35u;
+		h = (h << 17) | (h >> 15);
+		h ^= z * 0x27d4eb2fu;
+		// murmur3 finalizer
+		h ^= h >> 16;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35u;
+		h ^= h >> 16;
+		return h;
+	}
+
+	// Returns a counter-based random number in [min..max].
+	inline float hash_random(float min, float max, uint32_t seed, uint32_t x, uint32_t y, uint32_t z = 0u)
+	{
+		// use upper 24 bits for an exactly representable float in [0..1]
+		const auto r = static_cast<float>(hash_random(seed, x, y, z) >> 8) * (1.0f / 16777215.0f);
+		return min + (max - min) * r;
 	}
-}
\ No newline at end of file
+}
@@ -35,6 +35,8 @@ namespace dukat
 		bool show_wireframe;
 		bool backface_culling;
 		bool blending;
+		// Interpolation factor between previous and current simulation step
+		float alpha;
 
 		void test_capabilities(void);
 		virtual void resize_window(void);
@@ -93,6 +95,9 @@ namespace dukat
 		void set_backface_culling(bool backface_culling);
 		void set_blending(bool blending);
 		void set_clear_color(const Color& clr);
+		// Sets how far rendering is between the last two fixed updates [0..1].
+		void set_alpha(float alpha) { this->alpha = alpha; }
+		float get_alpha(void) const { return alpha; }
 
 		// Clears screen buffers.
 		void clear(void) { glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); }
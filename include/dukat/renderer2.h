@@ -63,7 +63,8 @@ namespace dukat
 		void resize_window(void);
 
 	public:
-		static const int max_particles = 2048;
+		// Number of particles uploaded and drawn per draw call.
+		static const int particle_batch_size = 2048;
 
 #if OPENGL_VERSION <= 30
 		static constexpr const char* u_cam_dimension = "u_cam_dimension";
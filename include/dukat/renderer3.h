@@ -3,6 +3,7 @@
 #include <list>
 #include <memory>
 #include <array>
+#include <vector>
 
 #ifndef OPENGL_VERSION
 #include "version.h"
@@ -59,9 +60,18 @@ namespace dukat
 		// Quad to composite final image onto
 		std::unique_ptr<MeshData> quad;
 		ShaderProgram* composite_program;
+
+		// View frustum culling
+		bool culling_enabled;
+		std::vector<AABB3> cull_boxes; // world bounds of meshes to test
+		std::vector<int> cull_indices; // index of mesh for each box
+		std::vector<int8_t> cull_results;
+		std::vector<uint8_t> culled; // set for each mesh outside of frustum
 		
 		void init_lights(void);
 		void switch_fbo(void);
+		// Classifies bounds of scene meshes against camera frustum in one batch.
+		void cull(const std::vector<Mesh*>& meshes);
 
 	public:
 		Renderer3(Window* window, ShaderCache* shaders, TextureCache* textures);
@@ -77,6 +87,11 @@ namespace dukat
 		void toggle_effects(void) { effects_enabled = !effects_enabled; }
 		void add_effect(int index, const Effect3& effect);
 
+		// View frustum culling of meshes that provide world bounds
+		void enable_culling(void) { culling_enabled = true; }
+		void disable_culling(void) { culling_enabled = false; }
+		bool is_culling_enabled(void) const { return culling_enabled; }
+
 		void set_camera(std::unique_ptr<Camera3> camera) { this->camera = std::move(camera); }
 		Camera3* get_camera(void) const { return camera.get(); }
 		Light* get_light(int idx) { assert((idx >= 0) && (idx < num_lights)); return &lights[idx]; }
@@ -20,7 +20,7 @@ namespace dukat
 	class Camera2;
 	class Effect2;
 	class Matrix4;
-	struct Particle;
+	class ParticleData;
 	class Renderer2;
 	class ShaderCache;
 	class ShaderProgram;
@@ -39,7 +39,8 @@ namespace dukat
 		VertexBuffer* particle_buffer;
 		std::vector<std::unique_ptr<Effect2>> effects;
 		std::vector<Sprite*> sprites;
-		std::deque<Particle*> particles;
+		ParticleData* particles; // particle storage of particle manager
+		int particle_layer; // index of this layer's range in particle storage
 		std::vector<TextMeshInstance*> texts;
 		bool is_visible;
 
@@ -47,6 +48,12 @@ namespace dukat
 		void fill_sprite_queue(const AABB2& camera_bb, std::function<bool(Sprite*)> predicate,
 			std::priority_queue<Sprite*, std::deque<Sprite*>, SpriteComparator>& queue);
 
+		// Binds particle program and vertex buffer for drawing particle batches.
+		void bind_particle_buffer(Renderer2* renderer);
+		// Uploads count staged particles and draws them.
+		void draw_particle_batch(int count);
+		void unbind_particle_buffer(void);
+
 		// Generates sprite model matrix.
 		void compute_model_matrix(const Sprite& sprite, const Vector2& camera_position, Matrix4& mat_model);
 
@@ -72,15 +79,19 @@ namespace dukat
 
 		bool has_effects(void) const { return !effects.empty(); }
 		bool has_sprites(void) const { return !sprites.empty(); }
-		bool has_particles(void) const { return !particles.empty(); }
+		bool has_particles(void) const { return particles != nullptr; }
 		bool has_text(void) const { return !texts.empty(); }
 
 		Effect2* add(std::unique_ptr<Effect2> fx);
 		void remove(Effect2* fx);
 		void add(Sprite* sprite);
 		void remove(Sprite* sprite);
-		void add(Particle* p);
-		void remove(Particle* p);
+		// Sets storage that holds particles of this layer.
+		void set_particles(ParticleData* particles) { this->particles = particles; }
+		ParticleData* get_particles(void) const { return particles; }
+		// Index assigned by the particle manager, or -1 if none has been assigned.
+		int get_particle_layer(void) const { return particle_layer; }
+		void set_particle_layer(int index) { particle_layer = index; }
 		void add(TextMeshInstance* text);
 		void remove(TextMeshInstance* text);
 		
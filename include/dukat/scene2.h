@@ -1,5 +1,6 @@
 #pragma once
 
+#include "delegate.h"
 #include "scene.h"
 
 namespace dukat
@@ -10,7 +11,7 @@ namespace dukat
 	{
 	protected:
 		Game2* game;
-		std::queue<std::function<void(void)>> delayed_actions;
+		std::vector<Delegate<void(void)>> delayed_actions;
 
 	public:
 		Scene2(Game2* game) : game(game) { }
@@ -18,6 +19,6 @@ namespace dukat
 
 		virtual void update(float delta);
 		virtual void render(void);
-		void delay_action(const std::function<void(void)>& action) { delayed_actions.push(action); }
+		void delay_action(Delegate<void(void)> action) { delayed_actions.push_back(std::move(action)); }
 	};
 }
@@ -0,0 +1,21 @@
+#pragma once
+
+// SIMD kernels are compiled for AVX2 using per-function target attributes and
+// selected at runtime with cpu_has_avx2(), so the library does not require 
+// AVX2-specific compiler flags and still runs on older CPUs. Define 
+// DUKAT_NO_SIMD to build scalar code paths only.
+#if !defined(DUKAT_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define DUKAT_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define DUKAT_TARGET_AVX2
+#else
+#define DUKAT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace dukat
+{
+	// Returns true if the CPU and OS support AVX2.
+	bool cpu_has_avx2(void);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "matrix4.h"
+#include "quaternion.h"
+#include "vector3.h"
+
+namespace dukat
+{
+	// Keyframed joint animation. Rotation and translation keys of all joints
+	// are stored in flat arrays ordered by joint, then by time; keys are
+	// relative to the joint's bind transform.
+	class AnimationClip
+	{
+	private:
+		// First key of each joint
+		std::vector<uint32_t> rotation_begin;
+		std::vector<uint32_t> translation_begin;
+		std::vector<float> rotation_time;
+		std::vector<Quaternion> rotation;
+		std::vector<float> translation_time;
+		std::vector<Vector3> translation;
+		float duration;
+
+	public:
+		AnimationClip(void) : duration(0.0f) { }
+		~AnimationClip(void) { }
+
+		// Starts keys of the next joint.
+		void add_joint(void);
+		// Adds keys to the last joint. Keys have to be added in order of time.
+		void add_rotation_key(float time, const Quaternion& q);
+		void add_translation_key(float time, const Vector3& t);
+
+		int get_joint_count(void) const { return static_cast<int>(rotation_begin.size()); }
+		float get_duration(void) const { return duration; }
+		void set_duration(float duration) { this->duration = duration; }
+
+		// Samples a joint at a point in time. Rotations are interpolated with
+		// slerp, translations linearly. Joints without keys return identity.
+		void sample(int joint, float time, Quaternion& q, Vector3& t) const;
+	};
+
+	// Joint hierarchy with bind pose. Parents are stored before children, so
+	// absolute transforms can be computed in a single pass.
+	class Skeleton
+	{
+	private:
+		std::vector<int> parent;
+		// Local bind transform of each joint relative to its parent
+		std::vector<Matrix4> local;
+		// Inverse of absolute bind transform of each joint
+		std::vector<Matrix4> inverse_bind;
+		// Transform applied on top of all joints
+		Matrix4 root;
+
+	public:
+		Skeleton(void) { root.identity(); }
+		~Skeleton(void) { }
+
+		// Adds a joint with a parent index (-1 for none) and local bind
+		// transform. Returns index of the joint.
+		int add_joint(int parent, const Matrix4& local);
+		int get_joint_count(void) const { return static_cast<int>(parent.size()); }
+		int get_parent(int joint) const { return parent[joint]; }
+		void set_root(const Matrix4& root) { this->root = root; }
+
+		// Returns number of matrices in a palette. The last matrix is the root
+		// transform, used for vertices not attached to any joint.
+		int get_palette_size(void) const { return get_joint_count() + 1; }
+		// Samples clip at time and writes skinning matrices to palette, which
+		// has to hold get_palette_size() matrices. Each matrix maps a vertex
+		// from bind pose to its animated position.
+		void build_palette(const AnimationClip& clip, float time, Matrix4* palette) const;
+	};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "model3.h"
+
+namespace dukat
+{
+	class Matrix4;
+	class Vector3;
+
+	// Bind pose of a mesh skinned on the CPU. Each vertex is attached to a
+	// single joint. Vertices are stored as structure-of-arrays sorted by joint,
+	// so every joint's matrix is loaded once per run of vertices and 8
+	// vertices are transformed per SIMD step.
+	class SkinnedMesh
+	{
+	private:
+		struct Run
+		{
+			int joint;
+			int begin, end;
+		};
+
+		std::vector<float> px, py, pz;
+		std::vector<float> nx, ny, nz;
+		// Original index of each sorted vertex
+		std::vector<int> order;
+		std::vector<Run> runs;
+
+		// Skins sorted vertices [begin..end) by matrix m.
+		void skin_range(const Matrix4& m, int begin, int end, Model3::Vertex* out) const;
+
+	public:
+		SkinnedMesh(void) { }
+		~SkinnedMesh(void) { }
+
+		// Sets bind pose vertices. joints holds the palette index of each vertex.
+		void set_vertices(const Vector3* positions, const Vector3* normals, const int* joints, int count);
+		int get_vertex_count(void) const { return static_cast<int>(order.size()); }
+
+		// Transforms vertices by a matrix palette and writes positions and
+		// normals to out, which has to hold get_vertex_count() vertices in
+		// their original order. Texture coordinates are left untouched.
+		void skin(const Matrix4* palette, Model3::Vertex* out) const;
+		// Skins count instances across the shared thread pool. Instance i
+		// reads its palette at palettes + i * palette_size and writes to
+		// out + i * get_vertex_count().
+		void skin(const Matrix4* palettes, int palette_size, Model3::Vertex* out, int count) const;
+	};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "clipmapprefetcher.h"
+#include "clipmapstate.h"
+
+namespace dukat
+{
+	class HeightMap;
+
+	// CPU reference of the fx_clipmap_normal shader. Computes the 2-channel normal
+	// map (2*texture_size x 2*texture_size, interleaved RG) of one level from its
+	// torroidal elevation sampler with texture offset (u,v). Rows are processed in
+	// parallel; uses AVX2 where available.
+	void generate_clipmap_normals(const float* elevation, int texture_size, int u, int v,
+		float scale_factor, float* normals);
+
+	// Clipmap that keeps elevation and normal samplers in system memory. Produces
+	// the same sampler contents as the GL implementation without requiring a GL
+	// context; used as a software fallback for tools and to benchmark terrain
+	// streaming.
+	class SoftwareClipMap
+	{
+	private:
+		const HeightMap* height_map;
+		ClipMapState state;
+		std::unique_ptr<ClipMapPrefetcher> prefetcher;
+		std::vector<std::vector<float>> elevation_maps; // texture_size^2 elevation samples per level
+		std::vector<std::vector<float>> normal_maps; // (2*texture_size)^2 RG normals per level
+		std::vector<ClipMapUpdate> updates;
+		std::vector<float> buffer;
+
+		// Writes buffer to sampler rect, wrapping around the sampler edge.
+		void apply_update(const ClipMapUpdate& u);
+		// Updates elevation samplers of dirty levels, then normal maps. Returns
+		// index of coarsest level that was updated.
+		int refresh(void);
+
+	public:
+		bool prefetching; // if set, elevation data is sampled ahead of time on a worker thread
+		bool normals; // if set, normal maps are regenerated after each update
+
+		SoftwareClipMap(int num_levels, int level_size, const HeightMap* height_map);
+		~SoftwareClipMap(void) { }
+
+		// Follows observer and refreshes all samplers affected by the move. Returns
+		// index of coarsest level that was updated, or -1.
+		int update(const Vector3& observer_pos, float delta);
+
+		const ClipMapState& get_state(void) const { return state; }
+		ClipMapPrefetcher* get_prefetcher(void) { return prefetcher.get(); }
+		// Returns updates applied by the last call to update.
+		const std::vector<ClipMapUpdate>& get_updates(void) const { return updates; }
+		const std::vector<float>& get_elevation_map(int level) const { return elevation_maps[level]; }
+		const std::vector<float>& get_normal_map(int level) const { return normal_maps[level]; }
+	};
+}
@@ -29,6 +29,9 @@ namespace dukat
 		return reinterpret_cast<float_t&>(val);
 	}
 
+	// Computes a Fletcher-style checksum over a block of data.
+	uint32_t compute_checksum(const uint8_t* data, size_t size);
+
 	// Writes the content of the current screen buffer to a file.
 	void save_screenshot(const std::string& filename);
 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dukat
+{
+	// Fixed-size pool of worker threads. Used to spread CPU-heavy work such as
+	// terrain generation across cores.
+	class ThreadPool
+	{
+	private:
+		std::vector<std::thread> workers;
+		std::deque<std::function<void(void)>> tasks;
+		std::mutex mtx;
+		std::condition_variable cv;
+		bool done;
+
+		void worker_loop(void);
+
+	public:
+		// Creates a pool with a given number of worker threads. If num_threads is 0,
+		// one thread per hardware core (minus the calling thread) will be created.
+		ThreadPool(int num_threads = 0);
+		~ThreadPool(void);
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// Queues a task for execution on a worker thread.
+		std::future<void> submit(std::function<void(void)> task);
+
+		// Splits the range [begin..end) into chunks of at most grain_size elements and
+		// invokes fn(chunk_begin, chunk_end) for each chunk. The calling thread 
+		// participates in the work and the call blocks until all chunks are done.
+		// If fn throws, chunks not yet started are skipped and the first exception
+		// is rethrown once all running chunks have finished.
+		void parallel_for(int begin, int end, int grain_size, const std::function<void(int, int)>& fn);
+
+		// Returns number of threads that take part in parallel_for, including the caller.
+		int get_concurrency(void) const { return static_cast<int>(workers.size()) + 1; }
+
+		// Shared pool used by library algorithms.
+		static ThreadPool& shared(void);
+	};
+
+	// Convenience wrapper for ThreadPool::shared().parallel_for.
+	inline void parallel_for(int begin, int end, int grain_size, const std::function<void(int, int)>& fn)
+	{
+		ThreadPool::shared().parallel_for(begin, end, grain_size, fn);
+	}
+}
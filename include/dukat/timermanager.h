@@ -1,9 +1,12 @@
 #pragma once
 
+#include <array>
 #include <functional>
 #include <list>
 #include <memory>
+#include <vector>
 
+#include "delegate.h"
 #include "manager.h"
 #include "objectpool.h"
 
@@ -12,36 +15,93 @@ namespace dukat
     struct Timer
     {
 		uint32_t generation;
+		uint32_t serial; // identifies queue entries of this timer
 		uint8_t group; // timer group
 		float interval;
-		float runtime; 
+		double expiry; // time of group clock at which timer fires next
         bool recurring;
 		bool alive;
-        std::function<void(void)> callback;
+		uint32_t pool_index; // slot in timer pool
+        Delegate<void(void)> callback;
 
-        Timer(void) : generation(0u), group(0u), interval(0.0f), runtime(0.0f), 
-			recurring(false), alive(false), callback(nullptr) { }
+        Timer(void) : generation(0u), serial(0u), group(0u), interval(0.0f), expiry(0.0), 
+			recurring(false), alive(false), pool_index(0u), callback(nullptr) { }
     };
 
+	// Schedules timers by absolute expiry. Each timer group has its own clock,
+	// which only advances while the group is active (group 0 is always
+	// active), and a min-heap of pending timers ordered by expiry. An update
+	// only touches timers that expire, so its cost does not depend on the
+	// number of pending timers. Number of timers is unbounded.
+	//
+	// Timers fire at the first update that moves their group clock past their
+	// expiry. Timers created by a callback during an update do not fire before
+	// the next update.
     class TimerManager : public Manager
     {
     private:
-		// max number of timers
-		static constexpr auto max_timers = 1024;
+		// number of timers storage grows by
+		static constexpr std::size_t timer_chunk_size = 1024;
+		static constexpr int num_groups = 256;
+
+		struct Entry
+		{
+			double expiry;
+			uint32_t serial; // orders timers with same expiry by creation
+			uint32_t handle;
+		};
+		struct Group
+		{
+			double time; // group clock
+			int count; // number of live timers
+			std::vector<Entry> queue; // min-heap on expiry, may hold cancelled timers
+		};
+
 		uint32_t generation;
+		uint32_t serial;
 		uint8_t active_group;
-		ObjectPool<Timer, max_timers> timers;
+		ObjectPool<Timer, timer_chunk_size> timers;
+		std::array<Group, num_groups> groups;
+		// Timers to be queued again after an update
+		std::vector<Entry> requeue;
+
+		// Orders heap entries so the earliest expiry is on top.
+		static bool later(const Entry& a, const Entry& b)
+		{
+			return a.expiry > b.expiry || (a.expiry == b.expiry && a.serial > b.serial);
+		}
+		// Returns timer of a queue entry, or nullptr if the timer has been released.
+		// The serial guards against handles of reused slots.
+		Timer* lookup(const Entry& e) const
+		{
+			auto t = timers.get(e.handle);
+			return t != nullptr && t->serial == e.serial ? t : nullptr;
+		}
+		void schedule(Group& group, const Entry& entry);
+		void release(Timer* timer);
+		// Advances clock of a group and fires expired timers.
+		void advance(Group& group, float delta);
 
     public:
-		TimerManager(GameBase* game) : Manager(game), generation(0u), active_group(0u) { }
+		TimerManager(GameBase* game);
 		~TimerManager(void) { }
 
-        Timer* create_timer(float interval, std::function<void(void)> callback, bool recurring = false);
-		void cancel_timer(Timer* timer) { if (timer != nullptr) timers.release(timer); }
+        Timer* create_timer(float interval, Delegate<void(void)> callback, bool recurring = false);
+		void cancel_timer(Timer* timer) { if (timer != nullptr) release(timer); }
+		void cancel_timer(uint32_t handle) { cancel_timer(timers.get(handle)); }
+		// Returns a handle for a live timer. Unlike a pointer, a handle can be
+		// checked after the timer has expired or been cancelled.
+		uint32_t get_handle(const Timer* timer) const { return timers.handle(timer); }
+		// Returns timer a handle refers to, or nullptr if it is no longer live.
+		Timer* get_timer(uint32_t handle) const { return timers.get(handle); }
+		// Returns number of live timers.
+		int get_timer_count(void) const { return static_cast<int>(timers.size()); }
         void update(float delta);
+		// Sets group whose timers run in addition to group 0. Timers of other
+		// groups are paused.
 		void set_active_group(uint8_t group) { this->active_group = group; }
 
 		// Cancels all active timers.
-		void clear(void) { timers.clear(); }
+		void clear(void);
     };
 }
\ No newline at end of file
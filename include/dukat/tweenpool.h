@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "animation.h"
+#include "delegate.h"
+#include "easing.h"
+
+namespace dukat
+{
+	// Pool of keyframed animations ("tweens") over values of a single type.
+	// Tracks are stored as dense columns and stepped in one loop without
+	// virtual calls. Each track starts at the value of its target when added
+	// and moves through its keys using an easing curve.
+	//
+	// Tracks are referred to by 32-bit handles. The top 2 bits hold a tag
+	// identifying the pool, followed by a 10-bit generation and a 20-bit slot
+	// index, so cancelling a track is O(1) and stale handles are ignored.
+	template<typename T>
+	class TweenPool
+	{
+	public:
+		typedef uint32_t Handle;
+
+	private:
+		static constexpr uint32_t index_bits = 20u;
+		static constexpr uint32_t index_mask = (1u << index_bits) - 1u;
+		static constexpr uint32_t generation_mask = (1u << 10u) - 1u;
+		static constexpr uint32_t no_index = 0xffffffffu;
+		enum Flags { Loop = 1, Paused = 2 };
+
+		uint32_t tag;
+		// Slot table mapping handles to tracks
+		std::vector<uint32_t> slot_track;
+		std::vector<uint16_t> slot_generation;
+		std::vector<uint32_t> free_slots;
+
+		// Tracks
+		std::vector<uint32_t> slot;
+		std::vector<T*> target;
+		std::vector<T> from, to; // values at start and end of current segment
+		std::vector<float> time, seg_begin, seg_end;
+		std::vector<uint32_t> first_key, num_keys, next_key;
+		std::vector<Easing> easing, seg_easing;
+		std::vector<uint8_t> group, flags;
+		std::vector<Delegate<void(void)>> callback;
+
+		// Keys of all tracks; a track's keys are contiguous
+		std::vector<float> key_time;
+		std::vector<T> key_value;
+		std::vector<uint8_t> key_discrete;
+		std::size_t dead_keys;
+
+		// Tracks that reached their last key during a step
+		std::vector<Handle> finished;
+
+		Handle make_handle(uint32_t s) const { return (tag << 30) | (static_cast<uint32_t>(slot_generation[s]) << index_bits) | s; }
+
+		uint32_t find_track(Handle h) const
+		{
+			const auto s = h & index_mask;
+			if ((h >> 30) != tag || s >= slot_track.size())
+				return no_index;
+			if (slot_generation[s] != ((h >> index_bits) & generation_mask))
+				return no_index;
+			return slot_track[s];
+		}
+
+		// Sets current segment of a track to end at key k.
+		void set_segment(uint32_t i, uint32_t k)
+		{
+			const auto a = first_key[i] + k - 1;
+			next_key[i] = k;
+			seg_begin[i] = key_time[a];
+			seg_end[i] = key_time[a + 1];
+			from[i] = key_value[a];
+			to[i] = key_value[a + 1];
+			seg_easing[i] = key_discrete[a + 1] ? Easing::Step : easing[i];
+		}
+
+		// Returns key ending the segment that contains time t.
+		uint32_t find_segment(uint32_t i, float t) const
+		{
+			const auto begin = key_time.begin() + first_key[i];
+			const auto end = begin + num_keys[i];
+			const auto k = static_cast<uint32_t>(std::upper_bound(begin + 1, end, t) - begin);
+			return std::min(k, num_keys[i] - 1);
+		}
+
+		void evaluate(uint32_t i)
+		{
+			const auto len = seg_end[i] - seg_begin[i];
+			auto u = len > 0.0f ? (time[i] - seg_begin[i]) / len : 1.0f;
+			u = std::max(0.0f, std::min(1.0f, u));
+			*target[i] = from[i] + (to[i] - from[i]) * ease(seg_easing[i], u);
+		}
+
+		template<typename V>
+		static void move_last(std::vector<V>& column, uint32_t i)
+		{
+			column[i] = std::move(column.back());
+			column.pop_back();
+		}
+
+		void remove_track(uint32_t i)
+		{
+			const auto s = slot[i];
+			dead_keys += num_keys[i];
+			const auto last = static_cast<uint32_t>(slot.size()) - 1;
+			if (i != last)
+				slot_track[slot[last]] = i;
+			move_last(slot, i); move_last(target, i);
+			move_last(from, i); move_last(to, i);
+			move_last(time, i); move_last(seg_begin, i); move_last(seg_end, i);
+			move_last(first_key, i); move_last(num_keys, i); move_last(next_key, i);
+			move_last(easing, i); move_last(seg_easing, i);
+			move_last(group, i); move_last(flags, i);
+			move_last(callback, i);
+
+			slot_track[s] = no_index;
+			slot_generation[s] = static_cast<uint16_t>((slot_generation[s] + 1u) & generation_mask);
+			if (slot_generation[s] == 0u) // keep handle 0 invalid
+				slot_generation[s] = 1u;
+			free_slots.push_back(s);
+
+			if (dead_keys > 1024 && dead_keys > key_time.size() / 2)
+				compact_keys();
+		}
+
+		// Removes keys of tracks that no longer exist.
+		void compact_keys(void)
+		{
+			std::vector<float> times;
+			std::vector<T> values;
+			std::vector<uint8_t> discrete;
+			times.reserve(key_time.size() - dead_keys);
+			values.reserve(key_time.size() - dead_keys);
+			discrete.reserve(key_time.size() - dead_keys);
+			for (std::size_t i = 0; i < slot.size(); i++)
+			{
+				const auto begin = first_key[i];
+				first_key[i] = static_cast<uint32_t>(times.size());
+				times.insert(times.end(), key_time.begin() + begin, key_time.begin() + begin + num_keys[i]);
+				values.insert(values.end(), key_value.begin() + begin, key_value.begin() + begin + num_keys[i]);
+				discrete.insert(discrete.end(), key_discrete.begin() + begin, key_discrete.begin() + begin + num_keys[i]);
+			}
+			key_time.swap(times);
+			key_value.swap(values);
+			key_discrete.swap(discrete);
+			dead_keys = 0;
+		}
+
+	public:
+		TweenPool(uint32_t tag) : tag(tag), dead_keys(0) { }
+		~TweenPool(void) { }
+
+		// Adds a track animating target through keys, which have to be ordered
+		// by time. Key mode Discrete makes a value change at its key's time
+		// instead of being interpolated.
+		Handle add(T* target, const AnimationKey<T>* keys, int count, Easing easing, uint8_t group, bool loop,
+			Delegate<void(void)> callback)
+		{
+			if (count < 1)
+				throw std::runtime_error("Animation requires at least one key.");
+			uint32_t s;
+			if (free_slots.empty())
+			{
+				s = static_cast<uint32_t>(slot_track.size());
+				if (s > index_mask)
+					throw std::runtime_error("Exceeded maximum number of animations.");
+				slot_track.resize(s + 1);
+				slot_generation.push_back(1u);
+			}
+			else
+			{
+				s = free_slots.back();
+				free_slots.pop_back();
+			}
+
+			const auto i = static_cast<uint32_t>(slot.size());
+			slot_track[s] = i;
+			slot.push_back(s);
+			this->target.push_back(target);
+			from.emplace_back();
+			to.emplace_back();
+			time.push_back(0.0f);
+			seg_begin.push_back(0.0f);
+			seg_end.push_back(0.0f);
+			// implicit first key holds the current value
+			first_key.push_back(static_cast<uint32_t>(key_time.size()));
+			num_keys.push_back(static_cast<uint32_t>(count + 1));
+			next_key.push_back(1u);
+			key_time.push_back(0.0f);
+			key_value.push_back(*target);
+			key_discrete.push_back(0u);
+			for (auto k = 0; k < count; k++)
+			{
+				key_time.push_back(keys[k].index);
+				key_value.push_back(keys[k].value);
+				key_discrete.push_back(keys[k].mode == AnimationKey<T>::Discrete ? 1u : 0u);
+			}
+			this->easing.push_back(easing);
+			seg_easing.push_back(easing);
+			this->group.push_back(group);
+			flags.push_back(loop ? Loop : 0);
+			this->callback.push_back(std::move(callback));
+			set_segment(i, 1u);
+			return make_handle(s);
+		}
+
+		// Removes a track without calling its callback. Returns false if the
+		// handle is stale.
+		bool cancel(Handle h)
+		{
+			const auto i = find_track(h);
+			if (i == no_index)
+				return false;
+			remove_track(i);
+			return true;
+		}
+
+		bool is_valid(Handle h) const { return find_track(h) != no_index; }
+
+		void set_paused(Handle h, bool paused)
+		{
+			const auto i = find_track(h);
+			if (i == no_index)
+				return;
+			if (paused)
+				flags[i] |= Paused;
+			else
+				flags[i] &= ~Paused;
+		}
+
+		// Moves a track to a point in time and updates its target. Can be
+		// called repeatedly to scrub through an animation.
+		void seek(Handle h, float t)
+		{
+			const auto i = find_track(h);
+			if (i == no_index)
+				return;
+			const auto duration = key_time[first_key[i] + num_keys[i] - 1];
+			time[i] = std::max(0.0f, std::min(duration, t));
+			set_segment(i, find_segment(i, time[i]));
+			evaluate(i);
+		}
+
+		// Advances all tracks of group 0 or the active group.
+		void step(float delta, uint8_t active_group)
+		{
+			finished.clear();
+			const auto n = static_cast<uint32_t>(slot.size());
+			for (uint32_t i = 0; i < n; i++)
+			{
+				if ((flags[i] & Paused) || (group[i] != active_group && group[i] != 0))
+					continue;
+
+				const auto t = time[i] + delta;
+				time[i] = t;
+				if (t >= seg_end[i])
+				{
+					const auto last = first_key[i] + num_keys[i] - 1;
+					const auto duration = key_time[last];
+					if (t >= duration)
+					{
+						finished.push_back(make_handle(slot[i]));
+						if (flags[i] & Loop)
+						{
+							time[i] = duration > 0.0f ? std::fmod(t, duration) : 0.0f;
+							set_segment(i, find_segment(i, time[i]));
+						}
+						else
+						{
+							*target[i] = key_value[last];
+							continue;
+						}
+					}
+					else
+					{
+						// usually moves on by a single key
+						auto k = next_key[i];
+						while (key_time[first_key[i] + k] <= t)
+							k++;
+						set_segment(i, k);
+					}
+				}
+				evaluate(i);
+			}
+
+			// Callbacks may add or cancel tracks, so they run after the loop.
+			for (auto h : finished)
+			{
+				auto i = find_track(h);
+				if (i == no_index)
+					continue;
+				auto cb = std::move(callback[i]);
+				if (cb)
+					cb();
+				i = find_track(h);
+				if (i == no_index)
+					continue;
+				if (flags[i] & Loop)
+					callback[i] = std::move(cb);
+				else
+					remove_track(i);
+			}
+		}
+
+		void clear(void)
+		{
+			while (!slot.empty())
+			{
+				remove_track(static_cast<uint32_t>(slot.size()) - 1);
+			}
+			key_time.clear();
+			key_value.clear();
+			key_discrete.clear();
+			dead_keys = 0;
+		}
+
+		// Returns number of tracks.
+		std::size_t size(void) const { return slot.size(); }
+	};
+}
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include <dukat/animationmanager.h>
+#include <dukat/profiler.h>
 
 namespace dukat
 {
@@ -24,6 +25,11 @@ namespace dukat
 
 	void AnimationManager::update(float delta)
 	{
+		PROFILE_SCOPE("animation.update");
+		float_tweens.step(delta, active_group);
+		vector2_tweens.step(delta, active_group);
+		color_tweens.step(delta, active_group);
+
 		for (auto it = animations.begin(); it != animations.end(); )
 		{
 			const auto& a = (*it);
@@ -43,4 +49,63 @@ namespace dukat
 			++it;
 		}
 	}
-}
\ No newline at end of file
+
+	void AnimationManager::cancel(Handle handle)
+	{
+		switch (handle >> 30)
+		{
+		case FloatTag: float_tweens.cancel(handle); break;
+		case Vector2Tag: vector2_tweens.cancel(handle); break;
+		case ColorTag: color_tweens.cancel(handle); break;
+		}
+	}
+
+	bool AnimationManager::is_running(Handle handle) const
+	{
+		switch (handle >> 30)
+		{
+		case FloatTag: return float_tweens.is_valid(handle);
+		case Vector2Tag: return vector2_tweens.is_valid(handle);
+		case ColorTag: return color_tweens.is_valid(handle);
+		default: return false;
+		}
+	}
+
+	void AnimationManager::pause(Handle handle)
+	{
+		switch (handle >> 30)
+		{
+		case FloatTag: float_tweens.set_paused(handle, true); break;
+		case Vector2Tag: vector2_tweens.set_paused(handle, true); break;
+		case ColorTag: color_tweens.set_paused(handle, true); break;
+		}
+	}
+
+	void AnimationManager::resume(Handle handle)
+	{
+		switch (handle >> 30)
+		{
+		case FloatTag: float_tweens.set_paused(handle, false); break;
+		case Vector2Tag: vector2_tweens.set_paused(handle, false); break;
+		case ColorTag: color_tweens.set_paused(handle, false); break;
+		}
+	}
+
+	void AnimationManager::seek(Handle handle, float time)
+	{
+		switch (handle >> 30)
+		{
+		case FloatTag: float_tweens.seek(handle, time); break;
+		case Vector2Tag: vector2_tweens.seek(handle, time); break;
+		case ColorTag: color_tweens.seek(handle, time); break;
+		}
+	}
+
+	void AnimationManager::clear(void)
+	{
+		animations.clear();
+		float_tweens.clear();
+		vector2_tweens.clear();
+		color_tweens.clear();
+	}
+}
@@ -3,20 +3,26 @@
 #include <dukat/audiomanager.h>
 #include <dukat/log.h>
 #include <dukat/perfcounter.h>
+#include <dukat/profiler.h>
 #include <dukat/sysutil.h>
 #include <dukat/window.h>
 #include <dukat/devicemanager.h>
 #include <dukat/keyboarddevice.h>
 #include <dukat/settings.h>
 #include <ctime>
+#include <thread>
 
 namespace dukat
 {
 	constexpr float Application::max_frame_delta;
 
 	Application::Application(Settings& settings)
-		: title(settings.get_string("window.title")), runtime(0.0f), paused(false), done(false), last_update(0), settings(settings)
+		: title(settings.get_string("window.title")), last_fps(0), runtime(0.0), paused(false), done(false),
+		headless(settings.get_bool("game.headless", false)), uncapped(settings.get_bool("game.uncapped", false)),
+		tick_rate(0), max_steps(std::max(1, settings.get_int("game.maxsteps", 5))), accumulator(0.0), alpha(1.0f),
+		ticks(0), last_update(Clock::now()), settings(settings)
 	{
+		set_tick_rate(settings.get_int("game.tickrate", 0));
 		init_logging(settings);
 		log->info("Initializing application.");
 
@@ -28,6 +34,15 @@ namespace dukat
 			static_cast<int>(compiled.major), static_cast<int>(compiled.minor), static_cast<int>(compiled.patch),
 			static_cast<int>(linked.major), static_cast<int>(linked.minor), static_cast<int>(linked.patch));
 
+		device_manager = std::make_unique<DeviceManager>(settings);
+		if (headless)
+		{
+			// Events subsystem only so that the process can still be asked to quit.
+			log->info("Running headless.");
+			sdl_check_result(SDL_Init(SDL_INIT_EVENTS), "Initialize SDL");
+			return;
+		}
+
 		sdl_check_result(SDL_Init(SDL_INIT_EVERYTHING), "Initialize SDL");
 		window = std::make_unique<Window>(settings.get_int("window.width", 640), settings.get_int("window.height", 480),
 			settings.get_bool("window.fullscreen"), settings.get_bool("window.vsync", true), settings.get_bool("window.msaa"));
@@ -43,7 +58,6 @@ namespace dukat
 		audio_manager->set_sample_volume(settings.get_float("audio.sample.volume", 1.0f));
 #endif
 
-		device_manager = std::make_unique<DeviceManager>(settings);
 		device_manager->add_keyboard(window.get());
 		gl_check_error();
 	}
@@ -53,54 +67,122 @@ namespace dukat
 		// Force release of device manager before call to SDL_Quit
 		device_manager = nullptr;
 		// Always show cursor before exiting
-		SDL_ShowCursor(SDL_ENABLE);
+		if (!headless)
+			SDL_ShowCursor(SDL_ENABLE);
 		SDL_Quit();
 	}
 
 	int Application::run(void)
 	{
 		log->info("Entering application loop.");
-		uint32_t ticks, last_frame = 0u;
+#ifdef DUKAT_PROFILE
+		Profiler::get().set_thread_name("main");
+#endif
+		reset_clock();
+		auto last_frame = last_update;
 		SDL_Event e;
 		while (!done)
 		{
-			ticks = SDL_GetTicks();
+			const auto now = Clock::now();
+			const auto delta = std::chrono::duration<double>(now - last_update).count();
+			last_update = now;
 
 			if (!paused)
 			{
-				auto delta = static_cast<float>(ticks - last_update) / 1000.0f;
-				runtime += delta;
-				update(std::min(delta, max_frame_delta));
+				PROFILE_SCOPE("app.update");
+				if (tick_rate > 0)
+				{
+					// Simulate in fixed steps; the remainder carries over to the next frame.
+					const auto step = 1.0 / static_cast<double>(tick_rate);
+					if (uncapped)
+						accumulator = step;
+					else
+						accumulator += delta;
+					auto steps = 0;
+					while (accumulator >= step && steps < max_steps)
+					{
+						update(static_cast<float>(step));
+						runtime += step;
+						accumulator -= step;
+						steps++;
+						ticks++;
+					}
+					// Drop time we could not catch up with instead of falling further behind.
+					if (accumulator >= step)
+						accumulator = std::fmod(accumulator, step);
+					alpha = static_cast<float>(accumulator / step);
+				}
+				else
+				{
+					runtime += delta;
+					update(std::min(static_cast<float>(delta), max_frame_delta));
+				}
 			}
-			last_update = ticks;
 
 			// update FPS counter
-			if (ticks - last_frame >= 1000)
+			if (now - last_frame >= std::chrono::seconds(1))
 			{
 				last_fps = perfc.sum(PerformanceCounter::FRAMES);
-				last_frame = ticks;
+				last_frame = now;
 				perfc.collect_stats();
 			}
 
 			// process events
-			while (SDL_PollEvent(&e))
 			{
-				handle_event(e);
+				PROFILE_SCOPE("app.events");
+				while (SDL_PollEvent(&e))
+				{
+					handle_event(e);
+				}
+				device_manager->update();
 			}
 
-			device_manager->update();
-
 			// render to screen
-			render();
+			if (!headless)
+			{
+				PROFILE_SCOPE("app.render");
+				render();
+			}
 			perfc.inc(PerformanceCounter::FRAMES);
 			perfc.reset();
+			PROFILE_FRAME();
+
+			// Without vsync to pace the loop, wait for the next fixed update.
+			if (headless && !uncapped && tick_rate > 0)
+			{
+				const auto step = 1.0 / static_cast<double>(tick_rate);
+				const auto wait = std::chrono::duration<double>(step - accumulator) - (Clock::now() - last_update);
+				if (wait.count() > 0.0)
+					std::this_thread::sleep_for(wait);
+			}
 		}
 
 		return 0;
 	}
 
+	void Application::reset_clock(void)
+	{
+		last_update = Clock::now();
+		accumulator = 0.0;
+	}
+
+	void Application::set_tick_rate(int tick_rate)
+	{
+		this->tick_rate = std::max(0, tick_rate);
+		accumulator = 0.0;
+		alpha = 1.0f;
+	}
+
 	void Application::handle_event(const SDL_Event& e)
 	{
+		// no window or input devices to route events to
+		if (headless)
+		{
+			if (e.type == SDL_QUIT)
+				done = true;
+			return;
+		}
+
 		switch (e.type)
 		{
 		case SDL_QUIT:
@@ -123,6 +205,9 @@ namespace dukat
 
 	void Application::handle_keyboard(const SDL_Event& e)
 	{
+		if (headless)
+			return;
+
 		switch (e.key.keysym.sym)
 		{
 		case SDLK_RETURN:
@@ -141,6 +226,19 @@ namespace dukat
 				save_screenshot(ss.str());
 			}
 			break;
+#ifdef DUKAT_PROFILE
+		case SDLK_F12:
+			{
+				for (const auto& zone : Profiler::get().summarize(60))
+				{
+					log->info("{:<24} {:>6} calls {:>9.3f}ms total {:>9.3f}ms max", zone.name, zone.count, zone.total_ms, zone.max_ms);
+				}
+				std::stringstream ss;
+				ss << "trace_" << std::time(nullptr) << ".json";
+				Profiler::get().save_trace(ss.str());
+			}
+			break;
+#endif
 		}
 	}
 
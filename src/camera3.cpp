@@ -70,7 +70,7 @@ namespace dukat
 		mi[14] = -(mi[2] * m[12] + mi[6] * m[13] + mi[10] * m[14]);
 		mi[15] = 1.0f;
 
-		compute_clip_planes(transform, fov_h, left_clip_plane, right_clip_plane);
+		frustum.setup(transform.position, transform.dir, transform.up, fov_h, fov_v, near_clip, far_clip);
 	}
 
 	Ray3 Camera3::pick_ray_screen(int x, int y)
@@ -94,22 +94,4 @@ namespace dukat
 		Ray3 res;
 		return res.from_points(p1, p2);
 	}
-
-	void Camera3::compute_clip_planes(const CameraTransform3& transform, float fov, Plane& left_plane, Plane& right_plane)
-	{
-		auto half_frust = deg_to_rad(0.5f * fov);
-
-		Matrix4 mrot;
-		mrot.setup_rotation(transform.up, half_frust);
-		auto left_vector = transform.dir * mrot;
-		left_plane.p = transform.position;
-		left_plane.n = cross_product(left_vector, transform.up);
-		left_plane.d = (left_plane.p + left_vector) * left_plane.n;
-
-		mrot.setup_rotation(transform.up, -half_frust);
-		auto right_vector = transform.dir * mrot;
-		right_plane.p = transform.position;
-		right_plane.n = cross_product(transform.up, right_vector);
-		right_plane.d = (right_plane.p + right_vector) * right_plane.n;
-	}
 }
\ No newline at end of file
@@ -1,6 +1,5 @@
 #include "stdafx.h"
 #include <dukat/clipmap.h>
-#include <dukat/bit.h>
 #include <dukat/blockbuilder.h>
 #include <dukat/heightmap.h>
 #include <dukat/log.h>
@@ -21,23 +20,10 @@ namespace dukat
     static const std::string uniform_tex_offset = "u_texture_offset";
     static const std::string uniform_rect = "u_rect";
 
-	void ClipMapLevel::translate(const Vector2& offset)
-	{
-        last_shift = offset / scale;
-		origin += offset;
-		for (auto& bb : bounding_boxes)
-		{
-			bb.min.x += offset.x;
-			bb.min.z += offset.y;
-			bb.max.x += offset.x;
-			bb.max.z += offset.y;
-		}
-	}
-
     ClipMap::ClipMap(Game3* game, int num_levels, int level_size, HeightMap* height_map)
         : num_levels(num_levels), level_size(level_size), texture_size(level_size + 1), game(game),
-          height_map(height_map), min_level(0),
-		  culling(true), stitching(true), blending(true), lighting(true)
+          height_map(height_map), state(num_levels, level_size, height_map),
+		  culling(true), stitching(true), blending(true), lighting(true), prefetching(true)
     {
         log->debug("Creating new clipmap: {}x{}x{}", level_size, level_size, num_levels);
         // TODO: validate that level_size is a power of 2 - 1
@@ -45,10 +31,10 @@ namespace dukat
         assert(level_size < 1024); // using 16 bit indeces
 
         build_buffers();
-		build_levels();
 
         // Allocate buffer space
         buffer.resize(texture_size * texture_size);
+        prefetcher = std::make_unique<ClipMapPrefetcher>(height_map, num_levels, texture_size);
 
         // Generate elevation map array.
         elevation_maps = std::make_unique<Texture>(texture_size, texture_size);
@@ -107,64 +93,6 @@ namespace dukat
         update_normal_maps(max_index);
     }
 
-	void ClipMap::build_levels(void)
-	{
-		const auto min_z = 0.0f;
-		const auto max_z = height_map->get_scale_factor();
-		const auto inner_size = (level_size + 1) / 2;
-		const auto block_size = (level_size + 1) / 4;
-
-		for (int i = 0; i < num_levels; i++)
-		{
-			ClipMapLevel level(i);
-
-			if (i == 0)
-			{
-				level.orientation = ClipMapLevel::bottom_right;
-				level.scale = 1.0f;
-				level.origin = Vector2{ 0.0f, 0.0f };
-			}
-			else
-			{
-				auto& prev_level = levels[i - 1];
-
-				// Origin of each level is shifted by size of next finer level 
-				// in both x and z direction (sign based on right / bottom flags)
-				level.orientation = (prev_level.orientation == ClipMapLevel::bottom_right)
-					? ClipMapLevel::top_left : ClipMapLevel::bottom_right;
-				level.scale = 2.0f * prev_level.scale;
-
-				// Check if orientation is left
-				auto x_shift = (prev_level.orientation & 0x2) == 0x0
-					? -level.scale * (float)(block_size - 1) : -level.scale * block_size;
-				// Check if oriengation is up
-				auto y_shift = (prev_level.orientation & 0x1) == 0x0
-					? -level.scale * (float)(block_size - 1) : -level.scale * block_size;
-				level.origin = Vector2{ prev_level.origin.x + x_shift, prev_level.origin.y + y_shift };
-			}
-			level.width = level.scale * (float)(level_size - 1);
-			level.half_width = 0.5f * level.width;
-				
-			// generate inner boxes 
-			for (int i = ClipMapLevel::bb_inner_idx; i < ClipMapLevel::bb_block_idx; i++)
-			{
-				auto tmp = level.origin + inner_offsets[i - ClipMapLevel::bb_inner_idx] * level.scale;
-				level.bounding_boxes[i].min = Vector3{ tmp.x, min_z, tmp.y };
-				level.bounding_boxes[i].max = Vector3{ tmp.x + (inner_size - 1) * level.scale, max_z, tmp.y + (inner_size - 1) * level.scale };
-			}
-
-			// generates block boxes 
-			for (int i = ClipMapLevel::bb_block_idx; i < 16; i++)
-			{
-				auto tmp = level.origin + block_offsets[i - ClipMapLevel::bb_block_idx] * level.scale;
-				level.bounding_boxes[i].min = Vector3{ tmp.x, min_z, tmp.y };
-				level.bounding_boxes[i].max = Vector3{ tmp.x + (block_size - 1) * level.scale, max_z, tmp.y + (block_size - 1) * level.scale };
-			}
-
-			levels.push_back(level);
-		}
-	}
-
     void ClipMap::build_buffers(void)
     {
 		// Meshes forming the clipmap geometry:
@@ -178,34 +106,13 @@ namespace dukat
 		// 
 
         const auto inner_size = (level_size + 1) / 2;
-        const auto inner_width = (float)(inner_size - 1);
-        
-        // compute offsets for 4 inner buffers in row-order from top-left to bottom-right
-        inner_offsets[0] = { inner_width, inner_width };
-        inner_offsets[1] = { 0.0f, inner_width };
-        inner_offsets[2] = { inner_width, 0.0f };
-        inner_offsets[3] = { 0.0f, 0.0f };
 
         // build innermost buffer
         BlockBuilder bb;
         bb.add_block(inner_size, inner_size);
         inner_mesh = bb.create_mesh();
 
-        // compute offsets of all 12 blocks in row-order from top-left to bottom-right
         const auto block_size = (level_size + 1) / 4;
-        const auto block_width = (float)(block_size - 1);
-        block_offsets[0] = { 2.0f + 3.0f * block_width, 2.0f + 3.0f * block_width };
-        block_offsets[1] = { 2.0f + 2.0f * block_width, 2.0f + 3.0f * block_width };
-        block_offsets[2] = { block_width, 2.0f + 3.0f * block_width };
-        block_offsets[3] = { 0.0f, 2.0f + 3.0f * block_width };
-        block_offsets[4] = { 2.0f + 3.0f * block_width, 2.0f + 2.0f * block_width };
-        block_offsets[5] = { 0.0f, 2.0f + 2.0f * block_width };
-        block_offsets[6] = { 2.0f + 3.0f * block_width, block_width };
-        block_offsets[7] = { 0.0f, block_width };
-        block_offsets[8] = { 2.0f + 3.0f * block_width, 0.0f };
-        block_offsets[9] = { 2.0f + 2.0f * block_width, 0.0f };
-        block_offsets[10] = { block_width, 0.0f };
-        block_offsets[11] = { 0.0f, 0.0f };
 
         // build block buffer
         bb.clear();
@@ -310,291 +217,93 @@ namespace dukat
 
     void ClipMap::update(float delta)
     {
-        // determine height of observer and set min_level accordingly
-		auto height = height_map->get_scale_factor() * height_map->get_elevation((int)std::round(observer_pos.x), (int)std::round(observer_pos.z), 0);
-		min_level = 0;
-		while (min_level < (int)levels.size() && levels[min_level].width < 2.5f * (observer_pos.y - height))
-		{
-			min_level++;
-		}
-
-        // Update level origins, then samplers, then normal maps
-        update_levels();
+        // Update min level and level origins, then samplers, then normal maps
+        prefetcher->update_observer(observer_pos, delta);
+        state.update(observer_pos);
         auto max_index = update_elevation_maps();
         update_normal_maps(max_index);
+
+        // Queue elevation data for the next shift of each level
+        if (prefetching)
+        {
+            prefetcher->predict(state.get_levels());
+        }
     }
 
-    void ClipMap::update_levels(void)
+    void ClipMap::load_elevation(int level, const Rect& r)
     {
-        // Check if we meed to update the origin of the most fine-grained level.
-        const uint8_t down = 1;
-        const uint8_t up = 2;
-        const uint8_t right = 4;
-        const uint8_t left = 8;
-        uint8_t update_flags = 0;
-
-        auto it = levels.begin();
-
-        // Threshold for update is: 2 grid spaces * level.scale 
-        auto grid_size = 2.0f * (*it).scale;
-        // compute delta between origin and camera 
-        auto dx = observer_pos.x - ((*it).origin.x + (*it).half_width);
-        auto dy = observer_pos.z - ((*it).origin.y + (*it).half_width);
-        // Moving left
-        if (dx > grid_size)
-            update_flags |= left;
-        // Moving right
-        else if (dx < -grid_size)
-            update_flags |= right;
-        // Moving up
-        if (dy > grid_size)
-            update_flags |= up;
-        // Moving down
-        else if (dy < -grid_size)
-            update_flags |= down;
-
-        Vector2 offset_shift;
-        while (it != levels.end() && update_flags != 0)
+        if (!prefetching || !prefetcher->fetch(level, r, buffer))
         {
-            auto& level = *it;
-            level.is_dirty = true;
-            // Each test will move the origin of the current level and then
-            // check the level's orientation within the next coarser level
-            // to see if that one needs to be updated as well.
-            if (check_flag(update_flags, left))
-            {
-                offset_shift.x = grid_size;
-                if (level.is_right())
-                {
-                    level.orientation |= 0x2; // flip to left side
-                    update_flags &= (~left); // clear left update flag
-                }
-                else
-                {
-                    level.orientation &= 0x1;
-                }
-            }
-            else if (check_flag(update_flags, right)) 
-            {
-                offset_shift.x = -grid_size;
-                if (level.is_left())
-                {
-                    level.orientation &= 0x1; // flip to right side 
-                    update_flags &= (~right);
-                }
-                else
-                {
-                    level.orientation |= 0x2;
-                }
-            }
-            else
-            {
-                offset_shift.x = 0.0f;
-            }
-
-            if (check_flag(update_flags, up))
-            {
-                offset_shift.y = grid_size;
-                if (level.is_bottom())
-                {
-                    level.orientation |= 0x1; // flip to top side
-                    update_flags &= (~up);
-                }
-                else
-                {
-                    level.orientation &= 0x2;
-                }
-            }
-            else if (check_flag(update_flags, down))
-            {
-                offset_shift.y = -grid_size;
-                if (level.is_top())
-                {
-                    level.orientation &= 0x2; // flip to bottom side
-                    update_flags &= (~down);
-                }
-                else
-                {
-                    level.orientation |= 0x1;
-                }
-            }
-            else
-            {
-                offset_shift.y = 0.0f;
-            }
-
-            level.translate(offset_shift);
-
-            grid_size *= 2.0f;
-            ++it;
+            height_map->get_data(level, r, buffer);
         }
     }
 
     int ClipMap::update_elevation_maps(void)
     {
-        bool fbo_bound = false;
-        int max_index = -1;
+        // This will update all elevation samplers which are flagged as dirty. A full
+        // rebuild is uploaded directly. Partial updates are uploaded to the update 
+        // texture and then rendered into the torroidal sampler, using a second quad
+        // if the updated section wraps around the edge of the sampler.
+        updates.clear();
+        const auto max_index = state.collect_updates(updates);
+        if (updates.empty())
+            return max_index;
+
+        fb_update->bind();
+
+        // Switch shader and bind uniforms
+        game->get_renderer()->switch_shader(update_program);
+        auto one_over_size = 1.0f / (float)texture_size;
+        glUniform2f(update_program->attr(uniform_size), (float)texture_size, (float)texture_size);
+        glUniform2f(update_program->attr(uniform_one_over_size), one_over_size, one_over_size);
 
-        // This will update all elevation samplers which are flagged as dirty. If the 
-        // last_shift for a level is 0, the full texture if updated. Otherwise, this
-        // will refresh only the updated section using torroidal addressing. Depending
-        // on the last_shift motion (x, y, or x+y) we will render 1-4 quads to update 
-        // the elevation sampler with new data.
+        // Bind update texture
+        update_texture->bind(0, update_program);
 
-        for (auto& level : levels)
+        for (const auto& u : updates)
         {
-            if (!level.is_dirty)
-                continue;
+            load_elevation(u.level, u.world);
 
-            // only bind FBO once
-            if (!fbo_bound)
+            if (u.full)
             {
-                fb_update->bind();
+                elevation_maps->bind(0);
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, u.level, u.world.w, u.world.h, 1,
+                    GL_RED, GL_FLOAT, buffer.data());
+                // restore update texture binding
+                update_texture->bind(0, update_program);
+                continue;
+            }
 
-                // Switch shader and bind uniforms
-			    game->get_renderer()->switch_shader(update_program);
-                auto one_over_size = 1.0f / (float)texture_size;
-                glUniform2f(update_program->attr(uniform_size), (float)texture_size, (float)texture_size);
-                glUniform2f(update_program->attr(uniform_one_over_size), one_over_size, one_over_size);
+            // Make layer elevation map render target for framebuffer
+            glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, elevation_maps->id, 0, u.level);
 
-                // Bind update texture
-                update_texture->bind(0, update_program);
+            // Fill texture with height data
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, u.world.w, u.world.h, GL_RED, GL_FLOAT, buffer.data());
 
-                fbo_bound = true;       
-            }
+            // Render quad to fill in new area
+            const auto& r = u.texture;
+            glUniform4f(update_program->attr(uniform_rect), (float)r.x, (float)r.y, (float)r.w, (float)r.h);
+            quad_update->render(update_program);
 
-            // If this level hasn't been translated, perform a full rebuild of level
-            if (level.last_shift.x == 0.0f && level.last_shift.y == 0.0f)
+            // Render section that wraps around the sampler edge
+            if (r.y + r.h > texture_size)
             {
-                Rect r = { 
-                    // need to convert origin from world to texture coordinates
-                    (int)std::floor(level.origin.x / level.scale), 
-                    (int)std::floor(level.origin.y / level.scale), 
-                    level_size + 1, level_size + 1
-                };
-
-                //logger << "Rebuild " << level.index << " [" << r.x << "," << r.y << "]" << std::endl;
-                height_map->get_data(level.index, r, buffer);
-                elevation_maps->bind(0);
-                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, level.index, r.w, r.h, 1,
-                    GL_RED, GL_FLOAT, buffer.data());
-
-                level.u = 0; level.v = 0;
+                glUniform4f(update_program->attr(uniform_rect), 
+                    (float)r.x, (float)(r.y - texture_size), (float)r.w, (float)r.h);
+                quad_update->render(update_program);
             }
-            else
+            else if (r.x + r.w > texture_size)
             {
-                // Sampling rect in world space
-                Rect r_world;
-                // Rect to replace in texture space
-                Rect r_texture;
-
-				// Make layer elevation map render target for framebuffer
-                glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, elevation_maps->id, 0, level.index);
-
-                // Compute new texture offset
-                auto last_u = level.u;
-                auto last_v = level.v;
-                level.u = pos_mod(level.u + (int)level.last_shift.x, texture_size);
-                level.v = pos_mod(level.v + (int)level.last_shift.y, texture_size);
-
-                // horizontal shift
-                if (level.last_shift.x != 0.0f)
-                {
-                    if (level.last_shift.x < 0.0f) 
-                    {
-                        r_world.x = (int)std::floor(level.origin.x / level.scale);
-                        r_world.y = (int)std::floor(level.origin.y / level.scale);
-                        r_world.w = (int)std::abs(level.last_shift.x);
-                        r_world.h = texture_size;
-                        r_texture.x = level.u;
-                        r_texture.y = level.v;
-                        r_texture.w = r_world.w;
-                        r_texture.h = texture_size;
-                    }
-                    else 
-                    {
-                        r_world.x = (int)(std::floor(level.origin.x / level.scale) - level.last_shift.x) + texture_size;
-                        r_world.y = (int)std::floor(level.origin.y / level.scale);
-                        r_world.w = (int)std::abs(level.last_shift.x);
-                        r_world.h = texture_size;
-                        r_texture.x = last_u;
-                        r_texture.y = level.v;
-                        r_texture.w = r_world.w;
-                        r_texture.h = texture_size;
-                    }
-
-                    // Fill texture with height data
-                    height_map->get_data(level.index, r_world, buffer);
-                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, r_world.w, r_world.h, GL_RED, GL_FLOAT, buffer.data());
-
-                    // Render quad to fill in new area
-                    glUniform4f(update_program->attr(uniform_rect), 
-                        (float)r_texture.x, (float)r_texture.y, (float)r_texture.w, (float)r_texture.h);
-                    quad_update->render(update_program);
-
-                    if (r_texture.y != texture_size)
-                    {
-                        glUniform4f(update_program->attr(uniform_rect), 
-                            (float)r_texture.x, (float)(r_texture.y - texture_size), (float)r_texture.w, (float)r_texture.h);
-                        quad_update->render(update_program);
-                    }
-                }
-
-                // vertical shift
-                if (level.last_shift.y != 0.0f)
-                {
-                    if (level.last_shift.y < 0.0f) 
-                    {
-                        r_world.x = (int)std::floor(level.origin.x / level.scale);
-                        r_world.y = (int)std::floor(level.origin.y / level.scale);
-                        r_world.w = texture_size;
-                        r_world.h = (int)std::abs(level.last_shift.y);
-                        r_texture.x = level.u;
-                        r_texture.y = level.v;
-                        r_texture.w = texture_size;
-                        r_texture.h = r_world.h;
-                    }
-                    else 
-                    {
-                        r_world.x = (int)std::floor(level.origin.x / level.scale);
-                        r_world.y = (int)(std::floor(level.origin.y / level.scale) - level.last_shift.y) + texture_size;
-                        r_world.w = texture_size;
-                        r_world.h = (int)std::abs(level.last_shift.y);
-                        r_texture.x = level.u;
-                        r_texture.y = last_v;
-                        r_texture.w = texture_size;
-                        r_texture.h = r_world.h;
-                    }
-
-                    // Fill texture with height data
-                    height_map->get_data(level.index, r_world, buffer);
-                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, r_world.w, r_world.h, GL_RED, GL_FLOAT, buffer.data());
-
-                    // Render quad to fill in new area
-                    glUniform4f(update_program->attr(uniform_rect), 
-                        (float)r_texture.x, (float)r_texture.y, (float)r_texture.w, (float)r_texture.h);
-                    quad_update->render(update_program);
-
-                    if (r_texture.x != texture_size)
-                    {
-                        glUniform4f(update_program->attr(uniform_rect), 
-                            (float)(r_texture.x - texture_size), (float)r_texture.y, (float)r_texture.w, (float)r_texture.h);
-                        quad_update->render(update_program);
-                    }
-                }
-
-                perfc.inc(PerformanceCounter::FRAME_BUFFERS);
+                glUniform4f(update_program->attr(uniform_rect), 
+                    (float)(r.x - texture_size), (float)r.y, (float)r.w, (float)r.h);
+                quad_update->render(update_program);
             }
 
-            level.is_dirty = false;
-            max_index = level.index;
+            perfc.inc(PerformanceCounter::FRAME_BUFFERS);
         }
 
-        if (fbo_bound)
-        {
-            fb_update->unbind();
-			game->get_renderer()->reset_viewport();
-		}
+        fb_update->unbind();
+        game->get_renderer()->reset_viewport();
 
         return max_index;
     }
@@ -633,7 +342,7 @@ namespace dukat
 			// the border of the normal map. Multiply by 2 since normal map
 			// is twice the size of elevation sampler.
 			glUniform2f(normal_program->attr(uniform_tex_offset), 
-				2.0f * (float)levels[i].u, 2.0f * (float)levels[i].v);
+				2.0f * (float)state.get_level(i).u, 2.0f * (float)state.get_level(i).v);
             
             // Make layer normal map render target for framebuffer
             glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, normal_maps->id, 0, i);
@@ -649,7 +358,31 @@ namespace dukat
 
     void ClipMap::render_level(const Camera3& cam, int level_idx)
     {
-        const auto& level = levels[level_idx];
+        const auto& level = state.get_level(level_idx);
+        const auto& inner_offsets = state.get_inner_offsets();
+        const auto& block_offsets = state.get_block_offsets();
+
+        // Test whole level first; blocks only need to be tested against the
+        // planes the level straddles.
+        const auto& frustum = cam.get_frustum();
+        uint8_t plane_mask = 0;
+        if (culling)
+        {
+            perfc.inc(PerformanceCounter::BB_CHECKS);
+            if (frustum.classify(level.bounding_boxes[ClipMapLevel::bb_level_idx], Frustum::all_planes, &plane_mask) == Frustum::Outside)
+            {
+                return;
+            }
+        }
+        std::array<int8_t, 12> block_results;
+        block_results.fill(Frustum::Inside);
+        const auto first_block = (level_idx == state.get_min_level()) ? ClipMapLevel::bb_inner_idx : ClipMapLevel::bb_block_idx;
+        const auto num_blocks = (level_idx == state.get_min_level()) ? 4 : 12;
+        if (plane_mask != 0)
+        {
+            frustum.classify(&level.bounding_boxes[first_block], num_blocks, block_results.data(), plane_mask);
+            perfc.inc(PerformanceCounter::BB_CHECKS, num_blocks);
+        }
 
         // Transition width - determines how wide the area of blending is
         auto w = level.width / 10.0f;
@@ -690,8 +423,8 @@ namespace dukat
 		glUniform4f(program->attr("u_color"), 0.0f, 0.0f, color_factor, 1.0f);
 
 		// Pass in texture offset of current level within coarser level
-        auto base_offset_x = (level_idx + 1) < num_levels ? (float)levels[level_idx + 1].u : 0.0f;
-        auto base_offset_y = (level_idx + 1) < num_levels ? (float)levels[level_idx + 1].v : 0.0f;
+        auto base_offset_x = (level_idx + 1) < num_levels ? (float)state.get_level(level_idx + 1).u : 0.0f;
+        auto base_offset_y = (level_idx + 1) < num_levels ? (float)state.get_level(level_idx + 1).v : 0.0f;
 		glUniform4f(program->attr(uniform_tex_offset),
             (float)level.u * model.m[4], (float)level.v * model.m[5],
 			base_offset_x * model.m[4], base_offset_y * model.m[5]);
@@ -703,12 +436,12 @@ namespace dukat
 			(level.is_bottom() ? (float)block_size - 1.0f : (float)block_size) * model.m[5]);
 
         // Handle min level as special case
-        if (level_idx == min_level)
+        if (level_idx == state.get_min_level())
         {
             // Render innermost level
             for (int i = 0; i < 4; i++)
             {
-                if (culling && cam.is_clipped(level.bounding_boxes[ClipMapLevel::bb_inner_idx + i]))
+                if (block_results[i] == Frustum::Outside)
                 {
                     continue;
                 }            
@@ -725,7 +458,7 @@ namespace dukat
             // Render 12 <B> blocks
             for (int i = 0; i < 12; i++)
             {
-                if (culling && cam.is_clipped(level.bounding_boxes[ClipMapLevel::bb_block_idx + i]))
+                if (block_results[i] == Frustum::Outside)
                 {
                     continue;
                 }            
@@ -749,7 +482,7 @@ namespace dukat
             model.m[2] = level.origin.x; model.m[3] = level.origin.y; 
             model.m[6] = 0.0f; model.m[7] = 0.0f;
             glUniformMatrix4fv(program->attr(Renderer::uf_model), 1, false, model.m);
-            auto buffer_idx = (int)levels[level_idx - 1].orientation;
+            auto buffer_idx = (int)state.get_level(level_idx - 1).orientation;
             fill_mesh[buffer_idx]->render(program);
         }
 
@@ -775,7 +508,7 @@ namespace dukat
         color_map->bind(2, program);
 
         // Render primitives for each visible level 
-        for (auto i = min_level; i < num_levels; i++)
+        for (auto i = state.get_min_level(); i < num_levels; i++)
         {
             render_level(*cam, i);
         }
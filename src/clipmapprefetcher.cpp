@@ -0,0 +1,165 @@
+#include "stdafx.h"
+#include <dukat/clipmapprefetcher.h>
+#include <dukat/clipmaplevel.h>
+#include <dukat/heightmap.h>
+
+namespace dukat
+{
+	// Number of texels a level moves per shift.
+	static constexpr int shift_size = 2;
+
+	ClipMapPrefetcher::ClipMapPrefetcher(const HeightMap* height_map, int num_levels, int texture_size, bool async)
+		: height_map(height_map), num_levels(num_levels), texture_size(texture_size), blocks(num_levels),
+		velocity(0.0f, 0.0f), last_pos(0.0f, 0.0f), has_last_pos(false), stats{ 0, 0, 0, 0 }
+	{
+		if (async)
+		{
+			worker = std::make_unique<ThreadPool>(1);
+		}
+	}
+
+	ClipMapPrefetcher::~ClipMapPrefetcher(void)
+	{
+		clear();
+	}
+
+	void ClipMapPrefetcher::update_observer(const Vector3& pos, float delta)
+	{
+		const Vector2 cur_pos{ pos.x, pos.z };
+		if (has_last_pos && delta > 0.0f)
+		{
+			// exponential smoothing to filter out jitter in frame times
+			const auto cur_velocity = (cur_pos - last_pos) / delta;
+			const auto k = std::min(1.0f, 8.0f * delta);
+			velocity = velocity + (cur_velocity - velocity) * k;
+		}
+		last_pos = cur_pos;
+		has_last_pos = true;
+	}
+
+	static inline bool contains(const Rect& outer, const Rect& inner)
+	{
+		return inner.x >= outer.x && inner.y >= outer.y
+			&& inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h;
+	}
+
+	void ClipMapPrefetcher::request(int level, const Rect& rect, std::vector<std::shared_ptr<Block>>& keep)
+	{
+		for (auto& b : blocks[level])
+		{
+			if (contains(b->rect, rect))
+			{
+				keep.push_back(b);
+				return;
+			}
+		}
+
+		auto block = std::make_shared<Block>();
+		block->level = level;
+		block->rect = rect;
+		block->used = false;
+		block->data.resize(rect.w * rect.h);
+		auto hm = height_map;
+		std::weak_ptr<Block> ref = block;
+		auto task = [hm, ref](void) {
+			// skip blocks that were dropped before they were sampled
+			if (auto b = ref.lock())
+			{
+				hm->get_data(b->level, b->rect, b->data);
+			}
+		};
+		if (worker != nullptr)
+		{
+			block->pending = worker->submit(task).share();
+		}
+		else
+		{
+			task();
+		}
+		keep.push_back(block);
+		stats.requests++;
+	}
+
+	void ClipMapPrefetcher::predict(const std::vector<ClipMapLevel>& levels)
+	{
+		const auto sx = (velocity.x > min_speed) ? 1 : ((velocity.x < -min_speed) ? -1 : 0);
+		const auto sy = (velocity.y > min_speed) ? 1 : ((velocity.y < -min_speed) ? -1 : 0);
+
+		std::vector<std::shared_ptr<Block>> keep;
+		for (const auto& level : levels)
+		{
+			if (level.index >= num_levels)
+				break;
+
+			keep.clear();
+			// Origin in texture space
+			const auto ox = (int)std::floor(level.origin.x / level.scale);
+			const auto oy = (int)std::floor(level.origin.y / level.scale);
+			// Strips are extended by a shift in both directions along the other axis,
+			// so they remain valid if the level moves diagonally.
+			if (sx != 0)
+			{
+				const auto x = (sx > 0) ? ox + texture_size : ox - shift_size;
+				request(level.index, Rect{ x, oy - shift_size, shift_size, texture_size + 2 * shift_size }, keep);
+			}
+			if (sy != 0)
+			{
+				const auto y = (sy > 0) ? oy + texture_size : oy - shift_size;
+				request(level.index, Rect{ ox - shift_size, y, texture_size + 2 * shift_size, shift_size }, keep);
+			}
+
+			for (const auto& b : blocks[level.index])
+			{
+				if (!b->used && std::find(keep.begin(), keep.end(), b) == keep.end())
+				{
+					stats.discarded++;
+				}
+			}
+			blocks[level.index].swap(keep);
+		}
+	}
+
+	bool ClipMapPrefetcher::fetch(int level, const Rect& rect, std::vector<float>& buffer)
+	{
+		for (auto& b : blocks[level])
+		{
+			const auto& r = b->rect;
+			if (!contains(r, rect))
+				continue;
+
+			if (b->pending.valid())
+			{
+				b->pending.wait();
+			}
+
+			// copy sub-rect row by row
+			auto dst = buffer.begin();
+			for (auto y = 0; y < rect.h; y++)
+			{
+				auto src = b->data.begin() + (rect.y - r.y + y) * r.w + (rect.x - r.x);
+				dst = std::copy(src, src + rect.w, dst);
+			}
+			b->used = true;
+			stats.hits++;
+			return true;
+		}
+
+		stats.misses++;
+		return false;
+	}
+
+	void ClipMapPrefetcher::clear(void)
+	{
+		for (auto& level_blocks : blocks)
+		{
+			for (auto& b : level_blocks)
+			{
+				if (b->pending.valid())
+				{
+					b->pending.wait();
+				}
+			}
+			level_blocks.clear();
+		}
+	}
+}
@@ -0,0 +1,317 @@
+#include "stdafx.h"
+#include <dukat/clipmapstate.h>
+#include <dukat/bit.h>
+#include <dukat/heightmap.h>
+#include <dukat/mathutil.h>
+
+namespace dukat
+{
+	ClipMapState::ClipMapState(int num_levels, int level_size, const HeightMap* height_map)
+		: num_levels(num_levels), level_size(level_size), texture_size(level_size + 1),
+		height_map(height_map), min_level(0)
+	{
+		build_offsets();
+		build_levels();
+	}
+
+	void ClipMapState::build_offsets(void)
+	{
+		const auto inner_size = (level_size + 1) / 2;
+		const auto inner_width = (float)(inner_size - 1);
+
+		// compute offsets for 4 inner buffers in row-order from top-left to bottom-right
+		inner_offsets[0] = { inner_width, inner_width };
+		inner_offsets[1] = { 0.0f, inner_width };
+		inner_offsets[2] = { inner_width, 0.0f };
+		inner_offsets[3] = { 0.0f, 0.0f };
+
+		// compute offsets of all 12 blocks in row-order from top-left to bottom-right
+		const auto block_size = (level_size + 1) / 4;
+		const auto block_width = (float)(block_size - 1);
+		block_offsets[0] = { 2.0f + 3.0f * block_width, 2.0f + 3.0f * block_width };
+		block_offsets[1] = { 2.0f + 2.0f * block_width, 2.0f + 3.0f * block_width };
+		block_offsets[2] = { block_width, 2.0f + 3.0f * block_width };
+		block_offsets[3] = { 0.0f, 2.0f + 3.0f * block_width };
+		block_offsets[4] = { 2.0f + 3.0f * block_width, 2.0f + 2.0f * block_width };
+		block_offsets[5] = { 0.0f, 2.0f + 2.0f * block_width };
+		block_offsets[6] = { 2.0f + 3.0f * block_width, block_width };
+		block_offsets[7] = { 0.0f, block_width };
+		block_offsets[8] = { 2.0f + 3.0f * block_width, 0.0f };
+		block_offsets[9] = { 2.0f + 2.0f * block_width, 0.0f };
+		block_offsets[10] = { block_width, 0.0f };
+		block_offsets[11] = { 0.0f, 0.0f };
+	}
+
+	void ClipMapState::build_levels(void)
+	{
+		const auto min_z = 0.0f;
+		const auto max_z = height_map->get_scale_factor();
+		const auto inner_size = (level_size + 1) / 2;
+		const auto block_size = (level_size + 1) / 4;
+
+		for (int i = 0; i < num_levels; i++)
+		{
+			ClipMapLevel level(i);
+
+			if (i == 0)
+			{
+				level.orientation = ClipMapLevel::bottom_right;
+				level.scale = 1.0f;
+				level.origin = Vector2{ 0.0f, 0.0f };
+			}
+			else
+			{
+				auto& prev_level = levels[i - 1];
+
+				// Origin of each level is shifted by size of next finer level 
+				// in both x and z direction (sign based on right / bottom flags)
+				level.orientation = (prev_level.orientation == ClipMapLevel::bottom_right)
+					? ClipMapLevel::top_left : ClipMapLevel::bottom_right;
+				level.scale = 2.0f * prev_level.scale;
+
+				// Check if orientation is left
+				auto x_shift = (prev_level.orientation & 0x2) == 0x0
+					? -level.scale * (float)(block_size - 1) : -level.scale * block_size;
+				// Check if oriengation is up
+				auto y_shift = (prev_level.orientation & 0x1) == 0x0
+					? -level.scale * (float)(block_size - 1) : -level.scale * block_size;
+				level.origin = Vector2{ prev_level.origin.x + x_shift, prev_level.origin.y + y_shift };
+			}
+			level.width = level.scale * (float)(level_size - 1);
+			level.half_width = 0.5f * level.width;
+				
+			// generate inner boxes 
+			for (int i = ClipMapLevel::bb_inner_idx; i < ClipMapLevel::bb_block_idx; i++)
+			{
+				auto tmp = level.origin + inner_offsets[i - ClipMapLevel::bb_inner_idx] * level.scale;
+				level.bounding_boxes[i].min = Vector3{ tmp.x, min_z, tmp.y };
+				level.bounding_boxes[i].max = Vector3{ tmp.x + (inner_size - 1) * level.scale, max_z, tmp.y + (inner_size - 1) * level.scale };
+			}
+
+			// generates block boxes 
+			for (int i = ClipMapLevel::bb_block_idx; i < ClipMapLevel::bb_level_idx; i++)
+			{
+				auto tmp = level.origin + block_offsets[i - ClipMapLevel::bb_block_idx] * level.scale;
+				level.bounding_boxes[i].min = Vector3{ tmp.x, min_z, tmp.y };
+				level.bounding_boxes[i].max = Vector3{ tmp.x + (block_size - 1) * level.scale, max_z, tmp.y + (block_size - 1) * level.scale };
+			}
+
+			// level box used to cull all blocks of a level at once
+			auto& level_bb = level.bounding_boxes[ClipMapLevel::bb_level_idx];
+			level_bb.clear();
+			for (int i = 0; i < ClipMapLevel::bb_level_idx; i++)
+			{
+				level_bb.add(level.bounding_boxes[i]);
+			}
+
+			levels.push_back(level);
+		}
+	}
+
+	void ClipMapState::update(const Vector3& observer_pos)
+	{
+		// determine height of observer and set min_level accordingly
+		auto height = height_map->get_scale_factor() * height_map->get_elevation((int)std::round(observer_pos.x), (int)std::round(observer_pos.z), 0);
+		min_level = 0;
+		while (min_level < (int)levels.size() && levels[min_level].width < 2.5f * (observer_pos.y - height))
+		{
+			min_level++;
+		}
+
+		update_levels(observer_pos);
+	}
+
+	void ClipMapState::update_levels(const Vector3& observer_pos)
+	{
+		// Check if we need to update the origin of the most fine-grained level.
+		const uint8_t down = 1;
+		const uint8_t up = 2;
+		const uint8_t right = 4;
+		const uint8_t left = 8;
+		uint8_t update_flags = 0;
+
+		auto it = levels.begin();
+
+		// Threshold for update is: 2 grid spaces * level.scale 
+		auto grid_size = 2.0f * (*it).scale;
+		// compute delta between origin and camera 
+		auto dx = observer_pos.x - ((*it).origin.x + (*it).half_width);
+		auto dy = observer_pos.z - ((*it).origin.y + (*it).half_width);
+		// Moving left
+		if (dx > grid_size)
+			update_flags |= left;
+		// Moving right
+		else if (dx < -grid_size)
+			update_flags |= right;
+		// Moving up
+		if (dy > grid_size)
+			update_flags |= up;
+		// Moving down
+		else if (dy < -grid_size)
+			update_flags |= down;
+
+		Vector2 offset_shift;
+		while (it != levels.end() && update_flags != 0)
+		{
+			auto& level = *it;
+			level.is_dirty = true;
+			// Each test will move the origin of the current level and then
+			// check the level's orientation within the next coarser level
+			// to see if that one needs to be updated as well.
+			if (check_flag(update_flags, left))
+			{
+				offset_shift.x = grid_size;
+				if (level.is_right())
+				{
+					level.orientation |= 0x2; // flip to left side
+					update_flags &= (~left); // clear left update flag
+				}
+				else
+				{
+					level.orientation &= 0x1;
+				}
+			}
+			else if (check_flag(update_flags, right)) 
+			{
+				offset_shift.x = -grid_size;
+				if (level.is_left())
+				{
+					level.orientation &= 0x1; // flip to right side 
+					update_flags &= (~right);
+				}
+				else
+				{
+					level.orientation |= 0x2;
+				}
+			}
+			else
+			{
+				offset_shift.x = 0.0f;
+			}
+
+			if (check_flag(update_flags, up))
+			{
+				offset_shift.y = grid_size;
+				if (level.is_bottom())
+				{
+					level.orientation |= 0x1; // flip to top side
+					update_flags &= (~up);
+				}
+				else
+				{
+					level.orientation &= 0x2;
+				}
+			}
+			else if (check_flag(update_flags, down))
+			{
+				offset_shift.y = -grid_size;
+				if (level.is_top())
+				{
+					level.orientation &= 0x2; // flip to bottom side
+					update_flags &= (~down);
+				}
+				else
+				{
+					level.orientation |= 0x1;
+				}
+			}
+			else
+			{
+				offset_shift.y = 0.0f;
+			}
+
+			level.translate(offset_shift);
+
+			grid_size *= 2.0f;
+			++it;
+		}
+	}
+
+
+	int ClipMapState::collect_updates(std::vector<ClipMapUpdate>& updates)
+	{
+		int max_index = -1;
+
+		// If the last_shift for a level is 0, the full sampler is rebuilt. Otherwise, 
+		// only the section that was exposed by the shift is refreshed using torroidal
+		// addressing. Depending on the last_shift motion (x, y, or x+y) this results
+		// in 1 or 2 updates per level.
+		for (auto& level : levels)
+		{
+			if (!level.is_dirty)
+				continue;
+
+			// convert origin from world to texture coordinates
+			const auto origin_x = (int)std::floor(level.origin.x / level.scale);
+			const auto origin_y = (int)std::floor(level.origin.y / level.scale);
+
+			// If this level hasn't been translated, perform a full rebuild of level
+			if (level.last_shift.x == 0.0f && level.last_shift.y == 0.0f)
+			{
+				updates.push_back(ClipMapUpdate{ level.index, 
+					Rect{ origin_x, origin_y, texture_size, texture_size }, 
+					Rect{ 0, 0, texture_size, texture_size }, true });
+				level.u = 0; level.v = 0;
+			}
+			else
+			{
+				// Compute new texture offset
+				const auto last_u = level.u;
+				const auto last_v = level.v;
+				level.u = pos_mod(level.u + (int)level.last_shift.x, texture_size);
+				level.v = pos_mod(level.v + (int)level.last_shift.y, texture_size);
+
+				// horizontal shift
+				if (level.last_shift.x != 0.0f)
+				{
+					ClipMapUpdate u{ level.index, Rect{}, Rect{}, false };
+					u.world.w = (int)std::abs(level.last_shift.x);
+					u.world.h = texture_size;
+					u.world.y = origin_y;
+					u.texture.y = level.v;
+					if (level.last_shift.x < 0.0f)
+					{
+						u.world.x = origin_x;
+						u.texture.x = level.u;
+					}
+					else
+					{
+						u.world.x = origin_x - (int)level.last_shift.x + texture_size;
+						u.texture.x = last_u;
+					}
+					u.texture.w = u.world.w;
+					u.texture.h = u.world.h;
+					updates.push_back(u);
+				}
+
+				// vertical shift
+				if (level.last_shift.y != 0.0f)
+				{
+					ClipMapUpdate u{ level.index, Rect{}, Rect{}, false };
+					u.world.w = texture_size;
+					u.world.h = (int)std::abs(level.last_shift.y);
+					u.world.x = origin_x;
+					u.texture.x = level.u;
+					if (level.last_shift.y < 0.0f)
+					{
+						u.world.y = origin_y;
+						u.texture.y = level.v;
+					}
+					else
+					{
+						u.world.y = origin_y - (int)level.last_shift.y + texture_size;
+						u.texture.y = last_v;
+					}
+					u.texture.w = u.world.w;
+					u.texture.h = u.world.h;
+					updates.push_back(u);
+				}
+			}
+
+			level.is_dirty = false;
+			max_index = level.index;
+		}
+
+		return max_index;
+	}
+}
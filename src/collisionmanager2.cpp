@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include <dukat/collisionmanager2.h>
 #include <dukat/debugeffect2.h>
+#include <dukat/gamebase.h>
+#include <dukat/profiler.h>
 
 namespace dukat
 {
@@ -31,7 +33,7 @@ namespace dukat
 			auto other_body = c->body1 == body ? c->body2 : c->body1;
 			if (other_body->owner != nullptr)
 			{
-				other_body->owner->trigger(Message{ Events::CollisionEnd, body });
+				game->get_events()->post(other_body->owner, Message{ Events::CollisionEnd, body });
 			}
 			contacts.erase(hash(c->body1, c->body2));
 		}
@@ -41,6 +43,9 @@ namespace dukat
 		if (it != bodies.end())
 		{
 			trigger(Message{ Events::BodyDestroyed, (*it).get(), nullptr });
+			// tree keeps referring to body until next update
+			(*it)->active = false;
+			destroyed.push_back(std::move(*it));
 			bodies.erase(it);
 		}
 	}
@@ -81,25 +86,28 @@ namespace dukat
 				c.age = 0;
 				contacts[id] = c;
 
+				auto events = game->get_events();
 				if (c.body1->owner != nullptr)
-					c.body1->owner->trigger(Message{ Events::CollisionBegin, c.body2, &c });
+					events->post(c.body1->owner, Events::CollisionBegin, c.body2, c);
 				if (c.body2->owner != nullptr)
-					c.body2->owner->trigger(Message{ Events::CollisionBegin, c.body1, &c });
+					events->post(c.body2->owner, Events::CollisionBegin, c.body1, c);
 			}
 		}
 	}
 
 	void CollisionManager2::resolve_collisions(void)
 	{
+		PROFILE_SCOPE("collision.resolve");
 		for (auto it = contacts.begin(); it != contacts.end(); )
 		{
 			// clean up contacts which are no longer active
 			if (it->second.generation != generation)
 			{
+				auto events = game->get_events();
 				if (it->second.body1->owner != nullptr)
-					it->second.body1->owner->trigger(Message{ Events::CollisionEnd, it->second.body2 });
+					events->post(it->second.body1->owner, Message{ Events::CollisionEnd, it->second.body2 });
 				if (it->second.body2->owner != nullptr)
-					it->second.body2->owner->trigger(Message{ Events::CollisionEnd, it->second.body1 });
+					events->post(it->second.body2->owner, Message{ Events::CollisionEnd, it->second.body1 });
 				it = contacts.erase(it);
 			}
 			// attempt to resolve active contacts
@@ -116,7 +124,7 @@ namespace dukat
 						const auto b1_shift = shift * mfactor;
 						b1->bb += b1_shift;
 						if (b1->owner != nullptr)
-							b1->owner->trigger(Message{ Events::CollisionResolve, &b1_shift });
+							game->get_events()->post(b1->owner, Events::CollisionResolve, b1_shift);
 					}
 					if (b2->dynamic)
 					{
@@ -124,7 +132,7 @@ namespace dukat
 						const auto b2_shift = -shift * mfactor;
 						b2->bb += b2_shift;
 						if (b2->owner != nullptr)
-							b2->owner->trigger(Message{ Events::CollisionResolve, &b2_shift });
+							game->get_events()->post(b2->owner, Events::CollisionResolve, b2_shift);
 					}
 				}
 
@@ -146,41 +154,52 @@ namespace dukat
 
 	void CollisionManager2::update(float delta)
 	{
+		PROFILE_SCOPE("collision.update");
+		// messages with bodies retired last update have been delivered by now
+		retired.clear();
+		retired.swap(destroyed);
+
 		// broad phase - determine all possible collisions
-		tree->clear();
-		for (const auto& b : bodies)
 		{
-			if (b->active)
+			PROFILE_SCOPE("collision.broad");
+			tree->clear();
+			for (const auto& b : bodies)
 			{
-				perfc.inc(PerformanceCounter::BODIES);
-				tree->insert(b.get());
+				if (b->active)
+				{
+					perfc.inc(PerformanceCounter::BODIES);
+					tree->insert(b.get());
+				}
 			}
 		}
 
 		// narrow phase - build up set of actual collisions
-		std::queue<QuadTree<Body>*> nodes;
-		for (const auto& b : bodies)
 		{
-			if (!b->active)
-				continue;
-
-			// Start with root, compare with each child
-			nodes.push(tree.get());
-			auto this_body = b.get();
-			while (!nodes.empty())
+			PROFILE_SCOPE("collision.narrow");
+			std::queue<QuadTree<Body>*> nodes;
+			for (const auto& b : bodies)
 			{
-				auto t = nodes.front();
-				auto idx = t->get_index(this_body);
-				if (idx > -1 && t->has_child(idx))
-				{
-					nodes.push(t->child(idx));
-				}
-				const auto& values = t->get_values();
-				for (auto& it : values)
+				if (!b->active)
+					continue;
+
+				// Start with root, compare with each child
+				nodes.push(tree.get());
+				auto this_body = b.get();
+				while (!nodes.empty())
 				{
-					test_collision(this_body, it);
+					auto t = nodes.front();
+					auto idx = t->get_index(this_body);
+					if (idx > -1 && t->has_child(idx))
+					{
+						nodes.push(t->child(idx));
+					}
+					const auto& values = t->get_values();
+					for (auto& it : values)
+					{
+						test_collision(this_body, it);
+					}
+					nodes.pop();
 				}
-				nodes.pop();
 			}
 		}
 
@@ -216,7 +235,7 @@ namespace dukat
 		std::list<Body*> res;
 		for (Body* b : candidates)
 		{
-			if (b->bb.contains(p))
+			if (b->active && b->bb.contains(p))
 			{
 				res.push_back(b);
 			}
@@ -224,4 +243,25 @@ namespace dukat
 
 		return res;
 	}
-}
\ No newline at end of file
+
+	void CollisionManager2::collect_static_bodies(std::vector<const Body*>& res) const
+	{
+		std::queue<const QuadTree<Body>*> nodes;
+		nodes.push(tree.get());
+		while (!nodes.empty())
+		{
+			auto t = nodes.front();
+			nodes.pop();
+			for (auto i = 0; i < 4; i++)
+			{
+				if (t->has_child(i))
+					nodes.push(t->child(i));
+			}
+			for (auto b : t->get_values())
+			{
+				if (b->active && !b->dynamic && b->solid)
+					res.push_back(b);
+			}
+		}
+	}
+}
@@ -0,0 +1,18 @@
+#include "stdafx.h"
+#include <dukat/delegate.h>
+#include <atomic>
+
+namespace dukat
+{
+	static std::atomic<long> allocations(0l);
+
+	long delegate_allocations(void)
+	{
+		return allocations.load(std::memory_order_relaxed);
+	}
+
+	void count_delegate_allocation(void)
+	{
+		allocations.fetch_add(1l, std::memory_order_relaxed);
+	}
+}
@@ -1,118 +1,252 @@
 #include "stdafx.h"
 #include <dukat/diamondsquaregenerator.h>
+#include <dukat/mathutil.h>
 #include <dukat/rand.h>
+#include <dukat/threadpool.h>
 
 namespace dukat
 {
-	void set(HeightMap::Level& level, int x, int y, float val)
+	// Minimum number of samples processed per parallel work item.
+	static constexpr int min_samples_per_task = 4096;
+
+	static inline bool is_pow_two(int v)
 	{
-		if (x < 0)
-		{
-			x += level.size;
-		}
-		else if (x >= level.size)
-		{
-			x -= level.size;
-		}
-		if (y < 0)
-		{
-			y += level.size;
-		}
-		else if (y >= level.size)
-		{
-			y -= level.size;
-		}
-		level[y * level.size + x] = val;
+		return v > 0 && (v & (v - 1)) == 0;
 	}
 
-	float get(HeightMap::Level& level, int x, int y)
+	static inline int row_grain(int samples_per_row)
 	{
-		if (x < 0)
-		{
-			x += level.size;
-		}
-		else if (x >= level.size)
+		return std::max(1, min_samples_per_task / std::max(1, samples_per_row));
+	}
+
+	// Largest possible magnitude of a generated sample before normalization.
+	static inline float max_amplitude(float roughness, int period)
+	{
+		auto res = 0.0f;
+		for (auto step = period; step > 1; step /= 2)
 		{
-			x -= level.size;
+			res += roughness * (float)step;
 		}
-		if (y < 0)
+		return res;
+	}
+
+	float DiamondSquareGenerator::offset(int x, int y, int pass, float scale) const
+	{
+		return hash_random(-scale, scale, static_cast<uint32_t>(seed), static_cast<uint32_t>(x),
+			static_cast<uint32_t>(y), static_cast<uint32_t>(pass));
+	}
+
+	void DiamondSquareGenerator::generate(HeightMap::Level& level) const
+	{
+		const auto wrap = is_pow_two(level.size);
+		const auto period = wrap ? level.size : level.size - 1;
+		if (!is_pow_two(period))
 		{
-			y += level.size;
+			throw std::runtime_error("Unsupported level size - expected 2^n or 2^n+1.");
 		}
-		else if (y >= level.size)
+
+		// corners start out at 0
+		std::fill(level.data.begin(), level.data.end(), 0.0f);
+		auto pass = 0;
+		for (auto step = period; step > 1; step /= 2, pass++)
 		{
-			y -= level.size;
+			square_pass(level, period, step, pass, wrap);
+			diamond_pass(level, period, step, pass, wrap);
 		}
-		return level[y * level.size + x];
+
+		// Normalize data in [min_val..max_val] range
+		const auto min_z = level.min();
+		const auto max_z = level.max();
+		const auto factor = (max_z > min_z) ? 1.0f / (max_z - min_z) : 0.0f;
+		parallel_for(0, level.size, row_grain(level.size), [&](int row_begin, int row_end) {
+			for (auto y = row_begin; y < row_end; y++)
+			{
+				for (auto x = 0; x < level.size; x++)
+				{
+					auto& val = level[y * level.size + x];
+					auto normalized = (val - min_z) * factor;
+					val = normalized * (max_val - min_val) + min_val;
+				}
+			}
+		});
 	}
-	
-	void DiamondSquareGenerator::generate(HeightMap::Level& level) const
+
+	void DiamondSquareGenerator::square_pass(HeightMap::Level& level, int period, int step, int pass, bool wrap) const
 	{
-		srand(seed);
+		const auto half = step / 2;
+		const auto scale = roughness * (float)step;
+		const auto size = level.size;
+		// only the far edge can exceed the level when wrapping
+		auto idx = [&](int x, int y) { return wrap ? (y == size ? 0 : y) * size + (x == size ? 0 : x) : y * size + x; };
 
-		// set corners
-		set(level, 0, 0, 0.0f);
-		set(level, level.size - 1, 0, 0.0f);
-		set(level, 0, level.size - 1, 0.0f);
-		set(level, level.size - 1, level.size - 1, 0.0f);
-		divide(level, level.size);
+		const auto rows = period / step;
+		parallel_for(0, rows, row_grain(rows), [&](int row_begin, int row_end) {
+			for (auto r = row_begin; r < row_end; r++)
+			{
+				const auto y = half + r * step;
+				for (auto x = half; x < period; x += step)
+				{
+					auto avg = 0.25f * (level[idx(x - half, y - half)] + level[idx(x + half, y - half)] +
+						level[idx(x + half, y + half)] + level[idx(x - half, y + half)]);
+					level[y * size + x] = avg + offset(x, y, pass, scale);
+				}
+			}
+		});
+	}
 
-		// Normalize data in [min_val..max_val] range
-		auto min_z = level.min();
-		auto max_z = level.max();
-		const auto factor = 1.0f / (max_z - min_z);
-		const auto half_size = 0.5f * (float)level.size;
-		for (int y = 0; y < level.size; y++)
-		{
-			for (int x = 0; x < level.size; x++)
+	void DiamondSquareGenerator::diamond_pass(HeightMap::Level& level, int period, int step, int pass, bool wrap) const
+	{
+		const auto half = step / 2;
+		const auto scale = roughness * (float)step;
+		const auto size = level.size;
+		const auto last = wrap ? period - 1 : period; // last sample coordinate
+
+		const auto rows = last / half + 1;
+		parallel_for(0, rows, row_grain(rows), [&](int row_begin, int row_end) {
+			for (auto r = row_begin; r < row_end; r++)
 			{
-				auto val = level[y * level.size + x];
-				auto falloff = 1.0f;
-				auto normalized = (val - min_z) * factor * falloff;
-				level[y * level.size + x] = normalized * (max_val - min_val) + min_val;
+				const auto y = r * half;
+				for (auto x = (y + half) % step; x <= last; x += step)
+				{
+					float avg;
+					if (wrap)
+					{
+						const auto x0 = (x - half + size) % size;
+						const auto x1 = (x + half) % size;
+						const auto y0 = (y - half + size) % size;
+						const auto y1 = (y + half) % size;
+						avg = 0.25f * (level[y0 * size + x] + level[y * size + x1] +
+							level[y1 * size + x] + level[y * size + x0]);
+					}
+					else
+					{
+						// average of neighbors within bounds
+						auto sum = 0.0f;
+						auto count = 0;
+						if (y - half >= 0) { sum += level[(y - half) * size + x]; count++; }
+						if (x + half <= last) { sum += level[y * size + x + half]; count++; }
+						if (y + half <= last) { sum += level[(y + half) * size + x]; count++; }
+						if (x - half >= 0) { sum += level[y * size + x - half]; count++; }
+						avg = sum / (float)count;
+					}
+					level[y * size + x] = avg + offset(x, y, pass, scale);
+				}
 			}
-		}
+		});
 	}
 
-	void DiamondSquareGenerator::divide(HeightMap::Level& level, int size) const
+	// Rectangular grid of lattice samples in map coordinates, used for tile generation.
+	struct LatticeGrid
 	{
-		auto half_size = size / 2;
-		if (half_size < 1)
+		int x0, y0; // coordinates of first sample
+		int w, h; // number of samples
+		int spacing; // distance between samples
+		std::vector<float> data;
+
+		LatticeGrid(int min_x, int min_y, int max_x, int max_y, int spacing) : spacing(spacing)
 		{
-			return;
+			// align outwards to lattice
+			x0 = (int)std::floor((float)min_x / (float)spacing) * spacing;
+			y0 = (int)std::floor((float)min_y / (float)spacing) * spacing;
+			w = ((int)std::ceil((float)max_x / (float)spacing) * spacing - x0) / spacing + 1;
+			h = ((int)std::ceil((float)max_y / (float)spacing) * spacing - y0) / spacing + 1;
+			data.resize(w * h, 0.0f);
 		}
-		
-		auto scale = roughness * (float)size;
-		for (auto y = half_size; y < level.size; y += size)
+
+		int max_x(void) const { return x0 + (w - 1) * spacing; }
+		int max_y(void) const { return y0 + (h - 1) * spacing; }
+		float& at(int x, int y) { return data[((y - y0) / spacing) * w + (x - x0) / spacing]; }
+	};
+
+	void DiamondSquareGenerator::generate_tile(HeightMap::Level& tile, int map_size, int x, int y) const
+	{
+		if (!is_pow_two(map_size))
 		{
-			for (auto x = half_size; x < level.size; x += size)
-			{
-				square(level, x, y, half_size, random(-scale, scale));
-			}
+			throw std::runtime_error("Unsupported map size - expected 2^n.");
 		}
 
-		for (auto y = 0; y <= level.size; y += half_size)
+		// Determine region each pass must cover, from finest pass back to the coarsest.
+		// Each pass needs its own output region plus one sample for diamonds, and squares
+		// along that border need one more sample of the previous pass.
+		struct Region { int min_x, min_y, max_x, max_y; };
+		std::vector<Region> regions; // regions[p] = samples computed by pass p
+		Region needed{ x, y, x + tile.size - 1, y + tile.size - 1 };
+		for (auto step = 2; step <= map_size; step *= 2)
 		{
-			for (auto x = (y + half_size) % size; x <= level.size; x += size)
-			{
-				diamond(level, x, y, half_size, random(-scale, scale));
-			}
+			const auto half = step / 2;
+			LatticeGrid aligned(needed.min_x, needed.min_y, needed.max_x, needed.max_y, half);
+			Region r{ aligned.x0 - half, aligned.y0 - half, aligned.max_x() + half, aligned.max_y() + half };
+			regions.insert(regions.begin(), r);
+			needed = { r.min_x - half, r.min_y - half, r.max_x + half, r.max_y + half };
 		}
 
-		divide(level, half_size);
-	}
+		// coarsest lattice is all 0
+		auto prev = std::make_unique<LatticeGrid>(needed.min_x, needed.min_y, needed.max_x, needed.max_y, map_size);
+		auto pass = 0;
+		for (auto step = map_size; step > 1; step /= 2, pass++)
+		{
+			const auto half = step / 2;
+			const auto scale = roughness * (float)step;
+			const auto& r = regions[pass];
+			auto grid = std::make_unique<LatticeGrid>(r.min_x, r.min_y, r.max_x, r.max_y, half);
 
-	void DiamondSquareGenerator::square(HeightMap::Level& level, int x, int y, int size, float offset) const
-	{
-		auto avg = 0.25f * (get(level, x - size, y - size) + get(level, x + size, y - size) +
-			get(level, x + size, y + size) + get(level, x - size, y + size));
-		set(level, x, y, avg + offset);
-	}
+			// copy previous samples and compute squares
+			parallel_for(0, grid->h, row_grain(grid->w), [&](int row_begin, int row_end) {
+				for (auto j = row_begin; j < row_end; j++)
+				{
+					const auto gy = grid->y0 + j * half;
+					const auto my = pos_mod(gy, step);
+					for (auto i = 0; i < grid->w; i++)
+					{
+						const auto gx = grid->x0 + i * half;
+						const auto mx = pos_mod(gx, step);
+						if (mx == 0 && my == 0)
+						{
+							grid->at(gx, gy) = prev->at(gx, gy);
+						}
+						else if (mx == half && my == half)
+						{
+							auto avg = 0.25f * (prev->at(gx - half, gy - half) + prev->at(gx + half, gy - half) +
+								prev->at(gx + half, gy + half) + prev->at(gx - half, gy + half));
+							grid->at(gx, gy) = avg + offset(pos_mod(gx, map_size), pos_mod(gy, map_size), pass, scale);
+						}
+					}
+				}
+			});
 
-	void DiamondSquareGenerator::diamond(HeightMap::Level& level, int x, int y, int size, float offset) const
-	{
-		auto avg = 0.25f * (get(level, x, y - size) + get(level, x + size, y) +
-			get(level, x, y + size) + get(level, x - size, y));
-		set(level, x, y, avg + offset);
+			// compute diamonds away from grid border
+			parallel_for(1, grid->h - 1, row_grain(grid->w), [&](int row_begin, int row_end) {
+				for (auto j = row_begin; j < row_end; j++)
+				{
+					const auto gy = grid->y0 + j * half;
+					const auto my = pos_mod(gy, step);
+					for (auto i = 1; i < grid->w - 1; i++)
+					{
+						const auto gx = grid->x0 + i * half;
+						const auto mx = pos_mod(gx, step);
+						if ((mx == half) != (my == half))
+						{
+							auto avg = 0.25f * (grid->at(gx, gy - half) + grid->at(gx + half, gy) +
+								grid->at(gx, gy + half) + grid->at(gx - half, gy));
+							grid->at(gx, gy) = avg + offset(pos_mod(gx, map_size), pos_mod(gy, map_size), pass, scale);
+						}
+					}
+				}
+			});
+
+			prev = std::move(grid);
+		}
+
+		// Normalize against maximum amplitude so that adjacent tiles match up
+		const auto amplitude = max_amplitude(roughness, map_size);
+		const auto factor = amplitude > 0.0f ? 0.5f / amplitude : 0.0f;
+		for (auto j = 0; j < tile.size; j++)
+		{
+			for (auto i = 0; i < tile.size; i++)
+			{
+				auto normalized = prev->at(x + i, y + j) * factor + 0.5f;
+				tile[j * tile.size + i] = normalized * (max_val - min_val) + min_val;
+			}
+		}
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,298 @@
+#include "stdafx.h"
+#include <dukat/erosion.h>
+#include <dukat/rand.h>
+#include <dukat/threadpool.h>
+#include <random>
+
+namespace dukat
+{
+	// Minimum number of cells processed per parallel work item.
+	static constexpr int min_cells_per_task = 4096;
+
+	struct BrushSample
+	{
+		int dx, dy;
+		float weight;
+	};
+
+	// Builds normalized erosion brush weights for a given radius.
+	static std::vector<BrushSample> build_brush(int radius)
+	{
+		std::vector<BrushSample> brush;
+		auto sum = 0.0f;
+		for (auto dy = -radius; dy <= radius; dy++)
+		{
+			for (auto dx = -radius; dx <= radius; dx++)
+			{
+				const auto dist = std::sqrt((float)(dx * dx + dy * dy));
+				if (dist < (float)radius)
+				{
+					const auto w = 1.0f - dist / (float)radius;
+					brush.push_back({ dx, dy, w });
+					sum += w;
+				}
+			}
+		}
+		for (auto& b : brush)
+		{
+			b.weight /= sum;
+		}
+		return brush;
+	}
+
+	// Computes bilinear elevation and gradient at a position.
+	static inline void height_and_gradient(const HeightMap::Level& level, float x, float y, float& h, float& gx, float& gy)
+	{
+		const auto ix = (int)x;
+		const auto iy = (int)y;
+		const auto ox = x - (float)ix;
+		const auto oy = y - (float)iy;
+		const auto idx = iy * level.size + ix;
+		const auto h00 = level[idx];
+		const auto h10 = level[idx + 1];
+		const auto h01 = level[idx + level.size];
+		const auto h11 = level[idx + level.size + 1];
+		gx = (h10 - h00) * (1.0f - oy) + (h11 - h01) * oy;
+		gy = (h01 - h00) * (1.0f - ox) + (h11 - h10) * ox;
+		h = h00 * (1.0f - ox) * (1.0f - oy) + h10 * ox * (1.0f - oy) + h01 * (1.0f - ox) * oy + h11 * ox * oy;
+	}
+
+	Erosion::Erosion(int seed) : seed(seed), deterministic(true), tile_size(128), rounds(4),
+		droplets(100000), max_lifetime(30), radius(3), inertia(0.05f), capacity(4.0f), min_capacity(0.01f),
+		erode_speed(0.3f), deposit_speed(0.3f), evaporate_speed(0.01f), gravity(4.0f),
+		thermal_iterations(16), talus(0.002f), thermal_rate(0.5f)
+	{
+	}
+
+	void Erosion::apply(HeightMap::Level& level) const
+	{
+		hydraulic(level);
+		thermal(level);
+	}
+
+	void Erosion::hydraulic(HeightMap::Level& level) const
+	{
+		if (droplets <= 0 || level.size < 2)
+		{
+			return;
+		}
+
+		// Tiles must be big enough so that droplets can leave their tile by a margin
+		// of more than the brush radius.
+		const auto tile = std::max(tile_size, 4 * (radius + 2));
+		const auto size = level.size;
+		auto run_seed = static_cast<uint32_t>(seed);
+		if (!deterministic)
+		{
+			run_seed ^= std::random_device()();
+		}
+
+		const auto num_rounds = std::max(1, rounds);
+		const auto droplets_per_round = static_cast<int64_t>(droplets / num_rounds);
+		const auto map_area = static_cast<int64_t>(size) * static_cast<int64_t>(size);
+
+		struct TileInfo
+		{
+			int index;
+			int min_x, min_y, max_x, max_y;
+		};
+		std::vector<TileInfo> tiles;
+
+		for (auto round = 0; round < num_rounds; round++)
+		{
+			// shift tile grid every round to hide seams between tiles
+			const auto off_x = (int)(hash_random(run_seed, 0u, 0u, 2 * round) % (uint32_t)tile);
+			const auto off_y = (int)(hash_random(run_seed, 0u, 0u, 2 * round + 1) % (uint32_t)tile);
+			const auto tiles_x = (size + off_x + tile - 1) / tile;
+			const auto tiles_y = (size + off_y + tile - 1) / tile;
+
+			// 2x2 checkerboard: tiles of the same color are one tile apart
+			for (auto phase = 0; phase < 4; phase++)
+			{
+				tiles.clear();
+				for (auto ty = (phase >> 1); ty < tiles_y; ty += 2)
+				{
+					for (auto tx = (phase & 1); tx < tiles_x; tx += 2)
+					{
+						tiles.push_back({ ty * tiles_x + tx, tx * tile - off_x, ty * tile - off_y,
+							(tx + 1) * tile - off_x, (ty + 1) * tile - off_y });
+					}
+				}
+
+				parallel_for(0, static_cast<int>(tiles.size()), 1, [&](int begin, int end) {
+					for (auto i = begin; i < end; i++)
+					{
+						const auto& t = tiles[i];
+						const auto area = static_cast<int64_t>(std::min(t.max_x, size) - std::max(t.min_x, 0)) *
+							static_cast<int64_t>(std::min(t.max_y, size) - std::max(t.min_y, 0));
+						const auto count = static_cast<int>(droplets_per_round * area / map_area);
+						erode_tile(level, run_seed, round, t.index, count, t.min_x, t.min_y, t.max_x, t.max_y);
+					}
+				});
+			}
+		}
+	}
+
+	void Erosion::erode_tile(HeightMap::Level& level, uint32_t run_seed, int round, int tile_index, int num_droplets,
+		int min_x, int min_y, int max_x, int max_y) const
+	{
+		static thread_local std::vector<BrushSample> brush;
+		static thread_local int brush_radius = -1;
+		if (brush_radius != radius)
+		{
+			brush = build_brush(radius);
+			brush_radius = radius;
+		}
+
+		const auto size = level.size;
+		// Writes stay within halo + radius + 1 of the tile, which is less than half
+		// the gap between tiles of the same checkerboard color.
+		const auto halo = std::max(tile_size, 4 * (radius + 2)) / 2 - radius - 2;
+		// droplets spawn within tile
+		const auto spawn_min_x = (float)std::max(min_x, 0);
+		const auto spawn_min_y = (float)std::max(min_y, 0);
+		const auto spawn_w = (float)(std::min(max_x, size - 1) - std::max(min_x, 0));
+		const auto spawn_h = (float)(std::min(max_y, size - 1) - std::max(min_y, 0));
+		if (spawn_w <= 0.0f || spawn_h <= 0.0f)
+		{
+			return;
+		}
+		// ... and may travel up to halo cells beyond it
+		const auto lo_x = (float)std::max(min_x - halo, 0);
+		const auto lo_y = (float)std::max(min_y - halo, 0);
+		const auto hi_x = (float)std::min(max_x + halo, size - 1);
+		const auto hi_y = (float)std::min(max_y + halo, size - 1);
+
+		const auto droplet_channel = static_cast<uint32_t>(round) << 16;
+		for (auto d = 0; d < num_droplets; d++)
+		{
+			const auto key = static_cast<uint32_t>(d);
+			auto px = spawn_min_x + hash_random(0.0f, 1.0f, run_seed, static_cast<uint32_t>(tile_index), key, droplet_channel) * spawn_w;
+			auto py = spawn_min_y + hash_random(0.0f, 1.0f, run_seed, static_cast<uint32_t>(tile_index), key, droplet_channel + 1u) * spawn_h;
+			px = std::min(px, hi_x - 0.001f);
+			py = std::min(py, hi_y - 0.001f);
+			auto dir_x = 0.0f;
+			auto dir_y = 0.0f;
+			auto speed = 1.0f;
+			auto water = 1.0f;
+			auto sediment = 0.0f;
+
+			for (auto step = 0; step < max_lifetime; step++)
+			{
+				const auto ix = (int)px;
+				const auto iy = (int)py;
+				const auto ox = px - (float)ix;
+				const auto oy = py - (float)iy;
+
+				float h, gx, gy;
+				height_and_gradient(level, px, py, h, gx, gy);
+
+				// update direction and position
+				dir_x = dir_x * inertia - gx * (1.0f - inertia);
+				dir_y = dir_y * inertia - gy * (1.0f - inertia);
+				const auto len = std::sqrt(dir_x * dir_x + dir_y * dir_y);
+				if (len == 0.0f)
+				{
+					break;
+				}
+				dir_x /= len;
+				dir_y /= len;
+				px += dir_x;
+				py += dir_y;
+				if (px < lo_x || px >= hi_x || py < lo_y || py >= hi_y)
+				{
+					break;
+				}
+
+				float new_h, ngx, ngy;
+				height_and_gradient(level, px, py, new_h, ngx, ngy);
+				const auto dh = new_h - h;
+
+				const auto cap = std::max(-dh * speed * water * capacity, min_capacity);
+				if (sediment > cap || dh > 0.0f)
+				{
+					// deposit on the 4 corners of the cell we just left
+					const auto amount = (dh > 0.0f) ? std::min(dh, sediment) : (sediment - cap) * deposit_speed;
+					sediment -= amount;
+					const auto idx = iy * size + ix;
+					level[idx] += amount * (1.0f - ox) * (1.0f - oy);
+					level[idx + 1] += amount * ox * (1.0f - oy);
+					level[idx + size] += amount * (1.0f - ox) * oy;
+					level[idx + size + 1] += amount * ox * oy;
+				}
+				else
+				{
+					// erode around the cell we just left
+					const auto amount = std::min((cap - sediment) * erode_speed, -dh);
+					for (const auto& b : brush)
+					{
+						const auto x = ix + b.dx;
+						const auto y = iy + b.dy;
+						if (x < 0 || x >= size || y < 0 || y >= size)
+						{
+							continue;
+						}
+						auto& z = level[y * size + x];
+						const auto delta = std::min(z, amount * b.weight);
+						z -= delta;
+						sediment += delta;
+					}
+				}
+
+				speed = std::sqrt(std::max(0.0f, speed * speed - dh * gravity));
+				water *= (1.0f - evaporate_speed);
+			}
+		}
+	}
+
+	void Erosion::thermal(HeightMap::Level& level) const
+	{
+		static const int offsets[8][2] = {
+			{ -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 }
+		};
+		static const float diagonal = std::sqrt(2.0f);
+
+		const auto size = level.size;
+		// material moved between each pair of cells; dividing by number of neighbors
+		// and by 2 (both cells adjust) keeps the update stable.
+		const auto k = 0.5f * thermal_rate / 8.0f;
+		const auto grain = std::max(1, min_cells_per_task / std::max(1, size));
+		std::vector<GLfloat> prev(level.data.size());
+
+		for (auto it = 0; it < thermal_iterations; it++)
+		{
+			prev = level.data;
+			parallel_for(0, size, grain, [&](int row_begin, int row_end) {
+				for (auto y = row_begin; y < row_end; y++)
+				{
+					for (auto x = 0; x < size; x++)
+					{
+						const auto h = prev[y * size + x];
+						auto delta = 0.0f;
+						for (auto n = 0; n < 8; n++)
+						{
+							const auto nx = x + offsets[n][0];
+							const auto ny = y + offsets[n][1];
+							if (nx < 0 || nx >= size || ny < 0 || ny >= size)
+							{
+								continue;
+							}
+							const auto max_diff = (offsets[n][0] != 0 && offsets[n][1] != 0) ? talus * diagonal : talus;
+							const auto diff = h - prev[ny * size + nx];
+							// antisymmetric transfer keeps total mass constant
+							if (diff > max_diff)
+							{
+								delta -= k * (diff - max_diff);
+							}
+							else if (-diff > max_diff)
+							{
+								delta += k * (-diff - max_diff);
+							}
+						}
+						level[y * size + x] = h + delta;
+					}
+				}
+			});
+		}
+	}
+}
@@ -0,0 +1,131 @@
+#include "stdafx.h"
+#include <dukat/eventbus.h>
+#include <dukat/profiler.h>
+#include <thread>
+
+namespace dukat
+{
+	// Order of posts made by the current thread
+	static thread_local uint64_t post_sequence = 0;
+
+	EventBus::EventBus(void) : active(0)
+	{
+		users[0].store(0);
+		users[1].store(0);
+	}
+
+	EventBus::~EventBus(void)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto target : ready)
+		{
+			target->scheduled.store(false);
+			target->inbox.store(nullptr);
+			target->bus.store(nullptr);
+		}
+	}
+
+	int EventBus::enter(void)
+	{
+		while (true)
+		{
+			const auto arena = active.load();
+			users[arena].fetch_add(1);
+			// drain may have switched arenas in between
+			if (active.load() == arena)
+				return arena;
+			users[arena].fetch_sub(1);
+		}
+	}
+
+	void EventBus::push(int arena, Messenger* target, const Message& message, uint32_t key)
+	{
+		auto p = new (arenas[arena].allocate(sizeof(PostedMessage))) PostedMessage;
+		p->target = target;
+		p->message = message;
+		p->key = key;
+		p->sequence = post_sequence++;
+
+		auto head = target->inbox.load(std::memory_order_relaxed);
+		do
+		{
+			p->next = head;
+		} while (!target->inbox.compare_exchange_weak(head, p, std::memory_order_release, std::memory_order_relaxed));
+
+		// First message for this target since the last drain
+		if (!target->scheduled.exchange(true))
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			target->bus.store(this);
+			ready.push_back(target);
+		}
+		// Release arena only once the message can be found by drain
+		users[arena].fetch_sub(1);
+	}
+
+	void EventBus::drain(void)
+	{
+		PROFILE_SCOPE("events.drain");
+		// Switch arenas and wait for posts to the previous one to complete.
+		const auto arena = active.load();
+		active.store(1 - arena);
+		while (users[arena].load() > 0)
+		{
+			std::this_thread::yield();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			targets.swap(ready);
+		}
+		for (auto target : targets)
+		{
+			// Clear flag first so that later posts schedule the target again.
+			target->scheduled.store(false);
+			for (auto p = target->inbox.exchange(nullptr, std::memory_order_acquire); p != nullptr; p = p->next)
+			{
+				batch.push_back(p);
+			}
+		}
+		std::sort(batch.begin(), batch.end(), [](const PostedMessage* a, const PostedMessage* b) {
+			return a->key < b->key || (a->key == b->key && a->sequence < b->sequence);
+		});
+
+		// Recipients may destroy messengers in the batch, which clears
+		// their entries through detach.
+		for (std::size_t i = 0; i < batch.size(); i++)
+		{
+			if (batch[i]->target != nullptr)
+				batch[i]->target->trigger(batch[i]->message);
+		}
+		batch.clear();
+
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			for (auto target : targets)
+			{
+				if (target != nullptr && !target->scheduled.load())
+					target->bus.store(nullptr);
+			}
+		}
+		targets.clear();
+		arenas[arena].reset();
+	}
+
+	void EventBus::detach(Messenger* target)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			ready.erase(std::remove(ready.begin(), ready.end(), target), ready.end());
+			std::replace(targets.begin(), targets.end(), target, static_cast<Messenger*>(nullptr));
+		}
+		for (auto p : batch)
+		{
+			if (p->target == target)
+				p->target = nullptr;
+		}
+		target->scheduled.store(false);
+		target->inbox.store(nullptr);
+		target->bus.store(nullptr);
+	}
+}
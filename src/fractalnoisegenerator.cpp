@@ -0,0 +1,334 @@
+#include "stdafx.h"
+#include <dukat/fractalnoisegenerator.h>
+#include <dukat/rand.h>
+#include <dukat/rect.h>
+#include <dukat/simd.h>
+#include <dukat/threadpool.h>
+
+namespace dukat
+{
+	// Scales gradient noise output to roughly [-1..1].
+	static constexpr float noise_scale = 0.7f;
+	// Hash channels used for domain warp noise.
+	static constexpr uint32_t warp_channel_x = 0x100;
+	static constexpr uint32_t warp_channel_y = 0x101;
+	// Offset applied to domain warp coordinates to decorrelate x and y displacement.
+	static constexpr float warp_offset = 17.31f;
+	// Minimum number of samples processed per parallel work item.
+	static constexpr int min_samples_per_task = 4096;
+
+	// Parameters shared by scalar and SIMD kernels.
+	struct NoiseParams
+	{
+		uint32_t seed;
+		int type;
+		int octaves;
+		float frequency;
+		float lacunarity;
+		float gain;
+		float warp_strength;
+		float warp_frequency;
+		float min_val, max_val;
+	};
+
+	static inline float gradient(uint32_t h, float x, float y)
+	{
+		h &= 7u;
+		const auto u = h < 4u ? x : y;
+		const auto v = h < 4u ? y : x;
+		return ((h & 1u) ? -u : u) + ((h & 2u) ? -(v + v) : (v + v));
+	}
+
+	static float gradient_noise(float x, float y, uint32_t seed, uint32_t channel)
+	{
+		const auto fx = std::floor(x);
+		const auto fy = std::floor(y);
+		const auto ix = static_cast<uint32_t>(static_cast<int>(fx));
+		const auto iy = static_cast<uint32_t>(static_cast<int>(fy));
+		const auto tx = x - fx;
+		const auto ty = y - fy;
+
+		const auto n00 = gradient(hash_random(seed, ix, iy, channel), tx, ty);
+		const auto n10 = gradient(hash_random(seed, ix + 1u, iy, channel), tx - 1.0f, ty);
+		const auto n01 = gradient(hash_random(seed, ix, iy + 1u, channel), tx, ty - 1.0f);
+		const auto n11 = gradient(hash_random(seed, ix + 1u, iy + 1u, channel), tx - 1.0f, ty - 1.0f);
+
+		// quintic fade curves
+		const auto u = tx * tx * tx * (tx * (tx * 6.0f - 15.0f) + 10.0f);
+		const auto v = ty * ty * ty * (ty * (ty * 6.0f - 15.0f) + 10.0f);
+		const auto n0 = n00 + u * (n10 - n00);
+		const auto n1 = n01 + u * (n11 - n01);
+		return (n0 + v * (n1 - n0)) * noise_scale;
+	}
+
+	static float fractal_noise(const NoiseParams& p, float x, float y)
+	{
+		if (p.warp_strength != 0.0f)
+		{
+			const auto wx = x * p.warp_frequency;
+			const auto wy = y * p.warp_frequency;
+			const auto dx = gradient_noise(wx, wy, p.seed, warp_channel_x);
+			const auto dy = gradient_noise(wx + warp_offset, wy + warp_offset, p.seed, warp_channel_y);
+			x = x + p.warp_strength * dx;
+			y = y + p.warp_strength * dy;
+		}
+
+		auto px = x * p.frequency;
+		auto py = y * p.frequency;
+		auto sum = 0.0f;
+		auto amp = 1.0f;
+		auto norm = 0.0f;
+		auto weight = 1.0f;
+		for (auto o = 0; o < p.octaves; o++)
+		{
+			const auto n = gradient_noise(px, py, p.seed, static_cast<uint32_t>(o));
+			switch (p.type)
+			{
+			case FractalNoiseGenerator::Ridged:
+			{
+				auto signal = 1.0f - std::abs(n);
+				signal = signal * signal;
+				signal = signal * weight;
+				weight = std::min(std::max(signal * 2.0f, 0.0f), 1.0f);
+				sum = sum + signal * amp;
+				break;
+			}
+			case FractalNoiseGenerator::Billow:
+				sum = sum + (std::abs(n) * 2.0f - 1.0f) * amp;
+				break;
+			default:
+				sum = sum + n * amp;
+				break;
+			}
+			norm = norm + amp;
+			amp = amp * p.gain;
+			px = px * p.lacunarity;
+			py = py * p.lacunarity;
+		}
+
+		auto val = sum / norm;
+		if (p.type != FractalNoiseGenerator::Ridged)
+		{
+			val = val * 0.5f + 0.5f;
+		}
+		val = std::min(std::max(val, 0.0f), 1.0f);
+		return p.min_val + val * (p.max_val - p.min_val);
+	}
+
+#ifdef DUKAT_AVX2
+	// AVX2 versions of the above. Operations are performed in the same order as in
+	// the scalar code so that both paths produce the same results.
+	DUKAT_TARGET_AVX2 static inline __m256i rotl8(__m256i h, int r)
+	{
+		return _mm256_or_si256(_mm256_slli_epi32(h, r), _mm256_srli_epi32(h, 32 - r));
+	}
+
+	DUKAT_TARGET_AVX2 static inline __m256i hash8(uint32_t seed, __m256i x, __m256i y, uint32_t z)
+	{
+		auto h = _mm256_set1_epi32(static_cast<int>(seed * 0x9e3779b9u));
+		h = _mm256_xor_si256(h, _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x85ebca6bu))));
+		h = rotl8(h, 13);
+		h = _mm256_xor_si256(h, _mm256_mullo_epi32(y, _mm256_set1_epi32(static_cast<int>(0xc2b2ae35u))));
+		h = rotl8(h, 17);
+		h = _mm256_xor_si256(h, _mm256_set1_epi32(static_cast<int>(z * 0x27d4eb2fu)));
+		h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+		h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(0x85ebca6bu)));
+		h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+		h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(0xc2b2ae35u)));
+		h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+		return h;
+	}
+
+	DUKAT_TARGET_AVX2 static inline __m256 gradient8(__m256i h, __m256 x, __m256 y)
+	{
+		const auto lt4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), _mm256_and_si256(h, _mm256_set1_epi32(7))));
+		const auto u = _mm256_blendv_ps(y, x, lt4);
+		const auto v = _mm256_blendv_ps(x, y, lt4);
+		const auto sign_u = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+		const auto sign_v = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+		return _mm256_add_ps(_mm256_xor_ps(u, sign_u), _mm256_xor_ps(_mm256_add_ps(v, v), sign_v));
+	}
+
+	DUKAT_TARGET_AVX2 static inline __m256 fade8(__m256 t)
+	{
+		auto f = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f));
+		f = _mm256_add_ps(_mm256_mul_ps(t, f), _mm256_set1_ps(10.0f));
+		return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), f);
+	}
+
+	DUKAT_TARGET_AVX2 static inline __m256 lerp8(__m256 a, __m256 b, __m256 t)
+	{
+		return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+	}
+
+	DUKAT_TARGET_AVX2 static __m256 gradient_noise8(__m256 x, __m256 y, uint32_t seed, uint32_t channel)
+	{
+		const auto fx = _mm256_floor_ps(x);
+		const auto fy = _mm256_floor_ps(y);
+		const auto ix = _mm256_cvtps_epi32(fx);
+		const auto iy = _mm256_cvtps_epi32(fy);
+		const auto ix1 = _mm256_add_epi32(ix, _mm256_set1_epi32(1));
+		const auto iy1 = _mm256_add_epi32(iy, _mm256_set1_epi32(1));
+		const auto tx = _mm256_sub_ps(x, fx);
+		const auto ty = _mm256_sub_ps(y, fy);
+		const auto one = _mm256_set1_ps(1.0f);
+		const auto tx1 = _mm256_sub_ps(tx, one);
+		const auto ty1 = _mm256_sub_ps(ty, one);
+
+		const auto n00 = gradient8(hash8(seed, ix, iy, channel), tx, ty);
+		const auto n10 = gradient8(hash8(seed, ix1, iy, channel), tx1, ty);
+		const auto n01 = gradient8(hash8(seed, ix, iy1, channel), tx, ty1);
+		const auto n11 = gradient8(hash8(seed, ix1, iy1, channel), tx1, ty1);
+
+		const auto u = fade8(tx);
+		const auto v = fade8(ty);
+		const auto n0 = lerp8(n00, n10, u);
+		const auto n1 = lerp8(n01, n11, u);
+		return _mm256_mul_ps(lerp8(n0, n1, v), _mm256_set1_ps(noise_scale));
+	}
+
+	DUKAT_TARGET_AVX2 static __m256 fractal_noise8(const NoiseParams& p, __m256 x, __m256 y)
+	{
+		const auto zero = _mm256_setzero_ps();
+		const auto one = _mm256_set1_ps(1.0f);
+		const auto abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+		if (p.warp_strength != 0.0f)
+		{
+			const auto wf = _mm256_set1_ps(p.warp_frequency);
+			const auto wo = _mm256_set1_ps(warp_offset);
+			const auto ws = _mm256_set1_ps(p.warp_strength);
+			const auto wx = _mm256_mul_ps(x, wf);
+			const auto wy = _mm256_mul_ps(y, wf);
+			const auto dx = gradient_noise8(wx, wy, p.seed, warp_channel_x);
+			const auto dy = gradient_noise8(_mm256_add_ps(wx, wo), _mm256_add_ps(wy, wo), p.seed, warp_channel_y);
+			x = _mm256_add_ps(x, _mm256_mul_ps(ws, dx));
+			y = _mm256_add_ps(y, _mm256_mul_ps(ws, dy));
+		}
+
+		const auto lacunarity = _mm256_set1_ps(p.lacunarity);
+		auto px = _mm256_mul_ps(x, _mm256_set1_ps(p.frequency));
+		auto py = _mm256_mul_ps(y, _mm256_set1_ps(p.frequency));
+		auto sum = zero;
+		auto amp = 1.0f;
+		auto norm = 0.0f;
+		auto weight = one;
+		for (auto o = 0; o < p.octaves; o++)
+		{
+			const auto n = gradient_noise8(px, py, p.seed, static_cast<uint32_t>(o));
+			const auto vamp = _mm256_set1_ps(amp);
+			switch (p.type)
+			{
+			case FractalNoiseGenerator::Ridged:
+			{
+				auto signal = _mm256_sub_ps(one, _mm256_and_ps(n, abs_mask));
+				signal = _mm256_mul_ps(signal, signal);
+				signal = _mm256_mul_ps(signal, weight);
+				weight = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(signal, _mm256_set1_ps(2.0f)), zero), one);
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(signal, vamp));
+				break;
+			}
+			case FractalNoiseGenerator::Billow:
+			{
+				auto b = _mm256_sub_ps(_mm256_mul_ps(_mm256_and_ps(n, abs_mask), _mm256_set1_ps(2.0f)), one);
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(b, vamp));
+				break;
+			}
+			default:
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(n, vamp));
+				break;
+			}
+			norm = norm + amp;
+			amp = amp * p.gain;
+			px = _mm256_mul_ps(px, lacunarity);
+			py = _mm256_mul_ps(py, lacunarity);
+		}
+
+		auto val = _mm256_div_ps(sum, _mm256_set1_ps(norm));
+		if (p.type != FractalNoiseGenerator::Ridged)
+		{
+			const auto half = _mm256_set1_ps(0.5f);
+			val = _mm256_add_ps(_mm256_mul_ps(val, half), half);
+		}
+		val = _mm256_min_ps(_mm256_max_ps(val, zero), one);
+		return _mm256_add_ps(_mm256_set1_ps(p.min_val), _mm256_mul_ps(val, _mm256_set1_ps(p.max_val - p.min_val)));
+	}
+
+	DUKAT_TARGET_AVX2 static int sample_row8(const NoiseParams& p, float x, float y, float dx, int count, float* out)
+	{
+		const auto lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+		const auto vy = _mm256_set1_ps(y);
+		auto i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			// same expression as scalar path: x + (float)i * dx
+			const auto vi = _mm256_add_ps(_mm256_set1_ps((float)i), lanes);
+			const auto vx = _mm256_add_ps(_mm256_set1_ps(x), _mm256_mul_ps(vi, _mm256_set1_ps(dx)));
+			_mm256_storeu_ps(out + i, fractal_noise8(p, vx, vy));
+		}
+		return i;
+	}
+#endif
+
+	void FractalNoiseGenerator::sample_row(float x, float y, float dx, int count, float* out) const
+	{
+		const NoiseParams p{ static_cast<uint32_t>(seed), static_cast<int>(type), octaves, frequency,
+			lacunarity, gain, warp_strength, warp_frequency, min_val, max_val };
+
+		auto i = 0;
+#ifdef DUKAT_AVX2
+		if (cpu_has_avx2())
+		{
+			i = sample_row8(p, x, y, dx, count, out);
+		}
+#endif
+		for (; i < count; i++)
+		{
+			out[i] = fractal_noise(p, x + (float)i * dx, y);
+		}
+	}
+
+	void FractalNoiseGenerator::fill(HeightMap::Level& level, int x, int y, int lod) const
+	{
+		const auto spacing = (float)(1 << lod);
+		const auto grain = std::max(1, min_samples_per_task / level.size);
+		parallel_for(0, level.size, grain, [&](int row_begin, int row_end) {
+			for (auto j = row_begin; j < row_end; j++)
+			{
+				sample_row((float)x * spacing, (float)(y + j) * spacing, spacing, level.size,
+					level.data.data() + j * level.size);
+			}
+		});
+	}
+
+	void FractalNoiseGenerator::generate(HeightMap::Level& level) const
+	{
+		fill(level, 0, 0, 0);
+	}
+
+	void FractalNoiseGenerator::generate_tile(HeightMap::Level& tile, int x, int y, int lod) const
+	{
+		fill(tile, x, y, lod);
+	}
+
+	void FractalNoiseGenerator::generate_rect(int level, const Rect& rect, std::vector<GLfloat>& buffer) const
+	{
+		const auto spacing = (float)(1 << level);
+		const auto rows = std::min(rect.h, static_cast<int>(buffer.size()) / std::max(1, rect.w));
+		const auto grain = std::max(1, min_samples_per_task / std::max(1, rect.w));
+		parallel_for(0, rows, grain, [&](int row_begin, int row_end) {
+			for (auto j = row_begin; j < row_end; j++)
+			{
+				sample_row((float)rect.x * spacing, (float)(rect.y + j) * spacing, spacing, rect.w,
+					buffer.data() + j * rect.w);
+			}
+		});
+	}
+
+	float FractalNoiseGenerator::sample(float x, float y) const
+	{
+		const NoiseParams p{ static_cast<uint32_t>(seed), static_cast<int>(type), octaves, frequency,
+			lacunarity, gain, warp_strength, warp_frequency, min_val, max_val };
+		return fractal_noise(p, x, y);
+	}
+}
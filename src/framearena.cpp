@@ -0,0 +1,82 @@
+#include "stdafx.h"
+#include <dukat/framearena.h>
+
+namespace dukat
+{
+	static constexpr std::size_t arena_alignment = alignof(std::max_align_t);
+
+	FrameArena::FrameArena(std::size_t chunk_size) : chunk_size(chunk_size), first(nullptr), current(nullptr)
+	{
+		grow(nullptr, chunk_size);
+	}
+
+	FrameArena::~FrameArena(void)
+	{
+		auto c = first;
+		while (c != nullptr)
+		{
+			auto next = c->next;
+			delete[] c->data;
+			delete c;
+			c = next;
+		}
+	}
+
+	void FrameArena::grow(Chunk* c, std::size_t size)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		// another thread may have moved on already
+		if (current.load() != c)
+			return;
+		if (c != nullptr && c->next != nullptr)
+		{
+			// reuse chunk from an earlier frame; if it is too small the
+			// caller will grow again
+			current.store(c->next);
+			return;
+		}
+
+		auto chunk = new Chunk;
+		chunk->next = nullptr;
+		chunk->size = std::max(size, chunk_size);
+		chunk->used.store(0);
+		chunk->data = new std::max_align_t[(chunk->size + arena_alignment - 1) / arena_alignment];
+		if (c == nullptr)
+			first = chunk;
+		else
+			c->next = chunk;
+		current.store(chunk);
+	}
+
+	void* FrameArena::allocate(std::size_t size)
+	{
+		size = (size + arena_alignment - 1) & ~(arena_alignment - 1);
+		while (true)
+		{
+			auto c = current.load();
+			const auto offset = c->used.fetch_add(size);
+			if (offset + size <= c->size)
+				return reinterpret_cast<char*>(c->data) + offset;
+			grow(c, size);
+		}
+	}
+
+	void FrameArena::reset(void)
+	{
+		for (auto c = first; c != nullptr; c = c->next)
+		{
+			c->used.store(0);
+		}
+		current.store(first);
+	}
+
+	std::size_t FrameArena::capacity(void) const
+	{
+		std::size_t res = 0;
+		for (auto c = first; c != nullptr; c = c->next)
+		{
+			res += c->size;
+		}
+		return res;
+	}
+}
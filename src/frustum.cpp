@@ -0,0 +1,229 @@
+#include "stdafx.h"
+#include <dukat/frustum.h>
+#include <dukat/aabb3.h>
+#include <dukat/boundingsphere.h>
+#include <dukat/mathutil.h>
+#include <dukat/simd.h>
+
+namespace dukat
+{
+	// Offsets of plane components in lanes
+	static constexpr int lane_nx = 0;
+	static constexpr int lane_ny = 8;
+	static constexpr int lane_nz = 16;
+	static constexpr int lane_ax = 24;
+	static constexpr int lane_ay = 32;
+	static constexpr int lane_az = 40;
+	static constexpr int lane_d = 48;
+
+	Frustum::Frustum(void)
+	{
+		// Planes at origin that accept everything until setup is called
+		for (auto& p : planes)
+		{
+			p.p = Vector3::origin;
+			p.n = Vector3::origin;
+			p.d = -1.0f;
+		}
+		update_lanes();
+	}
+
+	void Frustum::setup(const Vector3& pos, const Vector3& dir, const Vector3& up,
+		float fov_h, float fov_v, float near_clip, float far_clip)
+	{
+		// Re-orthogonalize axes in case up is not perpendicular to dir
+		auto side = cross_product(dir, up);
+		side.normalize();
+		const auto v = cross_product(side, dir);
+		const auto half_h = deg_to_rad(0.5f * fov_h);
+		const auto half_v = deg_to_rad(0.5f * fov_v);
+		const auto ch = std::cos(half_h), sh = std::sin(half_h);
+		const auto cv = std::cos(half_v), sv = std::sin(half_v);
+
+		// Side planes contain the camera position; normals are tilted inwards
+		// by the half angle of the field of view.
+		planes[Left] = Plane{ pos, side * ch + dir * sh };
+		planes[Right] = Plane{ pos, side * -ch + dir * sh };
+		planes[Bottom] = Plane{ pos, v * cv + dir * sv };
+		planes[Top] = Plane{ pos, v * -cv + dir * sv };
+		planes[Near] = Plane{ pos + dir * near_clip, dir };
+		planes[Far] = Plane{ pos + dir * far_clip, -dir };
+		update_lanes();
+	}
+
+	void Frustum::update_lanes(void)
+	{
+		lanes.fill(0.0f);
+		for (auto i = 0; i < NumPlanes; i++)
+		{
+			const auto& p = planes[i];
+			lanes[lane_nx + i] = p.n.x;
+			lanes[lane_ny + i] = p.n.y;
+			lanes[lane_nz + i] = p.n.z;
+			lanes[lane_ax + i] = std::abs(p.n.x);
+			lanes[lane_ay + i] = std::abs(p.n.y);
+			lanes[lane_az + i] = std::abs(p.n.z);
+			lanes[lane_d + i] = p.d;
+		}
+		// Padding lanes classify everything as inside
+		for (int i = NumPlanes; i < 8; i++)
+		{
+			lanes[lane_d + i] = -1.0f;
+		}
+	}
+
+	// Combines per-plane bits into a result. A volume is outside if it is behind
+	// any of the tested planes and inside if it is in front of all of them.
+	static inline Frustum::Result resolve(int outside_bits, int inside_bits, uint8_t in_mask, uint8_t* out_mask)
+	{
+		if ((outside_bits & in_mask) != 0)
+		{
+			if (out_mask != nullptr)
+			{
+				*out_mask = 0;
+			}
+			return Frustum::Outside;
+		}
+		const auto straddle = static_cast<uint8_t>(~inside_bits & in_mask);
+		if (out_mask != nullptr)
+		{
+			*out_mask = straddle;
+		}
+		return (straddle != 0) ? Frustum::Intersect : Frustum::Inside;
+	}
+
+	// Classifies a volume with center c and per-plane radius ax*e.x + ay*e.y + az*e.z + r
+	// against the planes in in_mask. Boxes pass half extents in e and 0 for r,
+	// spheres pass 0 for e and their radius in r.
+	static Frustum::Result classify_scalar(const float* lanes, const Vector3& c, const Vector3& e, float r,
+		uint8_t in_mask, uint8_t* out_mask)
+	{
+		auto outside_bits = 0, inside_bits = 0;
+		for (auto i = 0; i < Frustum::NumPlanes; i++)
+		{
+			if ((in_mask & (1 << i)) == 0)
+				continue;
+			const auto nc = lanes[lane_nx + i] * c.x + lanes[lane_ny + i] * c.y + lanes[lane_nz + i] * c.z;
+			const auto rad = lanes[lane_ax + i] * e.x + lanes[lane_ay + i] * e.y + lanes[lane_az + i] * e.z + r;
+			if (nc + rad <= lanes[lane_d + i])
+			{
+				outside_bits |= (1 << i);
+				break;
+			}
+			if (nc - rad >= lanes[lane_d + i])
+			{
+				inside_bits |= (1 << i);
+			}
+		}
+		return resolve(outside_bits, inside_bits, in_mask, out_mask);
+	}
+
+#ifdef DUKAT_AVX2
+	// Plane lanes loaded into registers
+	struct FrustumLanes
+	{
+		__m256 nx, ny, nz, ax, ay, az, d;
+	};
+
+	DUKAT_TARGET_AVX2 static inline FrustumLanes load_lanes(const float* lanes)
+	{
+		return FrustumLanes{
+			_mm256_loadu_ps(lanes + lane_nx), _mm256_loadu_ps(lanes + lane_ny), _mm256_loadu_ps(lanes + lane_nz),
+			_mm256_loadu_ps(lanes + lane_ax), _mm256_loadu_ps(lanes + lane_ay), _mm256_loadu_ps(lanes + lane_az),
+			_mm256_loadu_ps(lanes + lane_d)
+		};
+	}
+
+	// Tests one volume against all 6 planes at once.
+	DUKAT_TARGET_AVX2 static inline Frustum::Result classify_avx2(const FrustumLanes& l, const Vector3& c, const Vector3& e, float r,
+		uint8_t in_mask, uint8_t* out_mask)
+	{
+		const auto nc = _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(l.nx, _mm256_set1_ps(c.x)), _mm256_mul_ps(l.ny, _mm256_set1_ps(c.y))),
+			_mm256_mul_ps(l.nz, _mm256_set1_ps(c.z)));
+		const auto rad = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(l.ax, _mm256_set1_ps(e.x)), _mm256_mul_ps(l.ay, _mm256_set1_ps(e.y))),
+			_mm256_mul_ps(l.az, _mm256_set1_ps(e.z))), _mm256_set1_ps(r));
+		const auto outside_bits = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(nc, rad), l.d, _CMP_LE_OQ));
+		const auto inside_bits = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_sub_ps(nc, rad), l.d, _CMP_GE_OQ));
+		return resolve(outside_bits, inside_bits, in_mask, out_mask);
+	}
+
+	DUKAT_TARGET_AVX2 static int classify_boxes_avx2(const float* lanes, const AABB3* boxes, int count, int8_t* results,
+		uint8_t in_mask, uint8_t* out_masks)
+	{
+		const auto l = load_lanes(lanes);
+		auto visible = 0;
+		for (auto i = 0; i < count; i++)
+		{
+			const auto& bb = boxes[i];
+			const auto res = classify_avx2(l, (bb.min + bb.max) * 0.5f, (bb.max - bb.min) * 0.5f, 0.0f,
+				in_mask, out_masks != nullptr ? out_masks + i : nullptr);
+			results[i] = static_cast<int8_t>(res);
+			visible += (res != Frustum::Outside) ? 1 : 0;
+		}
+		return visible;
+	}
+
+	DUKAT_TARGET_AVX2 static int classify_spheres_avx2(const float* lanes, const BoundingSphere* spheres, int count, int8_t* results,
+		uint8_t in_mask, uint8_t* out_masks)
+	{
+		const auto l = load_lanes(lanes);
+		auto visible = 0;
+		for (auto i = 0; i < count; i++)
+		{
+			const auto res = classify_avx2(l, spheres[i].center, Vector3::origin, spheres[i].radius,
+				in_mask, out_masks != nullptr ? out_masks + i : nullptr);
+			results[i] = static_cast<int8_t>(res);
+			visible += (res != Frustum::Outside) ? 1 : 0;
+		}
+		return visible;
+	}
+#endif
+
+	Frustum::Result Frustum::classify(const AABB3& bb, uint8_t in_mask, uint8_t* out_mask) const
+	{
+		return classify_scalar(lanes.data(), (bb.min + bb.max) * 0.5f, (bb.max - bb.min) * 0.5f, 0.0f, in_mask, out_mask);
+	}
+
+	Frustum::Result Frustum::classify(const Vector3& center, float radius, uint8_t in_mask, uint8_t* out_mask) const
+	{
+		return classify_scalar(lanes.data(), center, Vector3::origin, radius, in_mask, out_mask);
+	}
+
+	int Frustum::classify(const AABB3* boxes, int count, int8_t* results, uint8_t in_mask, uint8_t* out_masks) const
+	{
+#ifdef DUKAT_AVX2
+		if (cpu_has_avx2())
+		{
+			return classify_boxes_avx2(lanes.data(), boxes, count, results, in_mask, out_masks);
+		}
+#endif
+		auto visible = 0;
+		for (auto i = 0; i < count; i++)
+		{
+			const auto res = classify(boxes[i], in_mask, out_masks != nullptr ? out_masks + i : nullptr);
+			results[i] = static_cast<int8_t>(res);
+			visible += (res != Outside) ? 1 : 0;
+		}
+		return visible;
+	}
+
+	int Frustum::classify(const BoundingSphere* spheres, int count, int8_t* results, uint8_t in_mask, uint8_t* out_masks) const
+	{
+#ifdef DUKAT_AVX2
+		if (cpu_has_avx2())
+		{
+			return classify_spheres_avx2(lanes.data(), spheres, count, results, in_mask, out_masks);
+		}
+#endif
+		auto visible = 0;
+		for (auto i = 0; i < count; i++)
+		{
+			const auto res = classify(spheres[i].center, spheres[i].radius, in_mask, out_masks != nullptr ? out_masks + i : nullptr);
+			results[i] = static_cast<int8_t>(res);
+			visible += (res != Outside) ? 1 : 0;
+		}
+		return visible;
+	}
+}
@@ -5,20 +5,18 @@
 
 namespace dukat
 {
-    FullscreenEffect2::FullscreenEffect2(Game2* game) : game(game), anim(nullptr), last_sp(nullptr), color({0.f, 0.f, 0.f, 0.f}), alpha(0.f)
+    FullscreenEffect2::FullscreenEffect2(Game2* game) : game(game), anim(0u), last_sp(nullptr), color({0.f, 0.f, 0.f, 0.f}), alpha(0.f)
     {
     }
 
     FullscreenEffect2::~FullscreenEffect2(void)
     {
-        if (anim != nullptr)
-            game->get<AnimationManager>()->cancel(anim);
+        game->get<AnimationManager>()->cancel(anim);
     }
 
-    void FullscreenEffect2::fade_in(float duration, std::function<void(void)> callback)
+    void FullscreenEffect2::fade_in(float duration, Delegate<void(void)> callback)
     {
-        if (anim != nullptr)
-            game->get<AnimationManager>()->cancel(anim);
+        game->get<AnimationManager>()->cancel(anim);
 
         auto sp = game->get_shaders()->get_program("fx_default.vsh", "fx_solid.fsh");
         game->get_renderer()->set_composite_program(sp, [&](ShaderProgram* p) {
@@ -26,19 +24,12 @@ namespace dukat
         });
 
         alpha = 1.0f;
-        auto value_anim = std::make_unique<ValueAnimation<float>>(&alpha, duration, 0.0f);
-        value_anim->set_callback([&, callback](void) {
-            if (callback != nullptr)
-                callback();
-            anim = nullptr;
-        });
-        anim = game->get<AnimationManager>()->add(std::move(value_anim));
+        anim = game->get<AnimationManager>()->tween(&alpha, 0.0f, duration, Easing::Linear, std::move(callback));
     }
 
-    void FullscreenEffect2::fade_out(float duration, std::function<void(void)> callback)
+    void FullscreenEffect2::fade_out(float duration, Delegate<void(void)> callback)
     {
-        if (anim != nullptr)
-            game->get<AnimationManager>()->cancel(anim);
+        game->get<AnimationManager>()->cancel(anim);
 
         auto sp = game->get_shaders()->get_program("fx_default.vsh", "fx_solid.fsh");
         game->get_renderer()->set_composite_program(sp, [&](ShaderProgram* p) {
@@ -46,13 +37,7 @@ namespace dukat
         });
 
         alpha = 0.0f;
-        auto value_anim = std::make_unique<ValueAnimation<float>>(&alpha, duration, 1.0f);
-        value_anim->set_callback([&, callback](void) {
-            if (callback != nullptr)
-                callback();
-            anim = nullptr;
-        });
-        anim = game->get<AnimationManager>()->add(std::move(value_anim));
+        anim = game->get<AnimationManager>()->tween(&alpha, 1.0f, duration, Easing::Linear, std::move(callback));
     }
     
     void FullscreenEffect2::set_composite_program(ShaderProgram* sp, std::function<void(ShaderProgram*)> binder)
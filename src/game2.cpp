@@ -6,6 +6,8 @@ namespace dukat
 {
 	Game2::Game2(Settings& settings) : GameBase(settings)
 	{
+		if (is_headless())
+			throw std::runtime_error("Game2 cannot run headless, derive from GameBase instead.");
 		renderer = std::make_unique<Renderer2>(window.get(), shader_cache.get());
 		renderer->set_force_sync(settings.get_bool("video.forcesync", false));
 		effect = std::make_unique<FullscreenEffect2>(this);
@@ -23,6 +25,12 @@ namespace dukat
 		renderer->get_camera()->update(delta);
 	}
 
+	void Game2::render(void)
+	{
+		renderer->set_alpha(get_alpha());
+		GameBase::render();
+	}
+
 	void Game2::toggle_debug(void)
 	{
 		GameBase::toggle_debug();
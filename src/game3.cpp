@@ -7,6 +7,8 @@ namespace dukat
 {
 	Game3::Game3(Settings& settings) : GameBase(settings)
 	{
+		if (is_headless())
+			throw std::runtime_error("Game3 cannot run headless, derive from GameBase instead.");
 		// Change origin for textures to match OpenGL default (bottom-left).
 		texture_cache->set_vflip(true);
 
@@ -34,6 +36,12 @@ namespace dukat
 		renderer->get_camera()->update(delta);
 	}
 
+	void Game3::render(void)
+	{
+		renderer->set_alpha(get_alpha());
+		GameBase::render();
+	}
+
 	void Game3::toggle_debug(void)
 	{
 		GameBase::toggle_debug();
@@ -7,6 +7,7 @@
 #include <dukat/manager.h>
 #include <dukat/meshcache.h>
 #include <dukat/particlemanager.h>
+#include <dukat/profiler.h>
 #include <dukat/scene.h>
 #include <dukat/settings.h>
 #include <dukat/shadercache.h>
@@ -20,23 +21,30 @@ namespace dukat
 {
 	GameBase::GameBase(Settings& settings) : Application(settings), controller(nullptr), debug(false)
 	{
+		// Resources that need audio or a GL context are not available headless.
+		if (!is_headless())
+		{
 #ifndef __ANDROID__
-		audio_cache = std::make_unique<AudioCache>(settings.get_string("resources.samples"), settings.get_string("resources.music"));
+			audio_cache = std::make_unique<AudioCache>(settings.get_string("resources.samples"), settings.get_string("resources.music"));
 #endif
-		shader_cache = std::make_unique<ShaderCache>(settings.get_string("resources.shaders"));
-		texture_cache = std::make_unique<TextureCache>(settings.get_string("resources.textures"));
-		mesh_cache = std::make_unique<MeshCache>();
+			shader_cache = std::make_unique<ShaderCache>(settings.get_string("resources.shaders"));
+			texture_cache = std::make_unique<TextureCache>(settings.get_string("resources.textures"));
+			mesh_cache = std::make_unique<MeshCache>();
+		}
+		event_bus = std::make_unique<EventBus>();
 		add_manager<ParticleManager>();
 		add_manager<TimerManager>();
 		add_manager<AnimationManager>();
 		add_manager<UIManager>();		
-		device_manager->active->on_press(InputDevice::VirtualButton::Debug, std::bind(&GameBase::toggle_debug, this));
+		if (device_manager->active != nullptr)
+			device_manager->active->on_press(InputDevice::VirtualButton::Debug, std::bind(&GameBase::toggle_debug, this));
 		get<TimerManager>()->create_timer(1.0f, std::bind(&GameBase::update_debug_text, this), true);
 	}
 
 	GameBase::~GameBase(void)
 	{
-		device_manager->active->unbind(InputDevice::VirtualButton::Debug);
+		if (device_manager->active != nullptr)
+			device_manager->active->unbind(InputDevice::VirtualButton::Debug);
 	}
 
 	void GameBase::handle_event(const SDL_Event& e)
@@ -56,12 +64,17 @@ namespace dukat
 	void GameBase::update(float delta)
 	{
 		// Scene first so that managers can operate on updated properties.
-		scene_stack.top()->update(delta);
+		{
+			PROFILE_SCOPE("scene.update");
+			scene_stack.top()->update(delta);
+		}
 		for (auto& it : managers)
 		{
 			if (it.second->is_enabled())
 				(it.second)->update(delta);
 		}
+		// Deliver messages posted by scene, managers and worker threads.
+		event_bus->drain();
 	}
 
 	void GameBase::render(void)
@@ -107,7 +120,7 @@ namespace dukat
 		scene_stack.push(scene);
 		scene->activate();
 		// Reset last update whenever scene changes.
-		last_update = SDL_GetTicks();
+		reset_clock();
 	}
 
 	void GameBase::pop_scene(void)
@@ -120,7 +133,7 @@ namespace dukat
 			{
 				scene_stack.top()->activate();
 				// Reset last update whenever scene changes.
-				last_update = SDL_GetTicks();
+				reset_clock();
 			}
 		}
 	}
@@ -1,15 +1,54 @@
 #include "stdafx.h"
 #include <dukat/heightmap.h>
+#include <dukat/erosion.h>
 #include <dukat/heightmapgenerator.h>
 #include <dukat/log.h>
+#include <dukat/mappedfile.h>
 #include <dukat/mathutil.h>
 #include <dukat/rect.h>
 #include <dukat/surface.h>
 #include <dukat/ray3.h>
+#include <dukat/sysutil.h>
 #include <png.h>
 
 namespace dukat
 {
+	// Binary heightmap file header. Level data starts at a page boundary
+	// and every level is padded to a cache line, so the file can be mapped
+	// and consumed without any further processing.
+	struct HeightMapHeader
+	{
+		uint32_t id;
+		uint32_t version;
+		uint32_t num_levels;
+		uint32_t level_size;
+		uint32_t reserved;
+		uint32_t data_offset; // offset of level 0 from start of file
+		uint64_t data_size; // size of level data including padding
+		uint64_t source_key; // identifies source data the file was created from
+		uint32_t data_checksum; // checksum of level data
+		uint32_t header_checksum; // checksum of preceding header fields
+	};
+
+	static constexpr uint32_t heightmap_id = mc_const('p', 'm', 'h', 'd'); // dhmp
+	static constexpr uint32_t heightmap_version = 2;
+	static constexpr uint32_t heightmap_max_levels = 16;
+	static constexpr uint32_t heightmap_max_size = 1 << 16;
+	static constexpr uint32_t heightmap_data_alignment = 4096;
+	static constexpr uint32_t heightmap_level_alignment = 64;
+
+	// Returns size of a level in bytes including padding.
+	static inline size_t aligned_level_bytes(int level_size)
+	{
+		const auto bytes = static_cast<size_t>(level_size) * static_cast<size_t>(level_size) * sizeof(GLfloat);
+		return (bytes + heightmap_level_alignment - 1) & ~static_cast<size_t>(heightmap_level_alignment - 1);
+	}
+
+	static inline uint32_t header_checksum(const HeightMapHeader& header)
+	{
+		return compute_checksum(reinterpret_cast<const uint8_t*>(&header), offsetof(HeightMapHeader, header_checksum));
+	}
+
     void HeightMap::generate_levels(void)
     {
         // For now, done on the CPU - investigate performance gains for doing this on the GPU
@@ -49,6 +88,7 @@ namespace dukat
         {
             levels.clear();
         }
+		source = nullptr;
 
 		png_image img;
 		memset(&img, 0, sizeof(img));
@@ -114,12 +154,131 @@ namespace dukat
 		png_image_write_to_file(&img, filename.c_str(), 0, buffer.data(), 0, nullptr);
 	}
 
+	void HeightMap::load_binary(const std::string& filename, uint64_t source_key)
+	{
+		MappedFile file(filename);
+		if (file.get_size() < sizeof(HeightMapHeader))
+		{
+			throw std::runtime_error("Invalid heightmap file - truncated header.");
+		}
+
+		HeightMapHeader header;
+		std::memcpy(&header, file.get_data(), sizeof(HeightMapHeader));
+		if (header.id != heightmap_id || header.version != heightmap_version)
+		{
+			throw std::runtime_error("Invalid heightmap format or version!");
+		}
+		if (header.header_checksum != header_checksum(header))
+		{
+			throw std::runtime_error("Invalid heightmap file - header checksum mismatch.");
+		}
+		if (header.source_key != source_key)
+		{
+			throw std::runtime_error("Heightmap file is out of date.");
+		}
+		if (static_cast<int>(header.num_levels) < num_levels)
+		{
+			throw std::runtime_error("Heightmap file does not contain enough levels.");
+		}
+		if (header.num_levels > heightmap_max_levels || header.level_size > heightmap_max_size
+			|| (header.level_size >> (header.num_levels - 1)) == 0)
+		{
+			throw std::runtime_error("Invalid heightmap file - bad level dimensions.");
+		}
+		if (header.data_offset > file.get_size() || header.data_size > file.get_size() - header.data_offset)
+		{
+			throw std::runtime_error("Invalid heightmap file - truncated level data.");
+		}
+		// levels are laid out back to back and have to account for all data
+		uint64_t expected_size = 0;
+		for (auto i = 0u; i < header.num_levels; i++)
+		{
+			expected_size += aligned_level_bytes(static_cast<int>(header.level_size >> i));
+		}
+		if (expected_size != header.data_size)
+		{
+			throw std::runtime_error("Invalid heightmap file - level data size mismatch.");
+		}
+
+		const auto data = file.get_data() + header.data_offset;
+		if (header.data_checksum != compute_checksum(data, static_cast<size_t>(header.data_size)))
+		{
+			throw std::runtime_error("Invalid heightmap file - data checksum mismatch.");
+		}
+
+		// only replace current data once the file has been validated
+		const auto size = static_cast<int>(header.level_size);
+		std::vector<Level> loaded;
+		loaded.reserve(num_levels);
+		auto src = data;
+		for (auto i = 0; i < num_levels; i++)
+		{
+			loaded.push_back({ i, size >> i });
+			auto& level = loaded.back();
+			std::memcpy(level.data.data(), src, level.data.size() * sizeof(GLfloat));
+			src += aligned_level_bytes(level.size);
+		}
+		levels.swap(loaded);
+		level_size = size;
+		source = nullptr;
+	}
+
+	void HeightMap::save_binary(const std::string& filename, uint64_t source_key) const
+	{
+		HeightMapHeader header;
+		memset(&header, 0, sizeof(header));
+		header.id = heightmap_id;
+		header.version = heightmap_version;
+		header.source_key = source_key;
+		header.num_levels = static_cast<uint32_t>(levels.size());
+		header.level_size = static_cast<uint32_t>(level_size);
+		header.data_offset = heightmap_data_alignment;
+
+		// lay out levels back to back, padding each to alignment boundary
+		std::vector<uint8_t> buffer;
+		for (const auto& level : levels)
+		{
+			header.data_size += aligned_level_bytes(level.size);
+		}
+		buffer.resize(static_cast<size_t>(header.data_size));
+		auto dst = buffer.data();
+		for (const auto& level : levels)
+		{
+			std::memcpy(dst, level.data.data(), level.data.size() * sizeof(GLfloat));
+			dst += aligned_level_bytes(level.size);
+		}
+		header.data_checksum = compute_checksum(buffer.data(), buffer.size());
+		header.header_checksum = header_checksum(header);
+
+		std::ofstream os(filename, std::ios::out | std::ios::binary);
+		if (!os)
+		{
+			throw std::runtime_error("Could not open file for writing: " + filename);
+		}
+		std::vector<char> header_block(heightmap_data_alignment, 0);
+		std::memcpy(header_block.data(), &header, sizeof(HeightMapHeader));
+		os.write(header_block.data(), header_block.size());
+		os.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+		if (!os)
+		{
+			throw std::runtime_error("Failed to write heightmap data.");
+		}
+	}
+
+	void HeightMap::convert(const std::string& png_file, const std::string& binary_file, int num_levels)
+	{
+		HeightMap map(num_levels);
+		map.load(png_file);
+		map.save_binary(binary_file);
+	}
+
 	void HeightMap::allocate(int level_size)
 	{
 		if (!levels.empty())
 		{
 			levels.clear();
 		}
+		source = nullptr;
 
 		this->level_size = level_size;
 		levels.push_back({ 0, level_size });
@@ -133,6 +292,7 @@ namespace dukat
 		{
 			levels.clear();
 		}
+		source = nullptr;
 
 		this->level_size = level_size;
 		levels.push_back({ 0, level_size });
@@ -143,62 +303,75 @@ namespace dukat
 		generate_levels();
 	}
 
+	void HeightMap::erode(const Erosion& erosion)
+	{
+		if (levels.empty())
+		{
+			return;
+		}
+
+		erosion.apply(levels[0]);
+		levels.resize(1);
+		generate_levels();
+	}
+
+	void HeightMap::generate_unbounded(const HeightMapGenerator* generator)
+	{
+		if (!generator->is_unbounded())
+		{
+			throw std::runtime_error("Generator does not support unbounded terrain.");
+		}
+		levels.clear();
+		level_size = 0;
+		source = generator;
+	}
+
     void HeightMap::get_data(int level, const Rect& rect, std::vector<GLfloat>& buffer) const
     {
+		if (source != nullptr)
+		{
+			source->generate_rect(level, rect, buffer);
+			return;
+		}
+
 		const auto stride = levels[level].size;
-		const auto last_row = std::min(rect.y + rect.h, stride);
-		const auto last_col = std::min(rect.x + rect.w, stride);
+		// Columns of the rect that are within bounds, clamped to the rect
+		const auto first_col = std::min(std::max(rect.x, 0), rect.x + rect.w);
+		const auto last_col = std::max(std::min(rect.x + rect.w, stride), first_col);
 
 		auto dst = buffer.begin();
-		auto y = rect.y;
-
-		// Outside of bounds < 0
-		if (y < 0)
+		for (auto y = rect.y; y < rect.y + rect.h; y++)
 		{
-			auto count = abs(y) * rect.w;
-			std::fill(dst, dst + count, 0.0f);
-			dst += count;
-			y = 0;
-		}
-
-        for ( ; y < last_row; y++)
-        {
-			auto x = rect.x;
-			// outside of bounds < 0
-			if (x < 0)
+			// outside of bounds
+			if (y < 0 || y >= stride)
 			{
-				auto count = abs(x);
-				std::fill(dst, dst + count, 0.0f);
-				dst += count;
-				x = 0;
+				std::fill(dst, dst + rect.w, 0.0f);
+				dst += rect.w;
+				continue;
 			}
 
-			if (x < last_col)
-			{
-				auto src = levels[level].data.begin() + y * stride;
-				std::copy(src + x, src + last_col, dst);
-				dst += (last_col - x);
-			}
+			// outside of bounds < 0
+			std::fill(dst, dst + (first_col - rect.x), 0.0f);
+			dst += (first_col - rect.x);
 
-			// outside of bounds > level_size
-			if (last_col < rect.x + rect.w)
-			{
-				auto count = (rect.x + rect.w) - last_col;
-				std::fill(dst, dst + count, 0.0f);
-				dst += count;
-			}
-        }
+			auto src = levels[level].data.begin() + y * stride;
+			dst = std::copy(src + first_col, src + last_col, dst);
 
-		// Outside of bounds > level_size
-		if (last_row < rect.y + rect.h)
-		{
-			std::fill(dst, buffer.end(), 0.0f);
+			// outside of bounds > level_size
+			std::fill(dst, dst + (rect.x + rect.w - last_col), 0.0f);
+			dst += (rect.x + rect.w - last_col);
 		}
     }
 
 	float HeightMap::get_elevation(int x, int y, int level) const
 	{
 		assert(level < num_levels);
+		if (source != nullptr)
+		{
+			// same sample position as generate_rect
+			const auto spacing = (float)(1 << level);
+			return source->sample((float)x * spacing, (float)y * spacing);
+		}
 		const auto stride = levels[level].size;
 		if (x < 0 || x >= stride || y < 0 || y >= stride)
 		{
@@ -0,0 +1,145 @@
+#include "stdafx.h"
+#include <dukat/histogram.h>
+
+namespace dukat
+{
+	static constexpr int sub_bucket_count = 1 << Histogram::sub_bucket_bits;
+	static constexpr int sub_bucket_half = sub_bucket_count / 2;
+	static constexpr uint64_t max_trackable = (static_cast<uint64_t>(1) << Histogram::max_value_bits) - 1;
+
+	// Returns position of highest set bit.
+	static int highest_bit(uint64_t value)
+	{
+		auto res = 0;
+		for (auto shift = 32; shift > 0; shift /= 2)
+		{
+			if (value >> shift)
+			{
+				value >>= shift;
+				res += shift;
+			}
+		}
+		return res;
+	}
+
+	Histogram::Histogram(void) : buckets(bucket_index(max_trackable) + 1, 0u), count(0), max_value(0), sum(0.0)
+	{
+	}
+
+	int Histogram::bucket_index(uint64_t value)
+	{
+		value = std::min(value, max_trackable);
+		if (value < static_cast<uint64_t>(sub_bucket_count))
+			return static_cast<int>(value);
+		// value >> shift is in [sub_bucket_half, sub_bucket_count)
+		const auto shift = highest_bit(value) - (sub_bucket_bits - 1);
+		return (shift + 1) * sub_bucket_half + static_cast<int>(value >> shift) - sub_bucket_half;
+	}
+
+	uint64_t Histogram::bucket_limit(int index)
+	{
+		if (index < sub_bucket_count)
+			return static_cast<uint64_t>(index);
+		const auto shift = index / sub_bucket_half - 1;
+		const auto sub = static_cast<uint64_t>(index % sub_bucket_half + sub_bucket_half);
+		return ((sub + 1) << shift) - 1;
+	}
+
+	void Histogram::record(uint64_t value)
+	{
+		buckets[bucket_index(value)]++;
+		count++;
+		max_value = std::max(max_value, value);
+		sum += static_cast<double>(value);
+	}
+
+	void Histogram::merge(const Histogram& h)
+	{
+		for (std::size_t i = 0; i < buckets.size(); i++)
+		{
+			buckets[i] += h.buckets[i];
+		}
+		count += h.count;
+		max_value = std::max(max_value, h.max_value);
+		sum += h.sum;
+	}
+
+	void Histogram::reset(void)
+	{
+		std::fill(buckets.begin(), buckets.end(), 0u);
+		count = 0;
+		max_value = 0;
+		sum = 0.0;
+	}
+
+	uint64_t Histogram::percentile(double p) const
+	{
+		if (count == 0)
+			return 0;
+		const auto target = std::max(static_cast<uint64_t>(1),
+			static_cast<uint64_t>(std::ceil(std::min(p, 100.0) / 100.0 * static_cast<double>(count))));
+		uint64_t total = 0;
+		for (std::size_t i = 0; i < buckets.size(); i++)
+		{
+			total += buckets[i];
+			if (total >= target)
+				return std::min(bucket_limit(static_cast<int>(i)), max_value);
+		}
+		return max_value;
+	}
+
+	Percentiles Histogram::summarize(double scale) const
+	{
+		Percentiles res;
+		res.count = count;
+		res.mean = get_mean() * scale;
+		res.p50 = static_cast<double>(percentile(50.0)) * scale;
+		res.p95 = static_cast<double>(percentile(95.0)) * scale;
+		res.p99 = static_cast<double>(percentile(99.0)) * scale;
+		res.max = static_cast<double>(max_value) * scale;
+		return res;
+	}
+
+	SlidingHistogram::SlidingHistogram(int window_size) : current(0), interval_size(1), interval_count(0)
+	{
+		set_window(window_size);
+	}
+
+	void SlidingHistogram::set_window(int window_size)
+	{
+		interval_size = std::max(1, window_size / num_intervals);
+		reset();
+	}
+
+	void SlidingHistogram::record(uint64_t value)
+	{
+		if (interval_count == interval_size)
+		{
+			current = (current + 1) % num_intervals;
+			intervals[current].reset();
+			interval_count = 0;
+		}
+		intervals[current].record(value);
+		interval_count++;
+	}
+
+	void SlidingHistogram::reset(void)
+	{
+		for (auto& h : intervals)
+		{
+			h.reset();
+		}
+		current = 0;
+		interval_count = 0;
+	}
+
+	Histogram SlidingHistogram::collect(void) const
+	{
+		Histogram res;
+		for (const auto& h : intervals)
+		{
+			res.merge(h);
+		}
+		return res;
+	}
+}
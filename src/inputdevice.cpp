@@ -3,7 +3,7 @@
 
 namespace dukat
 {
-	std::map<InputDevice::VirtualButton, std::function<void(void)>> InputDevice::handlers;
+	std::array<Delegate<void(void)>, InputDevice::VirtualButton::_Count> InputDevice::handlers;
 
 	void InputDevice::update_button_state(VirtualButton button, bool pressed)
 	{
@@ -11,7 +11,7 @@ namespace dukat
 		if (pressed != buttons[button])
 		{
 			buttons[button] = pressed;
-			if (pressed && handlers.count(button) > 0)
+			if (pressed && handlers[button] != nullptr)
 			{
 				handlers[button]();
 			}
@@ -0,0 +1,129 @@
+#include "stdafx.h"
+#include <dukat/mappedfile.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dukat
+{
+#ifdef _WIN32
+	MappedFile::MappedFile(void) : data(nullptr), size(0), file_handle(INVALID_HANDLE_VALUE), map_handle(nullptr)
+	{
+	}
+#else
+	MappedFile::MappedFile(void) : data(nullptr), size(0), fd(-1)
+	{
+	}
+#endif
+
+	MappedFile::MappedFile(const std::string& filename) : MappedFile()
+	{
+		open(filename);
+	}
+
+#ifdef _WIN32
+	void MappedFile::open(const std::string& filename)
+	{
+		close();
+
+		file_handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, 
+			OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file_handle == INVALID_HANDLE_VALUE)
+		{
+			throw std::runtime_error("Could not open file: " + filename);
+		}
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+		{
+			close();
+			throw std::runtime_error("Could not determine size of file: " + filename);
+		}
+		size = static_cast<size_t>(file_size.QuadPart);
+
+		map_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (map_handle == nullptr)
+		{
+			close();
+			throw std::runtime_error("Could not map file: " + filename);
+		}
+
+		data = static_cast<const uint8_t*>(MapViewOfFile(map_handle, FILE_MAP_READ, 0, 0, 0));
+		if (data == nullptr)
+		{
+			close();
+			throw std::runtime_error("Could not map file: " + filename);
+		}
+	}
+
+	void MappedFile::close(void)
+	{
+		if (data != nullptr)
+		{
+			UnmapViewOfFile(data);
+			data = nullptr;
+		}
+		if (map_handle != nullptr)
+		{
+			CloseHandle(map_handle);
+			map_handle = nullptr;
+		}
+		if (file_handle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(file_handle);
+			file_handle = INVALID_HANDLE_VALUE;
+		}
+		size = 0;
+	}
+#else
+	void MappedFile::open(const std::string& filename)
+	{
+		close();
+
+		fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			throw std::runtime_error("Could not open file: " + filename);
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			close();
+			throw std::runtime_error("Could not determine size of file: " + filename);
+		}
+		size = static_cast<size_t>(st.st_size);
+
+		auto ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (ptr == MAP_FAILED)
+		{
+			close();
+			throw std::runtime_error("Could not map file: " + filename);
+		}
+		data = static_cast<const uint8_t*>(ptr);
+		// data will be consumed front to back
+		madvise(ptr, size, MADV_SEQUENTIAL);
+	}
+
+	void MappedFile::close(void)
+	{
+		if (data != nullptr)
+		{
+			munmap(const_cast<uint8_t*>(data), size);
+			data = nullptr;
+		}
+		if (fd >= 0)
+		{
+			::close(fd);
+			fd = -1;
+		}
+		size = 0;
+	}
+#endif
+}
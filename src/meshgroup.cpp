@@ -30,6 +30,10 @@ namespace dukat
 	void MeshGroup::update(float delta)
 	{
 		transform.update();
+		if (!bb.empty())
+		{
+			world_bb.set_to_transformed_box(bb, transform.mat_model);
+		}
 		for (auto& it : instances)
 		{
 			it->update(delta);
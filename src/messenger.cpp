@@ -1,26 +1,70 @@
 #include "stdafx.h"
 #include <dukat/messenger.h>
+#include <dukat/eventbus.h>
 
 namespace dukat
 {
+	Messenger::~Messenger(void)
+	{
+		auto b = bus.load();
+		if (b != nullptr)
+			b->detach(this);
+	}
+
 	void Messenger::trigger(const Message& message)
 	{
-		if (subscriptions.count(message.event))
+		if (message.event >= Events::Any)
+			return;
+
+		// Recipients subscribing during dispatch are deferred, so the
+		// list does not grow and can be walked by index.
+		const auto& recipients = subscriptions[message.event];
+		const auto count = recipients.size();
+		dispatching++;
+		for (std::size_t i = 0; i < count; i++)
+		{
+			if (recipients[i] != nullptr)
+				recipients[i]->receive(message);
+		}
+		if (--dispatching == 0 && (dirty || !pending.empty()))
+			flush();
+	}
+
+	void Messenger::flush(void)
+	{
+		if (dirty)
 		{
-			for (auto r : subscriptions[message.event])
+			for (auto& recipients : subscriptions)
 			{
-				r->receive(message);
+				recipients.erase(std::remove(recipients.begin(), recipients.end(), nullptr), recipients.end());
 			}
+			dirty = false;
 		}
+		for (const auto& p : pending)
+		{
+			subscriptions[p.ev].push_back(p.recipient);
+		}
+		pending.clear();
 	}
 
-	void Messenger::subscribe(Recipient * recipient, Event ev)
+	void Messenger::subscribe(Recipient* recipient, Event ev)
 	{
-		if (subscriptions.count(ev) == 0)
+		if (ev >= Events::Any)
+			throw std::runtime_error("Invalid event.");
+
+		auto& recipients = subscriptions[ev];
+		if (std::find(recipients.begin(), recipients.end(), recipient) != recipients.end())
+			return;
+		if (dispatching > 0)
 		{
-			subscriptions[ev] = std::set<Recipient*>();
+			if (std::none_of(pending.begin(), pending.end(), [&](const Pending& p) {
+				return p.recipient == recipient && p.ev == ev; }))
+				pending.push_back(Pending{ recipient, ev });
+		}
+		else
+		{
+			recipients.push_back(recipient);
 		}
-		subscriptions[ev].insert(recipient);
 	}
 
 	void Messenger::subscribe(Recipient * recipient, const std::vector<Event>& events)
@@ -38,9 +82,29 @@ namespace dukat
 
 	void Messenger::unsubscribe(Recipient* recipient, Event ev)
 	{
-		if (subscriptions.count(ev))
+		if (ev >= Events::Any)
+			return;
+
+		auto& recipients = subscriptions[ev];
+		auto it = std::find(recipients.begin(), recipients.end(), recipient);
+		if (it != recipients.end())
 		{
-			subscriptions[ev].erase(recipient);
+			if (dispatching > 0)
+			{
+				*it = nullptr;
+				dirty = true;
+			}
+			else
+			{
+				recipients.erase(it);
+			}
+		}
+
+		if (!pending.empty())
+		{
+			pending.erase(std::remove_if(pending.begin(), pending.end(), [&](const Pending& p) {
+				return p.recipient == recipient && p.ev == ev;
+			}), pending.end());
 		}
 	}
 
@@ -51,9 +115,9 @@ namespace dukat
 
 	void Messenger::unsubscribe_all(Recipient* recipient)
 	{
-		for (auto it = subscriptions.begin(); it != subscriptions.end(); ++it)
+		for (auto it = Events::None; it != Events::Any; ++it)
 		{
-			it->second.erase(recipient);
+			unsubscribe(recipient, it);
 		}
 	}
 }
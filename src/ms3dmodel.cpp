@@ -5,16 +5,42 @@
 #include <dukat/mathutil.h>
 #include <dukat/model3.h>
 #include <dukat/ms3dmodel.h>
+#include <dukat/quaternion.h>
+#include <dukat/skeleton.h>
+#include <dukat/skinnedmesh.h>
 
 namespace dukat
 {
-	std::unique_ptr<Model3> MS3DModel::convert(void)
+	// Joint index used for vertices not attached to any joint
+	static constexpr uint8_t no_joint = 0xff;
+
+	// Convert from left-handed to right-handed coordinate system.
+	// align default orientation with Z axis. Since we're only rotating,
+	// x axis coordinates will be flipped.
+	static Matrix4 model_transform(void)
 	{
-		// Convert from left-handed to right-handed coordinate system.
-		// align default orientation with Z axis. Since we're only rotating,
-		// x axis coordinates will be flipped.
 		Matrix4 m;
 		m.setup_rotation(Vector3::unit_y, -pi_over_two);
+		return m;
+	}
+
+	// Converts MS3D Euler angles, applied in order x, y, z, to a quaternion.
+	static Quaternion euler_to_quaternion(const float* angles)
+	{
+		const auto cr = std::cos(angles[0] * 0.5f), sr = std::sin(angles[0] * 0.5f);
+		const auto cp = std::cos(angles[1] * 0.5f), sp = std::sin(angles[1] * 0.5f);
+		const auto cy = std::cos(angles[2] * 0.5f), sy = std::sin(angles[2] * 0.5f);
+		return Quaternion{
+			cr * cp * cy + sr * sp * sy,
+			sr * cp * cy - cr * sp * sy,
+			cr * sp * cy + sr * cp * sy,
+			cr * cp * sy - sr * sp * cy
+		};
+	}
+
+	std::unique_ptr<Model3> MS3DModel::convert(void)
+	{
+		const auto m = model_transform();
 
 		auto res = std::make_unique<Model3>();
 		for (auto& mesh : meshes)
@@ -53,6 +79,81 @@ namespace dukat
 		return std::move(res);
 	}
 
+	std::unique_ptr<Skeleton> MS3DModel::create_skeleton(void) const
+	{
+		auto res = std::make_unique<Skeleton>();
+		res->set_root(model_transform());
+		Matrix4 local;
+		for (auto i = 0; i < static_cast<int>(joints.size()); i++)
+		{
+			const auto& joint = joints[i];
+			auto parent = -1;
+			if (joint.parent_nname[0] != 0)
+			{
+				for (auto j = 0; j < i; j++)
+				{
+					if (strncmp(joints[j].name, joint.parent_nname, 32) == 0)
+					{
+						parent = j;
+						break;
+					}
+				}
+				if (parent < 0)
+					throw std::runtime_error("Invalid parent joint in MS3D file.");
+			}
+			local.setup_rotation(euler_to_quaternion(joint.rotation));
+			local.m[12] = joint.translation[0];
+			local.m[13] = joint.translation[1];
+			local.m[14] = joint.translation[2];
+			res->add_joint(parent, local);
+		}
+		return res;
+	}
+
+	std::unique_ptr<AnimationClip> MS3DModel::create_clip(void) const
+	{
+		auto res = std::make_unique<AnimationClip>();
+		for (const auto& joint : joints)
+		{
+			res->add_joint();
+			for (const auto& key : joint.rotation_keys)
+			{
+				res->add_rotation_key(key.time, euler_to_quaternion(key.parameter));
+			}
+			for (const auto& key : joint.translation_keys)
+			{
+				res->add_translation_key(key.time, Vector3{ key.parameter[0], key.parameter[1], key.parameter[2] });
+			}
+		}
+		if (fps > 0.0f)
+			res->set_duration(static_cast<float>(total_frames) / fps);
+		return res;
+	}
+
+	std::unique_ptr<SkinnedMesh> MS3DModel::create_skinned_mesh(int mesh) const
+	{
+		std::vector<Vector3> positions;
+		std::vector<Vector3> normals;
+		std::vector<int> vertex_joints;
+		for (auto idx : meshes[mesh].indices)
+		{
+			const auto& t = triangles[idx];
+			for (auto i = 0; i < 3; i++)
+			{
+				const auto& v = vertices[t.indicies[i]];
+				positions.push_back(Vector3{ v.v[0], v.v[1], v.v[2] });
+				normals.push_back(Vector3{ t.normals[i * 3], t.normals[i * 3 + 1], t.normals[i * 3 + 2] });
+				// unattached vertices use the root transform at the end of the palette
+				vertex_joints.push_back(v.boneId == no_joint || v.boneId >= joints.size()
+					? static_cast<int>(joints.size()) : static_cast<int>(v.boneId));
+			}
+		}
+
+		auto res = std::make_unique<SkinnedMesh>();
+		res->set_vertices(positions.data(), normals.data(), vertex_joints.data(), static_cast<int>(positions.size()));
+		return res;
+	}
+
 	std::istream& operator>>(std::istream& is, MS3DModel& m)
 	{
 		// Load header
@@ -133,8 +234,44 @@ namespace dukat
 			m.materials.push_back(material);
 		}
 
-		log->debug("Loaded MS3D model: {} vertices, {} polygons, {} meshes, {} materials.",
-			m.header.vertices, m.header.polygons, m.header.meshes, m.header.materials);
+		// Load joints and keyframes. Older files may end after the materials.
+		m.joints.resize(0);
+		m.fps = 0.0f;
+		m.total_frames = 0;
+		float current_time;
+		uint16_t num_joints = 0;
+		is.read(reinterpret_cast<char*>(&m.fps), sizeof(float));
+		is.read(reinterpret_cast<char*>(&current_time), sizeof(float));
+		is.read(reinterpret_cast<char*>(&m.total_frames), sizeof(int32_t));
+		is.read(reinterpret_cast<char*>(&num_joints), sizeof(uint16_t));
+		if (!is)
+		{
+			is.clear();
+			num_joints = 0;
+		}
+		for (auto i = 0; i < num_joints; i++)
+		{
+			MS3DModel::Joint joint;
+			is.read(reinterpret_cast<char*>(&joint.flags), sizeof(uint8_t));
+			is.read(reinterpret_cast<char*>(&joint.name), sizeof(char) * 32);
+			is.read(reinterpret_cast<char*>(&joint.parent_nname), sizeof(char) * 32);
+			is.read(reinterpret_cast<char*>(&joint.rotation), sizeof(float) * 3);
+			is.read(reinterpret_cast<char*>(&joint.translation), sizeof(float) * 3);
+			is.read(reinterpret_cast<char*>(&joint.num_rotation_keyframes), sizeof(uint16_t));
+			is.read(reinterpret_cast<char*>(&joint.num_translation_keyframes), sizeof(uint16_t));
+			joint.rotation_keys.resize(joint.num_rotation_keyframes);
+			is.read(reinterpret_cast<char*>(joint.rotation_keys.data()), sizeof(MS3DModel::Keyframe) * joint.num_rotation_keyframes);
+			joint.translation_keys.resize(joint.num_translation_keyframes);
+			is.read(reinterpret_cast<char*>(joint.translation_keys.data()), sizeof(MS3DModel::Keyframe) * joint.num_translation_keyframes);
+			if (!is)
+			{
+				throw std::runtime_error("Invalid MS3D joint data.");
+			}
+			m.joints.push_back(std::move(joint));
+		}
+
+		log->debug("Loaded MS3D model: {} vertices, {} polygons, {} meshes, {} materials, {} joints.",
+			m.header.vertices, m.header.polygons, m.header.meshes, m.header.materials, m.joints.size());
 
 		return is;
 	}
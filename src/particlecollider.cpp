@@ -0,0 +1,366 @@
+#include "stdafx.h"
+#include <dukat/particlecollider.h>
+#include <dukat/collisionmanager2.h>
+#include <dukat/heightmap.h>
+#include <dukat/mathutil.h>
+#include <dukat/particle.h>
+#include <dukat/particledata.h>
+#include <dukat/simd.h>
+
+namespace dukat
+{
+	// Upper limit for number of cells along each axis of the body grid
+	static constexpr int max_grid_cells = 256;
+	// Number of boxes tested at once
+	static constexpr int box_block = 8;
+
+	ParticleCollider::ParticleCollider(float cell_size) : cell_size(cell_size), inv_cell_size(1.0f / cell_size),
+		grid_width(0), grid_height(0), terrain_spacing(1.0f), response(Bounce), restitution(0.5f), friction(0.8f)
+	{
+		cell_start.push_back(0);
+	}
+
+	void ParticleCollider::clear(void)
+	{
+		grid_width = grid_height = 0;
+		cell_start.assign(1, 0);
+		box_min_x.clear(); box_min_y.clear();
+		box_max_x.clear(); box_max_y.clear();
+		ground.clear();
+	}
+
+	void ParticleCollider::set_response(Response response, float restitution, float friction)
+	{
+		this->response = response;
+		this->restitution = restitution;
+		this->friction = friction;
+	}
+
+	void ParticleCollider::snapshot(const CollisionManager2& cm)
+	{
+		std::vector<const CollisionManager2::Body*> bodies;
+		cm.collect_static_bodies(bodies);
+
+		grid_width = grid_height = 0;
+		cell_start.assign(1, 0);
+		if (bodies.empty())
+			return;
+
+		AABB2 bounds;
+		for (auto b : bodies)
+		{
+			bounds.add(b->bb);
+		}
+		// Grow cells if the bodies span too large an area
+		const auto extent = std::max(bounds.width(), bounds.height());
+		const auto size = std::max(cell_size, extent / static_cast<float>(max_grid_cells));
+		grid_origin = bounds.min;
+		inv_cell_size = 1.0f / size;
+		grid_width = std::max(1, static_cast<int>(std::ceil(bounds.width() * inv_cell_size)));
+		grid_height = std::max(1, static_cast<int>(std::ceil(bounds.height() * inv_cell_size)));
+
+		// Returns range of cells a box overlaps
+		const auto cell_range = [&](const AABB2& bb, int& x0, int& y0, int& x1, int& y1) {
+			x0 = static_cast<int>((bb.min.x - grid_origin.x) * inv_cell_size);
+			y0 = static_cast<int>((bb.min.y - grid_origin.y) * inv_cell_size);
+			x1 = static_cast<int>((bb.max.x - grid_origin.x) * inv_cell_size);
+			y1 = static_cast<int>((bb.max.y - grid_origin.y) * inv_cell_size);
+			clamp(x0, 0, grid_width - 1); clamp(x1, 0, grid_width - 1);
+			clamp(y0, 0, grid_height - 1); clamp(y1, 0, grid_height - 1);
+		};
+
+		// Count boxes per cell, padded to full blocks
+		const auto num_cells = grid_width * grid_height;
+		std::vector<int> counts(num_cells, 0);
+		int x0, y0, x1, y1;
+		for (auto b : bodies)
+		{
+			cell_range(b->bb, x0, y0, x1, y1);
+			for (auto y = y0; y <= y1; y++)
+				for (auto x = x0; x <= x1; x++)
+					counts[y * grid_width + x]++;
+		}
+		cell_start.resize(num_cells + 1);
+		cell_start[0] = 0;
+		for (auto c = 0; c < num_cells; c++)
+		{
+			const auto padded = (counts[c] + box_block - 1) / box_block * box_block;
+			cell_start[c + 1] = cell_start[c] + padded;
+		}
+
+		// Padding boxes are empty and never contain a point
+		const auto total = cell_start[num_cells];
+		box_min_x.assign(total, big_number); box_min_y.assign(total, big_number);
+		box_max_x.assign(total, -big_number); box_max_y.assign(total, -big_number);
+		std::vector<int> cursor(cell_start.begin(), cell_start.end() - 1);
+		for (auto b : bodies)
+		{
+			cell_range(b->bb, x0, y0, x1, y1);
+			for (auto y = y0; y <= y1; y++)
+			{
+				for (auto x = x0; x <= x1; x++)
+				{
+					const auto i = cursor[y * grid_width + x]++;
+					box_min_x[i] = b->bb.min.x; box_min_y[i] = b->bb.min.y;
+					box_max_x[i] = b->bb.max.x; box_max_y[i] = b->bb.max.y;
+				}
+			}
+		}
+	}
+
+	void ParticleCollider::set_terrain(const HeightMap& hm, int level, int row, const Vector2& origin, float spacing, float height)
+	{
+		const auto size = hm.get_level_size() >> level;
+		ground.resize(size);
+		for (auto i = 0; i < size; i++)
+		{
+			ground[i] = origin.y - hm.get_elevation(i, row, level) * height;
+		}
+		terrain_origin = origin;
+		terrain_spacing = spacing;
+	}
+
+	void ParticleCollider::resolve(ParticleData& d, int i, const Vector2& surface, const Vector2& normal) const
+	{
+		switch (response)
+		{
+		case Kill:
+			d.ttl[i] = 0.0f;
+			d.flags[i] &= ~Particle::Colliding;
+			break;
+
+		case Stick:
+			d.px[i] = surface.x;
+			d.py[i] = surface.y;
+			d.dx[i] = d.dy[i] = 0.0f;
+			d.flags[i] &= ~(Particle::Linear | Particle::Gravitational | Particle::Colliding);
+			break;
+
+		case Bounce:
+		{
+			d.px[i] = surface.x;
+			d.py[i] = surface.y;
+			const Vector2 v{ d.dx[i], d.dy[i] };
+			const auto vn = v * normal;
+			if (vn < 0.0f) // moving into surface
+			{
+				const auto vt = v - normal * vn;
+				const auto res = vt * friction - normal * (vn * restitution);
+				d.dx[i] = res.x;
+				d.dy[i] = res.y;
+			}
+			break;
+		}
+		}
+	}
+
+	void ParticleCollider::resolve_box(ParticleData& d, int i, int box) const
+	{
+		const auto px = d.px[i], py = d.py[i];
+		const auto dx = d.dx[i], dy = d.dy[i];
+		// Penetration depth for each side, considering only sides the particle
+		// moves towards; y points down, so min.y is the top of a box.
+		const float depth[4] = {
+			px - box_min_x[box],	// left
+			box_max_x[box] - px,	// right
+			py - box_min_y[box],	// top
+			box_max_y[box] - py		// bottom
+		};
+		const bool towards[4] = { dx > 0.0f, dx < 0.0f, dy > 0.0f, dy < 0.0f };
+		auto side = -1;
+		for (auto k = 0; k < 4; k++)
+		{
+			if (towards[k] && (side < 0 || depth[k] < depth[side]))
+				side = k;
+		}
+		if (side < 0)
+			side = 2; // resting particle, push to top
+
+		switch (side)
+		{
+		case 0:
+			resolve(d, i, Vector2{ box_min_x[box], py }, Vector2{ -1.0f, 0.0f });
+			break;
+		case 1:
+			resolve(d, i, Vector2{ box_max_x[box], py }, Vector2{ 1.0f, 0.0f });
+			break;
+		case 2:
+			resolve(d, i, Vector2{ px, box_min_y[box] }, Vector2{ 0.0f, -1.0f });
+			break;
+		default:
+			resolve(d, i, Vector2{ px, box_max_y[box] }, Vector2{ 0.0f, 1.0f });
+			break;
+		}
+	}
+
+#ifdef DUKAT_AVX2
+	// Tests a point against one block of 8 boxes. Returns bit mask of boxes containing it.
+	DUKAT_TARGET_AVX2 static inline int contains_avx2(const float* min_x, const float* min_y,
+		const float* max_x, const float* max_y, __m256 px, __m256 py)
+	{
+		const auto in_x = _mm256_and_ps(_mm256_cmp_ps(px, _mm256_loadu_ps(min_x), _CMP_GE_OQ),
+			_mm256_cmp_ps(px, _mm256_loadu_ps(max_x), _CMP_LE_OQ));
+		const auto in_y = _mm256_and_ps(_mm256_cmp_ps(py, _mm256_loadu_ps(min_y), _CMP_GE_OQ),
+			_mm256_cmp_ps(py, _mm256_loadu_ps(max_y), _CMP_LE_OQ));
+		return _mm256_movemask_ps(_mm256_and_ps(in_x, in_y));
+	}
+
+	DUKAT_TARGET_AVX2 static int find_box_avx2(const float* min_x, const float* min_y,
+		const float* max_x, const float* max_y, int begin, int end, float x, float y)
+	{
+		const auto px = _mm256_set1_ps(x);
+		const auto py = _mm256_set1_ps(y);
+		for (auto i = begin; i < end; i += box_block)
+		{
+			const auto mask = contains_avx2(min_x + i, min_y + i, max_x + i, max_y + i, px, py);
+			if (mask != 0)
+			{
+				for (auto k = 0; k < box_block; k++)
+				{
+					if (mask & (1 << k))
+						return i + k;
+				}
+			}
+		}
+		return -1;
+	}
+#endif
+
+	int ParticleCollider::find_box(float px, float py) const
+	{
+		const auto fx = (px - grid_origin.x) * inv_cell_size;
+		const auto fy = (py - grid_origin.y) * inv_cell_size;
+		if (fx < 0.0f || fy < 0.0f)
+			return -1;
+		const auto cx = static_cast<int>(fx);
+		const auto cy = static_cast<int>(fy);
+		if (cx >= grid_width || cy >= grid_height)
+			return -1;
+
+		const auto cell = cy * grid_width + cx;
+		const auto begin = cell_start[cell];
+		const auto end = cell_start[cell + 1];
+#ifdef DUKAT_AVX2
+		if (cpu_has_avx2())
+		{
+			return find_box_avx2(box_min_x.data(), box_min_y.data(), box_max_x.data(), box_max_y.data(),
+				begin, end, px, py);
+		}
+#endif
+		for (auto i = begin; i < end; i++)
+		{
+			if (px >= box_min_x[i] && px <= box_max_x[i] && py >= box_min_y[i] && py <= box_max_y[i])
+				return i;
+		}
+		return -1;
+	}
+
+	void ParticleCollider::resolve_terrain(ParticleData& d, int i) const
+	{
+		const auto last = static_cast<int>(ground.size()) - 1;
+		const auto u = (d.px[i] - terrain_origin.x) / terrain_spacing;
+		const auto k = std::min(static_cast<int>(u), last - 1);
+		const auto f = u - static_cast<float>(k);
+		const auto g0 = ground[k], g1 = ground[k + 1];
+		const auto gy = g0 + (g1 - g0) * f;
+		// Surface normal points away from the ground, towards -y
+		auto normal = Vector2{ (g1 - g0) / terrain_spacing, -1.0f };
+		normal.normalize();
+		resolve(d, i, Vector2{ d.px[i], gy }, normal);
+	}
+
+#ifdef DUKAT_AVX2
+	// Returns mask of 8 particles at or below the terrain profile.
+	DUKAT_TARGET_AVX2 static int below_ground_avx2(const ParticleData& d, int i, const float* ground, int last,
+		float origin_x, float inv_spacing)
+	{
+		const auto flags = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(d.flags.data() + i)));
+		const auto colliding = _mm256_set1_epi32(Particle::Colliding);
+		const auto active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(flags, colliding), colliding));
+
+		const auto u = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&d.px[i]), _mm256_set1_ps(origin_x)),
+			_mm256_set1_ps(inv_spacing));
+		const auto in_range = _mm256_and_ps(_mm256_cmp_ps(u, _mm256_setzero_ps(), _CMP_GE_OQ),
+			_mm256_cmp_ps(u, _mm256_set1_ps(static_cast<float>(last)), _CMP_LE_OQ));
+		// clamp so out of range lanes gather valid samples
+		const auto uc = _mm256_min_ps(_mm256_max_ps(u, _mm256_setzero_ps()), _mm256_set1_ps(static_cast<float>(last)));
+		const auto k = _mm256_min_epi32(_mm256_cvttps_epi32(uc), _mm256_set1_epi32(last - 1));
+		const auto f = _mm256_sub_ps(uc, _mm256_cvtepi32_ps(k));
+		const auto g0 = _mm256_i32gather_ps(ground, k, 4);
+		const auto g1 = _mm256_i32gather_ps(ground, _mm256_add_epi32(k, _mm256_set1_epi32(1)), 4);
+		const auto gy = _mm256_add_ps(g0, _mm256_mul_ps(_mm256_sub_ps(g1, g0), f));
+		const auto below = _mm256_cmp_ps(_mm256_loadu_ps(&d.py[i]), gy, _CMP_GE_OQ);
+		return _mm256_movemask_ps(_mm256_and_ps(_mm256_and_ps(active, in_range), below));
+	}
+#endif
+
+	int ParticleCollider::collide_terrain(ParticleData& d, int begin, int end) const
+	{
+		const auto last = static_cast<int>(ground.size()) - 1;
+		if (last < 1)
+			return 0;
+
+		const auto inv_spacing = 1.0f / terrain_spacing;
+		auto hits = 0;
+		auto i = begin;
+#ifdef DUKAT_AVX2
+		if (cpu_has_avx2())
+		{
+			for (; i + box_block <= end; i += box_block)
+			{
+				const auto mask = below_ground_avx2(d, i, ground.data(), last, terrain_origin.x, inv_spacing);
+				if (mask == 0)
+					continue;
+				for (auto k = 0; k < box_block; k++)
+				{
+					if (mask & (1 << k))
+					{
+						resolve_terrain(d, i + k);
+						hits++;
+					}
+				}
+			}
+		}
+#endif
+		for (; i < end; i++)
+		{
+			if ((d.flags[i] & Particle::Colliding) != Particle::Colliding)
+				continue;
+			const auto u = (d.px[i] - terrain_origin.x) * inv_spacing;
+			if (u < 0.0f || u > static_cast<float>(last))
+				continue;
+			const auto k = std::min(static_cast<int>(u), last - 1);
+			const auto f = u - static_cast<float>(k);
+			if (d.py[i] >= ground[k] + (ground[k + 1] - ground[k]) * f)
+			{
+				resolve_terrain(d, i);
+				hits++;
+			}
+		}
+		return hits;
+	}
+
+	int ParticleCollider::collide(ParticleData& d, int begin, int end) const
+	{
+		auto hits = 0;
+		if (!ground.empty())
+		{
+			hits += collide_terrain(d, begin, end);
+		}
+		if (grid_width > 0)
+		{
+			for (auto i = begin; i < end; i++)
+			{
+				if ((d.flags[i] & Particle::Colliding) != Particle::Colliding)
+					continue;
+				const auto box = find_box(d.px[i], d.py[i]);
+				if (box >= 0)
+				{
+					resolve_box(d, i, box);
+					hits++;
+				}
+			}
+		}
+		return hits;
+	}
+}
@@ -0,0 +1,303 @@
+#include "stdafx.h"
+#include <dukat/particledata.h>
+#include <dukat/simd.h>
+
+namespace dukat
+{
+	ParticleData::ParticleData(int budget) : count(0), capacity(0), budget(budget), overflow(0)
+	{
+	}
+
+	bool ParticleData::grow(void)
+	{
+		if (full())
+			return false;
+
+		capacity += chunk_size;
+		for (auto column : { &px, &py, &dx, &dy, &cr, &cg, &cb, &ca, &dr, &dg, &db, &da, &size, &dsize, &ttl, &ry })
+		{
+			column->resize(capacity, 0.0f);
+		}
+		flags.resize(capacity, 0);
+		layer.resize(capacity, 0);
+		return true;
+	}
+
+	void ParticleData::move(int from, int to)
+	{
+		px[to] = px[from]; py[to] = py[from];
+		dx[to] = dx[from]; dy[to] = dy[from];
+		cr[to] = cr[from]; cg[to] = cg[from]; cb[to] = cb[from]; ca[to] = ca[from];
+		dr[to] = dr[from]; dg[to] = dg[from]; db[to] = db[from]; da[to] = da[from];
+		size[to] = size[from]; dsize[to] = dsize[from];
+		ttl[to] = ttl[from];
+		ry[to] = ry[from];
+		flags[to] = flags[from];
+		layer[to] = layer[from];
+	}
+
+	int ParticleData::insert(int layer_index, int n)
+	{
+		while (count + n > capacity)
+		{
+			grow();
+		}
+		if (layer_index >= static_cast<int>(layer_end.size()))
+		{
+			layer_end.resize(layer_index + 1, count);
+		}
+
+		// Shift ranges of later layers up by n, starting with the last one. Only
+		// the first n particles of a range need to move to its end.
+		for (auto l = static_cast<int>(layer_end.size()) - 1; l > layer_index; l--)
+		{
+			const auto begin = layer_end[l - 1];
+			const auto end = layer_end[l];
+			const auto moves = std::min(n, end - begin);
+			for (auto k = 0; k < moves; k++)
+			{
+				move(begin + k, end + n - moves + k);
+			}
+			layer_end[l] += n;
+		}
+
+		const auto res = layer_end[layer_index];
+		layer_end[layer_index] += n;
+		count += n;
+		return res;
+	}
+
+	ParticleData::Range ParticleData::spawn(int layer_index, int n)
+	{
+		if (budget > 0)
+		{
+			const auto allowed = std::min(n, std::max(0, budget - count));
+			overflow += n - allowed;
+			n = allowed;
+		}
+		if (n <= 0)
+			return Range{ count, count };
+
+		const auto begin = insert(layer_index, n);
+		std::fill(layer.begin() + begin, layer.begin() + begin + n, static_cast<uint16_t>(layer_index));
+		return Range{ begin, begin + n };
+	}
+
+	int ParticleData::add(const Particle& p, int layer_index)
+	{
+		const auto r = spawn(layer_index, 1);
+		if (r.size() == 0)
+			return -1;
+
+		const auto i = r.begin;
+		px[i] = p.pos.x; py[i] = p.pos.y;
+		dx[i] = p.dp.x; dy[i] = p.dp.y;
+		cr[i] = p.color.r; cg[i] = p.color.g; cb[i] = p.color.b; ca[i] = p.color.a;
+		dr[i] = p.dc.r; dg[i] = p.dc.g; db[i] = p.dc.b; da[i] = p.dc.a;
+		size[i] = p.size; dsize[i] = p.dsize;
+		ttl[i] = p.ttl;
+		ry[i] = p.ry;
+		flags[i] = p.flags;
+		return i;
+	}
+
+	int ParticleData::append(const ParticleData& src)
+	{
+		auto total = 0;
+		for (auto l = 0; l < static_cast<int>(src.layer_end.size()); l++)
+		{
+			const auto src_begin = src.get_layer_begin(l);
+			const auto r = spawn(l, src.layer_end[l] - src_begin);
+			const auto n = r.size();
+			if (n == 0)
+				continue;
+
+			const auto dst = r.begin;
+			const auto copy = [&](const std::vector<float>& from, std::vector<float>& to) {
+				std::copy(from.begin() + src_begin, from.begin() + src_begin + n, to.begin() + dst);
+			};
+			copy(src.px, px); copy(src.py, py);
+			copy(src.dx, dx); copy(src.dy, dy);
+			copy(src.cr, cr); copy(src.cg, cg); copy(src.cb, cb); copy(src.ca, ca);
+			copy(src.dr, dr); copy(src.dg, dg); copy(src.db, db); copy(src.da, da);
+			copy(src.size, size); copy(src.dsize, dsize);
+			copy(src.ttl, ttl);
+			copy(src.ry, ry);
+			std::copy(src.flags.begin() + src_begin, src.flags.begin() + src_begin + n, flags.begin() + dst);
+			total += n;
+		}
+		return total;
+	}
+
+	Particle ParticleData::get(int i) const
+	{
+		Particle p;
+		p.pos = Vector2{ px[i], py[i] };
+		p.dp = Vector2{ dx[i], dy[i] };
+		p.color = Color{ cr[i], cg[i], cb[i], ca[i] };
+		p.dc = Color{ dr[i], dg[i], db[i], da[i] };
+		p.size = size[i]; p.dsize = dsize[i];
+		p.ttl = ttl[i];
+		p.ry = ry[i];
+		p.flags = flags[i];
+		return p;
+	}
+
+	void ParticleData::clear(void)
+	{
+		count = 0;
+		layer_end.clear();
+	}
+
+	void ParticleData::compact(void)
+	{
+		auto write = 0;
+		auto begin = 0;
+		for (auto& end : layer_end)
+		{
+			const auto next_begin = end;
+			// swap-remove expired particles within the range
+			auto last = end;
+			auto i = begin;
+			while (i < last)
+			{
+				if (ttl[i] <= 0.0f)
+				{
+					if (i != --last)
+						move(last, i); // re-check slot, it now holds the last particle
+				}
+				else
+				{
+					i++;
+				}
+			}
+
+			// close gap to previous range by moving particles from its end
+			const auto len = last - begin;
+			const auto moves = std::min(begin - write, len);
+			for (auto k = 0; k < moves; k++)
+			{
+				move(last - moves + k, write + k);
+			}
+			write += len;
+			end = write;
+			begin = next_begin;
+		}
+		count = write;
+	}
+
+	void ParticleData::update(float delta, float gravity, float dampening)
+	{
+		compact();
+		integrate(0, count, delta, gravity, dampening);
+	}
+
+	// Integrates a single particle. Reference for the SIMD kernel, which has to
+	// produce identical results.
+	static inline void integrate_scalar(ParticleData& d, int i, float delta, float gravity, float dampening)
+	{
+		const auto f = d.flags[i];
+		d.ttl[i] -= delta;
+		if ((f & Particle::Linear) == Particle::Linear)
+		{
+			d.px[i] += d.dx[i] * delta;
+			d.py[i] += d.dy[i] * delta;
+		}
+		// For gravitational particles, only apply effect as long as we're above
+		// reflection line
+		if ((f & Particle::Gravitational) == Particle::Gravitational)
+		{
+			if (d.py[i] < d.ry[i])
+				d.dy[i] += gravity * delta;
+			else
+				d.py[i] = d.ry[i];
+		}
+		if ((f & Particle::Dampened) == Particle::Dampened)
+		{
+			d.dx[i] *= dampening;
+			d.dy[i] *= dampening;
+		}
+		d.cr[i] += d.dr[i] * delta;
+		d.cg[i] += d.dg[i] * delta;
+		d.cb[i] += d.db[i] * delta;
+		d.ca[i] += d.da[i] * delta;
+		d.size[i] += d.dsize[i] * delta;
+	}
+
+#ifdef DUKAT_AVX2
+	// Returns lanes of 8 particles that have a flag set as a float mask.
+	DUKAT_TARGET_AVX2 static inline __m256 flag_mask(__m256i flags, int flag)
+	{
+		const auto f = _mm256_set1_epi32(flag);
+		return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(flags, f), f));
+	}
+
+	// Computes value += change * delta for 8 particles.
+	DUKAT_TARGET_AVX2 static inline void accumulate(float* value, const float* change, __m256 delta)
+	{
+		_mm256_storeu_ps(value, _mm256_add_ps(_mm256_loadu_ps(value), _mm256_mul_ps(_mm256_loadu_ps(change), delta)));
+	}
+
+	// Integrates blocks of 8 particles starting at begin. Returns index of first
+	// particle not processed.
+	DUKAT_TARGET_AVX2 static int integrate_avx2(ParticleData& d, int begin, int end, float delta, float gravity, float dampening)
+	{
+		const auto vdelta = _mm256_set1_ps(delta);
+		const auto vgravity = _mm256_set1_ps(gravity * delta);
+		const auto vdampening = _mm256_set1_ps(dampening);
+		auto i = begin;
+		for (; i + ParticleData::block_size <= end; i += ParticleData::block_size)
+		{
+			const auto f = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(d.flags.data() + i)));
+			const auto linear = flag_mask(f, Particle::Linear);
+			const auto gravitational = flag_mask(f, Particle::Gravitational);
+			const auto dampened = flag_mask(f, Particle::Dampened);
+
+			_mm256_storeu_ps(&d.ttl[i], _mm256_sub_ps(_mm256_loadu_ps(&d.ttl[i]), vdelta));
+
+			auto px = _mm256_loadu_ps(&d.px[i]);
+			auto py = _mm256_loadu_ps(&d.py[i]);
+			auto dx = _mm256_loadu_ps(&d.dx[i]);
+			auto dy = _mm256_loadu_ps(&d.dy[i]);
+			px = _mm256_blendv_ps(px, _mm256_add_ps(px, _mm256_mul_ps(dx, vdelta)), linear);
+			py = _mm256_blendv_ps(py, _mm256_add_ps(py, _mm256_mul_ps(dy, vdelta)), linear);
+
+			// accelerate above reflection line, clamp to it otherwise
+			const auto ry = _mm256_loadu_ps(&d.ry[i]);
+			const auto above = _mm256_cmp_ps(py, ry, _CMP_LT_OQ);
+			dy = _mm256_blendv_ps(dy, _mm256_add_ps(dy, vgravity), _mm256_and_ps(gravitational, above));
+			py = _mm256_blendv_ps(py, ry, _mm256_andnot_ps(above, gravitational));
+
+			dx = _mm256_blendv_ps(dx, _mm256_mul_ps(dx, vdampening), dampened);
+			dy = _mm256_blendv_ps(dy, _mm256_mul_ps(dy, vdampening), dampened);
+
+			_mm256_storeu_ps(&d.px[i], px);
+			_mm256_storeu_ps(&d.py[i], py);
+			_mm256_storeu_ps(&d.dx[i], dx);
+			_mm256_storeu_ps(&d.dy[i], dy);
+
+			accumulate(&d.cr[i], &d.dr[i], vdelta);
+			accumulate(&d.cg[i], &d.dg[i], vdelta);
+			accumulate(&d.cb[i], &d.db[i], vdelta);
+			accumulate(&d.ca[i], &d.da[i], vdelta);
+			accumulate(&d.size[i], &d.dsize[i], vdelta);
+		}
+		return i;
+	}
+#endif
+
+	void ParticleData::integrate(int begin, int end, float delta, float gravity, float dampening)
+	{
+		auto i = begin;
+#ifdef DUKAT_AVX2
+		if (cpu_has_avx2())
+		{
+			i = integrate_avx2(*this, begin, end, delta, gravity, dampening);
+		}
+#endif
+		for (; i < end; i++)
+		{
+			integrate_scalar(*this, i, delta, gravity, dampening);
+		}
+	}
+}
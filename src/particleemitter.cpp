@@ -2,12 +2,10 @@
 #include <dukat/mathutil.h>
 #include <dukat/particleemitter.h>
 #include <dukat/particle.h>
-#include <dukat/particlemanager.h>
+#include <dukat/particledata.h>
 #include <dukat/rand.h>
 #include <dukat/renderlayer2.h>
 
-#include <dukat/log.h>
-
 namespace dukat
 {
 	const ParticleEmitter::Recipe ParticleEmitter::Recipe::FlameRecipe{
@@ -101,443 +99,463 @@ namespace dukat
 		Color{ 0.f, 0.f, 0.f, -0.005f }
 	};
 
-	// LINEAR
-	// - particles are created with unique direction in +/- dp range
-	void linear_update(ParticleManager& pm, ParticleEmitter& em, float delta)
-	{
-        em.accumulator += em.recipe.rate * delta;
-        if (em.accumulator < 1.0f || em.target_layer == nullptr)
-            return;
-
-		const auto offset_count = em.offsets.size();
-        while (em.accumulator >= 1.0f)
-        {
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				return;
-			p->flags = em.recipe.flags;
-			p->ry = em.pos.y + em.mirror_offset;
-			
-			if (offset_count == 0)
-				p->pos = em.pos;
-			else
-				p->pos = em.pos + em.offsets[random(0, offset_count)];
-
-			p->dp = random(em.recipe.min_dp, em.recipe.max_dp);
-            p->size = random(em.recipe.min_size, em.recipe.max_size);
-			p->color = em.recipe.colors[random(0, em.recipe.colors.size())];
-			p->dc = em.recipe.dc;
-            p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
-			
-			em.target_layer->add(p);
-
-			em.accumulator -= 1.0f;
-        }
-	}
-
-	// UNIFORM
-	// - particles are generated within a box based on offset[0] - offset[1]
-	// - particles are created with fixed direction within +/- dp range
-	void uniform_update(ParticleManager& pm, ParticleEmitter& em, float delta)
+	namespace
 	{
-		em.accumulator += em.recipe.rate * delta;
-		if (em.accumulator < 1.0f || em.target_layer == nullptr)
-			return;
+		typedef ParticleEmitter::Recipe::Type Type;
 
-		if (em.offsets.size() < 2)
-			return; 
-
-		const auto& min_offset = em.offsets[0];
-		const auto& max_offset = em.offsets[1];
-		while (em.accumulator >= 1.0f)
+		// Per-thread scratch space for batches of random draws.
+		struct EmitScratch
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				return;
-			p->flags = em.recipe.flags;
-			p->ry = em.pos.y + em.mirror_offset;
-			p->pos = em.pos + random(min_offset, max_offset);
-
-			p->dp = random(em.recipe.min_dp, em.recipe.max_dp);
-			p->size = random(em.recipe.min_size, em.recipe.max_size);
-			p->color = em.recipe.colors[random(0, em.recipe.colors.size())];
-			p->dc = em.recipe.dc;
-			p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
+			std::vector<float> a, b;
+		};
 
-			em.target_layer->add(p);
-
-			em.accumulator -= 1.0f;
+		// Draws n random numbers in [min..max) into buf.
+		inline const float* draw(Random& rng, std::vector<float>& buf, int n, float min, float max)
+		{
+			if (static_cast<int>(buf.size()) < n)
+				buf.resize(n);
+			rng.fill(buf.data(), n, min, max);
+			return buf.data();
 		}
-	}
-
-	// LAYERED
-	// - particles are generated within a box based on offset[0] - offset[1]
-	// - background particles are created with min_dp and colors 2 and 3
-	// - foreground particles are created with max_dp and colors 0 and 1
-	void layered_update(ParticleManager& pm, ParticleEmitter& em, float delta)
-	{
-		em.accumulator += em.recipe.rate * delta;
-		if (em.accumulator < 1.0f || em.target_layer == nullptr)
-			return;
 
-		if (em.offsets.size() < 2)
-			return;
-
-		const auto& min_offset = em.offsets[0];
-		const auto& max_offset = em.offsets[1];
-		while (em.accumulator >= 1.0f)
+		// Converts a draw in [0..count) to an index; guards against rounding up to count.
+		inline int to_index(float v, int count)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				return;
-			p->flags = em.recipe.flags;
-			p->ry = em.pos.y + em.mirror_offset;
-			p->pos = em.pos + random(min_offset, max_offset);
-
-			const auto z = random(0, em.recipe.colors.size());
-			p->dp = (z >= 2) ? em.recipe.min_dp : em.recipe.max_dp;
-
-			p->size = static_cast<float>(random(static_cast<int>(em.recipe.min_size), static_cast<int>(em.recipe.max_size)));
-			
-			p->color = em.recipe.colors[z];
-			p->dc = em.recipe.dc;
-			p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
-
-			em.target_layer->add(p);
+			return std::min(static_cast<int>(v), count - 1);
+		}
 
-			em.accumulator -= 1.0f;
+		inline void set_color(ParticleData& out, int i, const Color& c)
+		{
+			out.cr[i] = c.r; out.cg[i] = c.g; out.cb[i] = c.b; out.ca[i] = c.a;
 		}
-	}
 
-	// RADIAL
-	// - continuous particles generated at a radius around emitter
-	// - particle direction determined by random angle
-	// - particle position based min_dp.x along direction vector
-	// - particle velocity within min_dp.y and max_dp.y along direction
-	void radial_update(ParticleManager& pm, ParticleEmitter& em, float delta)
-	{
-		em.accumulator += em.recipe.rate * delta;
-		if (em.accumulator < 1.0f || em.target_layer == nullptr)
-			return;
+		// Adds particles to the accumulator and returns the number of whole
+		// particles to emit this frame.
+		inline int take_accumulated(ParticleEmitter& em, float delta)
+		{
+			em.accumulator += em.recipe.rate * delta;
+			if (em.accumulator < 1.0f || em.target_layer == nullptr)
+				return 0;
+			const auto n = static_cast<int>(em.accumulator);
+			em.accumulator -= static_cast<float>(n);
+			return n;
+		}
 
-		static const Vector2 base_vector{ 0.0f, -1.0f };
-		const auto offset_count = em.offsets.size();
-		while (em.accumulator >= 1.0f)
+		// Sets attributes every recipe shares.
+		void emit_common(const ParticleEmitter& em, ParticleData& out, int begin, int end)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				return;
-			p->flags = em.recipe.flags;
-			p->ry = em.pos.y + em.mirror_offset;
+			const auto ry = em.pos.y + em.mirror_offset;
+			const auto& dc = em.recipe.dc;
+			for (auto i = begin; i < end; i++)
+			{
+				out.flags[i] = em.recipe.flags;
+				out.ry[i] = ry;
+				out.dr[i] = dc.r; out.dg[i] = dc.g; out.db[i] = dc.b; out.da[i] = dc.a;
+				out.dsize[i] = 0.0f;
+			}
+		}
 
-			const auto angle = random(0.0f, two_pi);
-			const auto offset = base_vector.rotate(angle);
+		// Places particles at emitter position plus origin, and at a random offset
+		// if the emitter has any.
+		void emit_positions(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s,
+			const Vector2& origin = Vector2{ 0.0f, 0.0f })
+		{
+			const auto base = em.pos + origin;
+			const auto offset_count = static_cast<int>(em.offsets.size());
 			if (offset_count == 0)
-				p->pos = em.pos;
-			else
-				p->pos = em.pos + em.offsets[random(0, offset_count)];
-
-			if (em.recipe.min_dp.x != 0.0f)
-				p->pos += offset * em.recipe.min_dp.x;
-
-			p->dp = offset * random(em.recipe.min_dp.y, em.recipe.max_dp.y);
-			p->size = random(em.recipe.min_size, em.recipe.max_size);
-			p->color = em.recipe.colors[random(0, em.recipe.colors.size())];
-			p->dc = em.recipe.dc;
-			p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
+			{
+				std::fill(out.px.begin() + begin, out.px.begin() + end, base.x);
+				std::fill(out.py.begin() + begin, out.py.begin() + end, base.y);
+				return;
+			}
+			const auto idx = draw(em.rng, s.a, end - begin, 0.0f, static_cast<float>(offset_count));
+			for (auto i = begin; i < end; i++)
+			{
+				const auto& o = em.offsets[to_index(idx[i - begin], offset_count)];
+				out.px[i] = base.x + o.x;
+				out.py[i] = base.y + o.y;
+			}
+		}
 
-			em.target_layer->add(p);
+		// Places particles within the box spanned by offset[0] and offset[1].
+		void emit_box(ParticleEmitter& em, ParticleData& out, int begin, int end)
+		{
+			const auto n = end - begin;
+			const auto& min_offset = em.offsets[0];
+			const auto& max_offset = em.offsets[1];
+			em.rng.fill(&out.px[begin], n, em.pos.x + min_offset.x, em.pos.x + max_offset.x);
+			em.rng.fill(&out.py[begin], n, em.pos.y + min_offset.y, em.pos.y + max_offset.y);
+		}
 
-			em.accumulator -= 1.0f;
+		// Assigns a random color out of first..first+count-1.
+		void emit_colors(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s, int first, int count)
+		{
+			const auto idx = draw(em.rng, s.a, end - begin, 0.0f, static_cast<float>(count));
+			for (auto i = begin; i < end; i++)
+			{
+				set_color(out, i, em.recipe.colors[first + to_index(idx[i - begin], count)]);
+			}
 		}
-	}
 
-	// FLAME
-	// - particles are emitted with upward direction
-	// - flame particles have variable ttl, so that we end up with holes
-	// - if using multiple emitters, each emitter should have a current 
-	//   direction that swings by random amount; that will cause subsequent 
-	//   particles to have similar direction
-	void flame_update(ParticleManager& pm, ParticleEmitter& em, float delta)
-    {
-		const auto max_change = 0.25f;
-        em.value += random(-max_change, max_change);
-		em.accumulator += em.recipe.rate * delta;
-
-        if (em.accumulator < 1.0f || em.target_layer == nullptr)
-            return;
-
-		const auto range = em.recipe.min_dp.x;
-		const auto offset_count = em.offsets.size();
-        while (em.accumulator >= 1.0f)
-        {
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
-
-			p->flags = em.recipe.flags;
-			p->ry = em.pos.y + em.mirror_offset;
-			
-			auto offset = Vector2{ 0.f, range }.rotate(em.value);
-			offset.y = 0.f;
-
-			p->dp.x = em.recipe.max_dp.x * offset.x;
-			p->dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
-
-			if (offset_count > 0)
-				offset += em.offsets[random(0, offset_count)];
-			p->pos = em.pos + offset;
-
-            auto n_size = random(0.0f, 1.0f);
-            p->size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
-
-            // determine initial color of particle based on distance from center 
-			// TODO: revise this - idea is that for offsets that are further from pos.x, go into red
-            auto dist = std::abs(offset.x) / (4.0f * range);
-			p->color = em.recipe.colors[0] - em.recipe.colors[1] * dist;
-			p->dc = em.recipe.dc;
-			p->dc.a -= n_size;
-
-            // The smaller the particle, the longer it will live
-            p->ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
-
-			em.target_layer->add(p);
-
-			em.accumulator -= 1.0f;
-        }
-    }
-
-	// SMOKE
-	// - upward direction of particles
-	// - position of emitter ocilates on the x axis
-	// - single color that fades out over time
-	void smoke_update(ParticleManager& pm, ParticleEmitter& em, float delta)
-    {
-		const auto max_change = 0.15f;
-		em.value += random(-max_change, max_change);
-		em.accumulator += em.recipe.rate * delta;
-
-        if (em.accumulator < 1.0f || em.target_layer == nullptr)
-            return;
-
-		const auto offset_count = em.offsets.size();
-		while (em.accumulator >= 1.0f)
-        {
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
-
-			p->flags = em.recipe.flags;
-			p->ry = em.pos.y + em.mirror_offset;
-			
-			auto offset = Vector2{ 0.f, em.recipe.min_dp.x }.rotate(em.value);
-			offset.y = 0.f;
-			if (offset_count == 0)
-				p->pos = em.pos + offset;
-			else
-				p->pos = em.pos + em.offsets[rand() % offset_count] + offset;
-			
-            p->dp.x = offset.x * em.recipe.max_dp.x;
-            p->dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
-
-			const auto size = random(0.0f, 1.0f);
-            p->size = em.recipe.min_size + size * (em.recipe.max_size - em.recipe.min_size);
-            p->color = em.recipe.colors[0];
-			p->dc = em.recipe.dc * (0.25f + size);
-			p->ry = em.pos.y + em.mirror_offset;
-
-            // The smaller the particle, the longer it will live
-            p->ttl = em.recipe.min_ttl + (1.f - size) * (em.recipe.max_ttl - em.recipe.min_ttl);
-
-			em.target_layer->add(p);
-
-			em.accumulator -= 1.0f;
-        }
-    }
-
-	// FOUNTAIN
-	// - initial dx, dy
-	// - gravity pulls at dy->reduce and ultimately turn around
-	void fountain_update(ParticleManager& pm, ParticleEmitter& em, float delta)
-    {
-		const auto max_change = 0.2f;
-		em.value += random(-max_change, max_change);
-		em.accumulator += em.recipe.rate * delta;
-
-        if (em.accumulator < 1.0f || em.target_layer == nullptr)
-            return;
-
-		const auto offset_count = em.offsets.size();
-		const auto max_v = em.recipe.max_dp.y * (1.0f + 0.25f * fast_cos(em.age));
-        while (em.accumulator >= 1.0f)
-        {
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
-
-			p->flags = em.recipe.flags;
-			p->ry = em.pos.y + em.mirror_offset;
-
-			auto offset = Vector2{ 0.f, em.recipe.max_dp.x }.rotate(em.value);
-			offset.y = 0.f;
-			if (offset_count == 0)
-				p->pos = em.pos + offset;
-			else
-				p->pos = em.pos + em.offsets[random(0, offset_count)] + offset;
-
-			p->dp.x = offset.x;
-            p->dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
-            
-            auto size = random(1, em.recipe.colors.size());
-            p->size = random(em.recipe.min_size, em.recipe.max_size);
-            p->color = em.recipe.colors[size - 1];
-			p->dc = em.recipe.dc;
-            p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
-
-			em.target_layer->add(p);
-
-			em.accumulator -= 1.0f;
-        }
-    }
-
-	// EXPLOSION
-	// - burst of particles
-	// - particle direction determined by random angle
-	// - particle position based min_dp.x along direction vector
-	// - particle velocity within min_dp.y and max_dp.y along direction
-	void explosion_update(ParticleManager& pm, ParticleEmitter& em, float delta)
-    {
-		if (em.target_layer == nullptr)
-            return;
-
-		// value used as repeat interval
-		if (em.age > 0.0f)
-		{
-			if (em.value <= 0.0f)
-				return; // no repeat
-			else if (em.age < em.value)
-				return;
-			else
-				em.age = 0.0f;
+		// Sets size and ttl from one draw per particle; smaller particles live
+		// longer. Returns the draws.
+		const float* emit_size_ttl(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
+		{
+			const auto& r = em.recipe;
+			const auto n_size = draw(em.rng, s.b, end - begin, 0.0f, 1.0f);
+			for (auto i = begin; i < end; i++)
+			{
+				const auto n = n_size[i - begin];
+				out.size[i] = r.min_size + n * (r.max_size - r.min_size);
+				out.ttl[i] = r.min_ttl + (1.0f - n) * (r.max_ttl - r.min_ttl);
+			}
+			return n_size;
 		}
 
-		static const Vector2 base_vector{ 0.0f, -1.0f };
-		const auto offset_count = em.offsets.size();
-		for (int i = 0; i < static_cast<int>(em.recipe.rate); i++)
+		// Sends particles in a random direction, starting min_dp.x along it.
+		void emit_radial(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
+			const auto n = end - begin;
+			const auto& r = em.recipe;
+			emit_positions(em, out, begin, end, s);
+			const auto angle = draw(em.rng, s.a, n, 0.0f, two_pi);
+			em.rng.fill(&out.dx[begin], n, r.min_dp.y, r.max_dp.y);
+			for (auto i = begin; i < end; i++)
+			{
+				// base vector (0,-1) rotated by angle
+				const auto a = angle[i - begin];
+				const auto ox = std::sin(a);
+				const auto oy = -std::cos(a);
+				out.px[i] += ox * r.min_dp.x;
+				out.py[i] += oy * r.min_dp.x;
+				const auto speed = out.dx[i];
+				out.dx[i] = ox * speed;
+				out.dy[i] = oy * speed;
+			}
+		}
 
-			p->flags = em.recipe.flags;
-			p->ry = em.pos.y + em.mirror_offset;
+		// Returns number of particles to emit this frame; advances per-frame state.
+		template<Type T>
+		int emit_count(ParticleEmitter& em, float delta)
+		{
+			return take_accumulated(em, delta);
+		}
 
-			const auto angle = random(0.0f, two_pi);
-			const auto offset = base_vector.rotate(angle);
-			if (offset_count == 0)
-				p->pos = em.pos;
-			else
-				p->pos = em.pos + em.offsets[random(0, offset_count)];
+		// Fills in particles [begin, end) after emit_common.
+		template<Type T>
+		void emit(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s);
 
-			if (em.recipe.min_dp.x != 0.0f)
-				p->pos += offset * em.recipe.min_dp.x;
+		// LINEAR
+		// - particles are created with unique direction in +/- dp range
+		template<>
+		void emit<Type::Linear>(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
+		{
+			const auto n = end - begin;
+			const auto& r = em.recipe;
+			emit_positions(em, out, begin, end, s);
+			em.rng.fill(&out.dx[begin], n, r.min_dp.x, r.max_dp.x);
+			em.rng.fill(&out.dy[begin], n, r.min_dp.y, r.max_dp.y);
+			em.rng.fill(&out.size[begin], n, r.min_size, r.max_size);
+			emit_colors(em, out, begin, end, s, 0, static_cast<int>(r.colors.size()));
+			em.rng.fill(&out.ttl[begin], n, r.min_ttl, r.max_ttl);
+		}
 
-			p->dp = offset * random(em.recipe.min_dp.y, em.recipe.max_dp.y);
+		// UNIFORM
+		// - particles are generated within a box based on offset[0] - offset[1]
+		// - particles are created with fixed direction within +/- dp range
+		template<>
+		int emit_count<Type::Uniform>(ParticleEmitter& em, float delta)
+		{
+			if (em.offsets.size() < 2)
+			{
+				em.accumulator += em.recipe.rate * delta;
+				return 0;
+			}
+			return take_accumulated(em, delta);
+		}
 
-			const auto n_size = random(0.0f, 1.0f);
-			p->size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
+		template<>
+		void emit<Type::Uniform>(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
+		{
+			const auto n = end - begin;
+			const auto& r = em.recipe;
+			emit_box(em, out, begin, end);
+			em.rng.fill(&out.dx[begin], n, r.min_dp.x, r.max_dp.x);
+			em.rng.fill(&out.dy[begin], n, r.min_dp.y, r.max_dp.y);
+			em.rng.fill(&out.size[begin], n, r.min_size, r.max_size);
+			emit_colors(em, out, begin, end, s, 0, static_cast<int>(r.colors.size()));
+			em.rng.fill(&out.ttl[begin], n, r.min_ttl, r.max_ttl);
+		}
 
-			p->color = em.recipe.colors[0];
-			p->dc = em.recipe.dc;
-			p->dc.a -= n_size;
+		// LAYERED
+		// - particles are generated within a box based on offset[0] - offset[1]
+		// - background particles are created with min_dp and colors 2 and 3
+		// - foreground particles are created with max_dp and colors 0 and 1
+		template<>
+		int emit_count<Type::Layered>(ParticleEmitter& em, float delta)
+		{
+			return emit_count<Type::Uniform>(em, delta);
+		}
 
-			// The smaller the particle, the longer it will live
-			p->ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
+		template<>
+		void emit<Type::Layered>(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
+		{
+			const auto n = end - begin;
+			const auto& r = em.recipe;
+			const auto color_count = static_cast<int>(r.colors.size());
+			emit_box(em, out, begin, end);
+			const auto z = draw(em.rng, s.a, n, 0.0f, static_cast<float>(color_count));
+			// whole sizes within [min_size, max_size)
+			const auto min_size = static_cast<int>(r.min_size);
+			const auto max_size = std::max(min_size + 1, static_cast<int>(r.max_size));
+			const auto sizes = draw(em.rng, s.b, n, static_cast<float>(min_size), static_cast<float>(max_size));
+			em.rng.fill(&out.ttl[begin], n, r.min_ttl, r.max_ttl);
+			for (auto i = begin; i < end; i++)
+			{
+				const auto zi = to_index(z[i - begin], color_count);
+				const auto& dp = (zi >= 2) ? r.min_dp : r.max_dp;
+				out.dx[i] = dp.x;
+				out.dy[i] = dp.y;
+				out.size[i] = std::floor(sizes[i - begin]);
+				set_color(out, i, r.colors[zi]);
+			}
+		}
 
-			em.target_layer->add(p);
+		// RADIAL
+		// - continuous particles generated at a radius around emitter
+		// - particle direction determined by random angle
+		// - particle position based min_dp.x along direction vector
+		// - particle velocity within min_dp.y and max_dp.y along direction
+		template<>
+		void emit<Type::Radial>(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
+		{
+			const auto n = end - begin;
+			const auto& r = em.recipe;
+			emit_radial(em, out, begin, end, s);
+			em.rng.fill(&out.size[begin], n, r.min_size, r.max_size);
+			emit_colors(em, out, begin, end, s, 0, static_cast<int>(r.colors.size()));
+			em.rng.fill(&out.ttl[begin], n, r.min_ttl, r.max_ttl);
 		}
-    }
 
-	// SPIRAL
-	// - spiralling emitters
-	// - angle changes with time, particles are emitted with initial direction based on angle
-	void spiral_update(ParticleManager& pm, ParticleEmitter& em, float delta)
-	{
-		em.value += em.recipe.min_dp.y * delta; 
-		em.accumulator += em.recipe.rate * delta;
+		// FLAME
+		// - particles are emitted with upward direction
+		// - flame particles have variable ttl, so that we end up with holes
+		// - if using multiple emitters, each emitter should have a current 
+		//   direction that swings by random amount; that will cause subsequent 
+		//   particles to have similar direction
+		template<>
+		int emit_count<Type::Flame>(ParticleEmitter& em, float delta)
+		{
+			const auto max_change = 0.25f;
+			em.value += em.rng.range(-max_change, max_change);
+			return take_accumulated(em, delta);
+		}
 
-		if (em.accumulator < 1.0f || em.target_layer == nullptr)
-			return;
+		template<>
+		void emit<Type::Flame>(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
+		{
+			const auto n = end - begin;
+			const auto& r = em.recipe;
+			const auto range = r.min_dp.x;
+			// horizontal part of (0,range) rotated by current direction
+			const auto ox = -range * std::sin(em.value);
+			emit_positions(em, out, begin, end, s, Vector2{ ox, 0.0f });
+			std::fill(out.dx.begin() + begin, out.dx.begin() + end, r.max_dp.x * ox);
+			em.rng.fill(&out.dy[begin], n, -r.max_dp.y, -r.min_dp.y);
+			const auto n_size = emit_size_ttl(em, out, begin, end, s);
+			for (auto i = begin; i < end; i++)
+			{
+				// determine initial color of particle based on distance from center 
+				// TODO: revise this - idea is that for offsets that are further from pos.x, go into red
+				const auto dist = std::abs(out.px[i] - em.pos.x) / (4.0f * range);
+				set_color(out, i, r.colors[0] - r.colors[1] * dist);
+				out.da[i] -= n_size[i - begin];
+			}
+		}
 
-		auto offset = Vector2{ 0.f, 1.f }.rotate(em.value);
+		// SMOKE
+		// - upward direction of particles
+		// - position of emitter ocilates on the x axis
+		// - single color that fades out over time
+		template<>
+		int emit_count<Type::Smoke>(ParticleEmitter& em, float delta)
+		{
+			const auto max_change = 0.15f;
+			em.value += em.rng.range(-max_change, max_change);
+			return take_accumulated(em, delta);
+		}
 
-		const auto offset_count = em.offsets.size();
-		while (em.accumulator >= 1.0f)
+		template<>
+		void emit<Type::Smoke>(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
+			const auto n = end - begin;
+			const auto& r = em.recipe;
+			const auto ox = -r.min_dp.x * std::sin(em.value);
+			emit_positions(em, out, begin, end, s, Vector2{ ox, 0.0f });
+			std::fill(out.dx.begin() + begin, out.dx.begin() + end, ox * r.max_dp.x);
+			em.rng.fill(&out.dy[begin], n, -r.max_dp.y, -r.min_dp.y);
+			const auto n_size = emit_size_ttl(em, out, begin, end, s);
+			for (auto i = begin; i < end; i++)
+			{
+				set_color(out, i, r.colors[0]);
+				const auto dc = r.dc * (0.25f + n_size[i - begin]);
+				out.dr[i] = dc.r; out.dg[i] = dc.g; out.db[i] = dc.b; out.da[i] = dc.a;
+			}
+		}
 
-			p->flags = em.recipe.flags;
-			p->ry = em.pos.y + em.mirror_offset;
-			p->dp.x = em.recipe.max_dp.x * offset.x;
-			p->dp.y = em.recipe.max_dp.y * offset.y;
+		// FOUNTAIN
+		// - initial dx, dy
+		// - gravity pulls at dy->reduce and ultimately turn around
+		template<>
+		int emit_count<Type::Fountain>(ParticleEmitter& em, float delta)
+		{
+			const auto max_change = 0.2f;
+			em.value += em.rng.range(-max_change, max_change);
+			return take_accumulated(em, delta);
+		}
 
-			p->pos = em.pos + offset * em.recipe.min_dp.x;
-			if (offset_count > 0)
-				p->pos += em.offsets[random(0, offset_count)];
+		template<>
+		void emit<Type::Fountain>(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
+		{
+			const auto n = end - begin;
+			const auto& r = em.recipe;
+			const auto ox = -r.max_dp.x * std::sin(em.value);
+			emit_positions(em, out, begin, end, s, Vector2{ ox, 0.0f });
+			std::fill(out.dx.begin() + begin, out.dx.begin() + end, ox);
+			em.rng.fill(&out.dy[begin], n, -r.max_dp.y, -r.min_dp.y);
+			em.rng.fill(&out.size[begin], n, r.min_size, r.max_size);
+			// last color is never picked
+			emit_colors(em, out, begin, end, s, 0, std::max(1, static_cast<int>(r.colors.size()) - 1));
+			em.rng.fill(&out.ttl[begin], n, r.min_ttl, r.max_ttl);
+		}
 
-			const auto n_size = random(0.0f, 1.0f);
-			p->size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
+		// EXPLOSION
+		// - burst of particles
+		// - particle direction determined by random angle
+		// - particle position based min_dp.x along direction vector
+		// - particle velocity within min_dp.y and max_dp.y along direction
+		template<>
+		int emit_count<Type::Explosion>(ParticleEmitter& em, float)
+		{
+			if (em.target_layer == nullptr)
+				return 0;
+
+			// value used as repeat interval
+			if (em.age > 0.0f)
+			{
+				if (em.value <= 0.0f)
+					return 0; // no repeat
+				else if (em.age < em.value)
+					return 0;
+				else
+					em.age = 0.0f;
+			}
+			return static_cast<int>(em.recipe.rate);
+		}
 
-			p->color = em.recipe.colors[0];
-			p->dc = em.recipe.dc;
-			p->dc.a -= n_size;
+		template<>
+		void emit<Type::Explosion>(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
+		{
+			emit_radial(em, out, begin, end, s);
+			const auto n_size = emit_size_ttl(em, out, begin, end, s);
+			for (auto i = begin; i < end; i++)
+			{
+				set_color(out, i, em.recipe.colors[0]);
+				out.da[i] -= n_size[i - begin];
+			}
+		}
 
-			// The smaller the particle, the longer it will live
-			p->ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
+		// SPIRAL
+		// - spiralling emitters
+		// - angle changes with time, particles are emitted with initial direction based on angle
+		template<>
+		int emit_count<Type::Spiral>(ParticleEmitter& em, float delta)
+		{
+			em.value += em.recipe.min_dp.y * delta;
+			return take_accumulated(em, delta);
+		}
 
-			em.target_layer->add(p);
+		template<>
+		void emit<Type::Spiral>(ParticleEmitter& em, ParticleData& out, int begin, int end, EmitScratch& s)
+		{
+			const auto& r = em.recipe;
+			// (0,1) rotated by current angle
+			const Vector2 offset{ -std::sin(em.value), std::cos(em.value) };
+			emit_positions(em, out, begin, end, s, offset * r.min_dp.x);
+			std::fill(out.dx.begin() + begin, out.dx.begin() + end, r.max_dp.x * offset.x);
+			std::fill(out.dy.begin() + begin, out.dy.begin() + end, r.max_dp.y * offset.y);
+			const auto n_size = emit_size_ttl(em, out, begin, end, s);
+			for (auto i = begin; i < end; i++)
+			{
+				set_color(out, i, r.colors[0]);
+				out.da[i] -= n_size[i - begin];
+			}
+		}
 
-			em.accumulator -= 1.0f;
+		// Updates emitters of recipe type T. The recipe is known at compile time,
+		// so the per-type steps are inlined into one loop.
+		template<Type T>
+		void update_batch(ParticleEmitter* const* emitters, int count, ParticleData& out, float delta)
+		{
+			static thread_local EmitScratch scratch;
+			for (auto i = 0; i < count; i++)
+			{
+				auto& em = *emitters[i];
+				if (!em.active)
+					continue;
+				const auto n = emit_count<T>(em, delta);
+				em.age += delta;
+				if (n <= 0)
+					continue;
+
+				const auto range = out.spawn(em.target_layer->get_particle_layer(), n);
+				emit_common(em, out, range.begin, range.end);
+				emit<T>(em, out, range.begin, range.end, scratch);
+			}
 		}
 	}
 
-	void init_emitter(ParticleEmitter& emitter, const ParticleEmitter::Recipe& recipe)
+	void update_emitter_group(ParticleEmitter::Recipe::Type type, ParticleEmitter* const* emitters, int count,
+		ParticleData& out, float delta)
 	{
-		emitter.recipe = recipe;
-		switch (recipe.type)
+		switch (type)
 		{
-		case ParticleEmitter::Recipe::Linear:
-			emitter.update = std::bind(linear_update, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		case Type::Linear:
+			update_batch<Type::Linear>(emitters, count, out, delta);
 			break;
-		case ParticleEmitter::Recipe::Uniform:
-			emitter.update = std::bind(uniform_update, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		case Type::Uniform:
+			update_batch<Type::Uniform>(emitters, count, out, delta);
 			break;
-		case ParticleEmitter::Recipe::Flame:
-			emitter.update = std::bind(flame_update, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		case Type::Flame:
+			update_batch<Type::Flame>(emitters, count, out, delta);
 			break;
-		case ParticleEmitter::Recipe::Smoke:
-			emitter.update = std::bind(smoke_update, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		case Type::Smoke:
+			update_batch<Type::Smoke>(emitters, count, out, delta);
 			break;
-		case ParticleEmitter::Recipe::Fountain:
-			emitter.update = std::bind(fountain_update, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		case Type::Fountain:
+			update_batch<Type::Fountain>(emitters, count, out, delta);
 			break;
-		case ParticleEmitter::Recipe::Explosion:
-			emitter.update = std::bind(explosion_update, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		case Type::Explosion:
+			update_batch<Type::Explosion>(emitters, count, out, delta);
 			break;
-		case ParticleEmitter::Recipe::Spiral:
-			emitter.update = std::bind(spiral_update, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		case Type::Spiral:
+			update_batch<Type::Spiral>(emitters, count, out, delta);
 			break;
-		case ParticleEmitter::Recipe::Radial:
-			emitter.update = std::bind(radial_update, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		case Type::Radial:
+			update_batch<Type::Radial>(emitters, count, out, delta);
 			break;
-		case ParticleEmitter::Recipe::Layered:
-			emitter.update = std::bind(layered_update, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		case Type::Layered:
+			update_batch<Type::Layered>(emitters, count, out, delta);
 			break;
 		default:
-			emitter.update = nullptr;
+			// custom emitters are updated by the particle manager
 			break;
-		}		
+		}
+	}
+
+	void init_emitter(ParticleEmitter& emitter, const ParticleEmitter::Recipe& recipe)
+	{
+		emitter.recipe = recipe;
+		emitter.update = nullptr;
 	}
-}
\ No newline at end of file
+}
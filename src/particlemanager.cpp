@@ -1,78 +1,168 @@
 #include "stdafx.h"
 #include <dukat/particlemanager.h>
 #include <dukat/particleemitter.h>
-#include <dukat/bit.h>
+#include <dukat/particlecollider.h>
 #include <dukat/log.h>
+#include <dukat/profiler.h>
+#include <dukat/renderlayer2.h>
+#include <dukat/threadpool.h>
 
 namespace dukat
 {
 	void ParticleManager::clear(void)
 	{
-		for (auto& p : particles.data)
-			p.ttl = -1.0f;
+		particles.clear();
+		particles.reset_overflow();
 		emitters.clear();
+		groups_dirty = true;
 	}
 
 	void ParticleManager::update(float delta)
 	{
-		emitters.free_index = 0;
-		for (auto& e : emitters.data)
+		PROFILE_SCOPE("particles.update");
 		{
-			if (!e.alive)
-				continue;
-			if (e.active)
+			PROFILE_SCOPE("particles.emitters");
+			update_emitters(delta);
+		}
+
+		// Particles are independent of each other, so integration can be split
+		// into any number of jobs.
+		particles.compact();
+		const auto g = gravity, d = dampening;
+		parallel_for(0, particles.get_count(), particles_per_job, [&](int begin, int end) {
+			PROFILE_SCOPE("particles.integrate");
+			particles.integrate(begin, end, delta, g, d);
+			if (collider != nullptr)
+				collider->collide(particles, begin, end);
+		});
+	}
+
+	void ParticleManager::build_emitter_jobs(void)
+	{
+		for (auto& group : emitter_groups)
+		{
+			group.clear();
+		}
+		emitters.for_each([&](ParticleEmitter& e) {
+			emitter_groups[e.recipe.type].push_back(&e);
+		});
+
+		emitter_jobs.clear();
+		// custom emitters are not updated in parallel
+		for (auto type = ParticleEmitter::Recipe::None + 1; type < ParticleEmitter::Recipe::num_types; type++)
+		{
+			const auto size = static_cast<int>(emitter_groups[type].size());
+			for (auto begin = 0; begin < size; begin += emitters_per_job)
 			{
-				e.update(*this, e, delta);
-				e.age += delta;
+				emitter_jobs.push_back(EmitterJob{ static_cast<ParticleEmitter::Recipe::Type>(type),
+					begin, std::min(size, begin + emitters_per_job) });
 			}
-			if (e.ttl > 0.0f && e.age >= e.ttl)
-				emitters.release(e);
 		}
+		groups_dirty = false;
+	}
+
+	void ParticleManager::update_custom_emitters(float delta)
+	{
+		custom_buffer.clear();
+		emitters.for_each([&](ParticleEmitter& e) {
+			if (e.recipe.type != ParticleEmitter::Recipe::None || !e.active || e.update == nullptr)
+				return;
+			if (e.target_layer != nullptr)
+				attach_layer(e.target_layer);
+			e.update(custom_buffer, e, delta);
+			e.age += delta;
+		});
+	}
 
-		// Reset free index
-		particles.free_index = 0;
-		for (auto& p : particles.data)
+	void ParticleManager::update_emitters(float delta)
+	{
+		// Custom update functions may touch game state or add and remove
+		// emitters, so they run before emitters are split into jobs.
+		update_custom_emitters(delta);
+		if (groups_dirty)
 		{
-			if (!check_flag(p.flags, Particle::Alive))
-				continue;
+			build_emitter_jobs();
+		}
 
-			if (p.ttl <= 0.0f)
+		const auto num_jobs = static_cast<int>(emitter_jobs.size());
+		if (static_cast<int>(spawn_buffers.size()) < num_jobs)
+		{
+			spawn_buffers.resize(num_jobs);
+		}
+
+		// Layer indices have to be known before emitters run in parallel
+		for (const auto& group : emitter_groups)
+		{
+			for (auto e : group)
 			{
-				particles.release(p);
+				if (e->target_layer != nullptr)
+					attach_layer(e->target_layer);
 			}
-			else
+		}
+
+		// Each job updates a fixed range of emitters of one type into its own buffer
+		parallel_for(0, num_jobs, 1, [&](int begin, int end) {
+			for (auto i = begin; i < end; i++)
 			{
-				p.ttl -= delta;
-				if (check_flag(p.flags, Particle::Linear))
-					p.pos += p.dp * delta;
-				// For gravitational particles, only apply effect as long as we're above
-				// reflection line
-				if (check_flag(p.flags, Particle::Gravitational)) 
-				{
-					if (p.pos.y < p.ry)
-						p.dp.y += gravity * delta;
-					else
-						p.pos.y = p.ry;
-				}
-				if (check_flag(p.flags, Particle::Dampened))
-					p.dp *= dampening;
-				p.color += p.dc * delta;
-				p.size += p.dsize * delta;
+				const auto& job = emitter_jobs[i];
+				auto& buffer = spawn_buffers[i];
+				buffer.clear();
+				update_emitter_group(job.type, emitter_groups[job.type].data() + job.begin, job.end - job.begin, buffer, delta);
 			}
+		});
+
+		// Merge in job order so particle order only depends on emitter order
+		particles.append(custom_buffer);
+		for (auto i = 0; i < num_jobs; i++)
+		{
+			particles.append(spawn_buffers[i]);
 		}
+
+		emitters.for_each([&](ParticleEmitter& e) {
+			if (e.ttl > 0.0f && e.age >= e.ttl)
+				remove_emitter(&e);
+		});
+	}
+
+	bool ParticleManager::add_particle(const Particle& p, RenderLayer2* layer)
+	{
+		return particles.add(p, attach_layer(layer)) >= 0;
+	}
+
+	int ParticleManager::attach_layer(RenderLayer2* layer)
+	{
+		if (layer->get_particle_layer() < 0)
+		{
+			if (layer_count > std::numeric_limits<uint16_t>::max())
+				throw std::runtime_error("Exceeded maximum number of particle layers.");
+			layer->set_particle_layer(layer_count++);
+		}
+		layer->set_particles(&particles);
+		return layer->get_particle_layer();
 	}
 
 	ParticleEmitter* ParticleManager::create_emitter(const ParticleEmitter::Recipe& recipe)
 	{
-		auto emitter = emitters.acquire();
-		if (emitter == nullptr)
+		if (emitter_budget > 0 && static_cast<int>(emitters.size()) >= emitter_budget)
 			return nullptr;
-		init_emitter(*emitter, recipe);
-		return emitter;
+
+		auto& em = *emitters.acquire();
+		em.active = true;
+		em.accumulator = em.age = em.mirror_offset = em.ttl = em.value = 0.0f;
+		em.offsets.clear();
+		em.target_layer = nullptr;
+		em.update = nullptr;
+		em.rng.seed(seed ^ (static_cast<uint64_t>(emitter_serial++) << 32));
+		groups_dirty = true;
+		init_emitter(em, recipe);
+		return &em;
 	}
 
 	void ParticleManager::remove_emitter(ParticleEmitter* emitter) 
 	{
+		if (!emitter->alive)
+			return;
 		emitters.release(emitter);
+		groups_dirty = true;
 	}
 }
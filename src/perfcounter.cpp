@@ -3,42 +3,157 @@
 
 namespace dukat
 {
+	static int next_counter_id(void)
+	{
+		static std::atomic<int> next_id(0);
+		return next_id++;
+	}
+
 	PerformanceCounter perfc;
 
-	PerformanceCounter::PerformanceCounter(void)
+	PerformanceCounter::PerformanceCounter(void) : id(next_counter_id()), samples(0l), frames(0),
+		last_reset(std::chrono::steady_clock::now()), window_size(600)
 	{
 		for (int i = 0; i < max_counters; i++)
 		{
 			counters[i] = 0l;
 			sums[i] = 0l;
-			averages[i] = 0l;
+			averages[i] = 0.0;
 		}
-		samples = 0l;
+		frame_times.set_window(window_size);
 	}
 
 	PerformanceCounter::~PerformanceCounter(void)
 	{
 	}
 
+	PerformanceCounter::Shard* PerformanceCounter::create_shard(void)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		// thread may have written to this counter before switching to another one
+		const auto thread = std::this_thread::get_id();
+		for (auto& shard : shards)
+		{
+			if (shard->thread == thread)
+				return shard.get();
+		}
+
+		auto shard = std::make_unique<Shard>();
+		shard->thread = thread;
+		for (int i = 0; i < max_counters; i++)
+		{
+			shard->values[i].store(0l);
+			shard->merged[i] = 0l;
+		}
+		shards.push_back(std::move(shard));
+		return shards.back().get();
+	}
+
+	void PerformanceCounter::merge(void)
+	{
+		for (auto& shard : shards)
+		{
+			for (int i = 0; i < max_counters; i++)
+			{
+				const auto value = shard->values[i].load(std::memory_order_relaxed);
+				counters[i] += value - shard->merged[i];
+				shard->merged[i] = value;
+			}
+		}
+	}
+
 	void PerformanceCounter::reset(void)
 	{
+		const auto now = std::chrono::steady_clock::now();
+		std::lock_guard<std::mutex> lock(mtx);
+		merge();
+		// first frame would include time spent on startup
+		if (frames > 0)
+		{
+			const auto frame_time = std::chrono::duration_cast<std::chrono::microseconds>(now - last_reset).count();
+			frame_times.record(static_cast<uint64_t>(frame_time));
+		}
+		last_reset = now;
 		for (int i = 0; i < max_counters; i++)
 		{
+			if (histograms[i] != nullptr)
+				histograms[i]->record(static_cast<uint64_t>(std::max(counters[i], 0l)));
 			sums[i] += counters[i];
 			counters[i] = 0l;
 		}
 		samples++;
+		frames++;
 	}
 
 	void PerformanceCounter::collect_stats(void)
 	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (samples == 0l)
+			return;
 		for (int i = 0; i < max_counters; i++)
 		{
-			sums[i] += counters[i];
-			averages[i] = (long)round((float)sums[i] / (float)samples);
-			counters[i] = 0l;
+			averages[i] = static_cast<double>(sums[i]) / static_cast<double>(samples);
 			sums[i] = 0l;
 		}
 		samples = 0l;
 	}
-}
\ No newline at end of file
+
+	void PerformanceCounter::set(int counter, long value)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		merge();
+		counters[counter] = value;
+	}
+
+	long PerformanceCounter::get(int counter)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		merge();
+		return counters[counter];
+	}
+
+	long PerformanceCounter::sum(int counter)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return sums[counter];
+	}
+
+	double PerformanceCounter::mean(int counter)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return averages[counter];
+	}
+
+	void PerformanceCounter::track(int counter)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (histograms[counter] == nullptr)
+			histograms[counter] = std::make_unique<SlidingHistogram>(window_size);
+	}
+
+	void PerformanceCounter::set_window(int frames)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		window_size = frames;
+		frame_times.set_window(window_size);
+		for (auto& h : histograms)
+		{
+			if (h != nullptr)
+				h->set_window(window_size);
+		}
+	}
+
+	PerformanceCounter::Snapshot PerformanceCounter::snapshot(void)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		Snapshot res;
+		res.frames = frames;
+		res.frame_time = frame_times.collect().summarize(1e-3);
+		for (int i = 0; i < max_counters; i++)
+		{
+			if (histograms[i] != nullptr)
+				res.counters.push_back(CounterStats{ i, averages[i], histograms[i]->collect().summarize() });
+		}
+		return res;
+	}
+}
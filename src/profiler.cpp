@@ -0,0 +1,216 @@
+#include "stdafx.h"
+#include <dukat/profiler.h>
+#include <dukat/log.h>
+
+#ifdef DUKAT_PROFILE
+namespace dukat
+{
+	Profiler::Profiler(void) : start(std::chrono::steady_clock::now()), frames(new std::atomic<uint64_t>[frame_buffer_size]()),
+		frame_count(0), epoch(0)
+	{
+	}
+
+	Profiler& Profiler::get(void)
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	uint64_t Profiler::now(void) const
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start).count());
+	}
+
+	Profiler::ThreadBuffer* Profiler::create_buffer(void)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		auto buffer = std::make_unique<ThreadBuffer>();
+		buffer->tid = static_cast<int>(buffers.size()) + 1;
+		buffer->thread_name = "thread " + std::to_string(buffer->tid);
+		buffer->slots.reset(new Slot[buffer_size]());
+		buffer->written.store(0);
+		buffers.push_back(std::move(buffer));
+		return buffers.back().get();
+	}
+
+	Profiler::ThreadBuffer* Profiler::thread_buffer(void)
+	{
+		static thread_local ThreadBuffer* buffer = nullptr;
+		if (buffer == nullptr)
+			buffer = create_buffer();
+		return buffer;
+	}
+
+	void Profiler::record(const char* name, uint64_t begin, uint64_t end)
+	{
+		auto buffer = thread_buffer();
+		const auto n = buffer->written.load(std::memory_order_relaxed);
+		auto& slot = buffer->slots[n % buffer_size];
+		slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.begin.store(begin, std::memory_order_relaxed);
+		slot.end.store(end, std::memory_order_relaxed);
+		slot.sequence.store(2 * n + 2, std::memory_order_release);
+		buffer->written.store(n + 1, std::memory_order_release);
+	}
+
+	void Profiler::frame(void)
+	{
+		const auto n = frame_count.load(std::memory_order_relaxed);
+		frames[n % frame_buffer_size].store(now(), std::memory_order_relaxed);
+		frame_count.store(n + 1, std::memory_order_release);
+	}
+
+	void Profiler::set_thread_name(const std::string& name)
+	{
+		auto buffer = thread_buffer();
+		std::lock_guard<std::mutex> lock(mtx);
+		buffer->thread_name = name;
+	}
+
+	void Profiler::copy_zones(const ThreadBuffer& buffer, std::vector<Zone>& out) const
+	{
+		const auto end = buffer.written.load(std::memory_order_acquire);
+		const auto begin = end > buffer_size ? end - buffer_size : 0;
+		for (auto i = begin; i < end; i++)
+		{
+			const auto& slot = buffer.slots[i % buffer_size];
+			// skip slots the owning thread is overwriting or has overwritten
+			const auto sequence = slot.sequence.load(std::memory_order_acquire);
+			if (sequence != 2 * i + 2)
+				continue;
+			const Zone z{ slot.name.load(std::memory_order_relaxed),
+				slot.begin.load(std::memory_order_relaxed), slot.end.load(std::memory_order_relaxed) };
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+				continue;
+			out.push_back(z);
+		}
+	}
+
+	std::vector<Profiler::Summary> Profiler::summarize(int last_frames)
+	{
+		auto from = epoch.load();
+		const auto count = frame_count.load(std::memory_order_acquire);
+		if (last_frames > 0 && count > static_cast<uint64_t>(last_frames)
+			&& static_cast<uint64_t>(last_frames) < frame_buffer_size)
+		{
+			from = std::max(from, frames[(count - last_frames - 1) % frame_buffer_size].load(std::memory_order_relaxed));
+		}
+
+		std::vector<Zone> zones;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			for (const auto& buffer : buffers)
+			{
+				copy_zones(*buffer, zones);
+			}
+		}
+
+		std::vector<Summary> res;
+		std::unordered_map<std::string, std::size_t> index;
+		for (const auto& z : zones)
+		{
+			if (z.begin < from)
+				continue;
+			auto it = index.find(z.name);
+			if (it == index.end())
+			{
+				it = index.emplace(z.name, res.size()).first;
+				res.push_back(Summary{ z.name, 0, 0.0, 0.0 });
+			}
+			auto& s = res[it->second];
+			const auto ms = static_cast<double>(z.end - z.begin) * 1e-6;
+			s.count++;
+			s.total_ms += ms;
+			s.max_ms = std::max(s.max_ms, ms);
+		}
+		std::sort(res.begin(), res.end(), [](const Summary& a, const Summary& b) { return a.total_ms > b.total_ms; });
+		return res;
+	}
+
+	static void write_string(std::ostream& os, const std::string& s)
+	{
+		os << '"';
+		for (auto c : s)
+		{
+			if (c == '"' || c == '\\')
+				os << '\\';
+			os << c;
+		}
+		os << '"';
+	}
+
+	void Profiler::write_trace(std::ostream& os)
+	{
+		const auto from = epoch.load();
+		// timestamps are written in microseconds with nanosecond resolution
+		const auto flags = os.flags();
+		const auto precision = os.precision();
+		os << std::fixed;
+		os.precision(3);
+		os << "{\"traceEvents\":[" << std::endl;
+		auto first = true;
+		auto separator = [&](void) {
+			if (!first)
+				os << "," << std::endl;
+			first = false;
+		};
+
+		std::lock_guard<std::mutex> lock(mtx);
+		std::vector<Zone> zones;
+		for (const auto& buffer : buffers)
+		{
+			separator();
+			os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+			write_string(os, buffer->thread_name);
+			os << "}}";
+
+			zones.clear();
+			copy_zones(*buffer, zones);
+			for (const auto& z : zones)
+			{
+				if (z.begin < from)
+					continue;
+				separator();
+				// timestamps are in microseconds
+				os << "{\"name\":";
+				write_string(os, z.name);
+				os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+					<< ",\"ts\":" << static_cast<double>(z.begin) * 1e-3
+					<< ",\"dur\":" << static_cast<double>(z.end - z.begin) * 1e-3 << "}";
+			}
+		}
+
+		const auto count = frame_count.load(std::memory_order_acquire);
+		for (auto i = count > frame_buffer_size ? count - frame_buffer_size : 0; i < count; i++)
+		{
+			const auto t = frames[i % frame_buffer_size].load(std::memory_order_relaxed);
+			if (t < from)
+				continue;
+			separator();
+			os << "{\"name\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":1,\"ts\":"
+				<< static_cast<double>(t) * 1e-3 << "}";
+		}
+		os << std::endl << "]}" << std::endl;
+		os.flags(flags);
+		os.precision(precision);
+	}
+
+	void Profiler::save_trace(const std::string& filename)
+	{
+		std::fstream os(filename, std::fstream::out);
+		if (!os)
+			throw std::runtime_error("Failed to open trace file: " + filename);
+		write_trace(os);
+		log->info("Saved profiler trace to {}", filename);
+	}
+
+	void Profiler::clear(void)
+	{
+		epoch.store(now());
+	}
+}
+#endif
@@ -249,7 +249,7 @@ namespace dukat
 		// compute interpolation fraction, checking for quaternions
 		// almost exactly the same
 		float k0, k1;
-		if (cos_omega < 0.9999f)
+		if (cos_omega > 0.9999f)
 		{
 			// very close - just use linear interpolation,
 			// whjich will protect against a divide by zero
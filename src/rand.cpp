@@ -0,0 +1,170 @@
+#include "stdafx.h"
+#include <dukat/rand.h>
+#include <dukat/simd.h>
+#include <atomic>
+
+namespace dukat
+{
+	// Seed used for the generator of the first thread.
+	static constexpr uint64_t default_seed = 0x2545f4914f6cdd1dull;
+
+	static inline uint64_t splitmix64(uint64_t& x)
+	{
+		auto z = (x += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	Random::Random(uint64_t seed, uint32_t stream)
+	{
+		this->seed(seed);
+		for (auto i = 0u; i < stream; i++)
+		{
+			jump();
+		}
+	}
+
+	void Random::seed(uint64_t seed)
+	{
+		const auto a = splitmix64(seed);
+		const auto b = splitmix64(seed);
+		s[0] = static_cast<uint32_t>(a);
+		s[1] = static_cast<uint32_t>(a >> 32);
+		s[2] = static_cast<uint32_t>(b);
+		s[3] = static_cast<uint32_t>(b >> 32);
+		// all-zero state is invalid
+		if ((s[0] | s[1] | s[2] | s[3]) == 0u)
+		{
+			s[0] = 1u;
+		}
+	}
+
+	void Random::jump(void)
+	{
+		static const uint32_t jump_table[] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+		uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+		for (auto j : jump_table)
+		{
+			for (auto b = 0; b < 32; b++)
+			{
+				if (j & (1u << b))
+				{
+					s0 ^= s[0];
+					s1 ^= s[1];
+					s2 ^= s[2];
+					s3 ^= s[3];
+				}
+				next();
+			}
+		}
+		s[0] = s0;
+		s[1] = s1;
+		s[2] = s2;
+		s[3] = s3;
+	}
+
+	// fill() runs 8 xoshiro128+ streams side by side, one per lane, seeded from
+	// the calling generator. The scalar and AVX2 versions perform the same
+	// operations so that both produce the same values.
+	static constexpr std::size_t num_lanes = 8;
+
+	static void seed_lanes(Random& rng, uint32_t state[4][num_lanes])
+	{
+		for (auto i = 0; i < 4; i++)
+		{
+			for (std::size_t lane = 0; lane < num_lanes; lane++)
+			{
+				state[i][lane] = rng.next();
+			}
+		}
+		// make sure no lane starts out with an all-zero state
+		for (std::size_t lane = 0; lane < num_lanes; lane++)
+		{
+			state[0][lane] |= 1u;
+		}
+	}
+
+	static std::size_t fill_lanes(Random& rng, float* out, std::size_t count, float min, float max)
+	{
+		uint32_t s[4][num_lanes];
+		seed_lanes(rng, s);
+
+		const auto scale = (max - min) * (1.0f / 16777216.0f);
+		std::size_t i = 0;
+		for (; i + num_lanes <= count; i += num_lanes)
+		{
+			for (std::size_t lane = 0; lane < num_lanes; lane++)
+			{
+				const auto res = s[0][lane] + s[3][lane];
+				const auto t = s[1][lane] << 9;
+				s[2][lane] ^= s[0][lane];
+				s[3][lane] ^= s[1][lane];
+				s[1][lane] ^= s[2][lane];
+				s[0][lane] ^= s[3][lane];
+				s[2][lane] ^= t;
+				s[3][lane] = (s[3][lane] << 11) | (s[3][lane] >> 21);
+
+				const auto f = static_cast<float>(res >> 8);
+				out[i + lane] = min + f * scale;
+			}
+		}
+		return i;
+	}
+
+#ifdef DUKAT_AVX2
+	DUKAT_TARGET_AVX2 static std::size_t fill_lanes8(Random& rng, float* out, std::size_t count, float min, float max)
+	{
+		alignas(32) uint32_t init[4][num_lanes];
+		seed_lanes(rng, init);
+		auto s0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(init[0]));
+		auto s1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(init[1]));
+		auto s2 = _mm256_load_si256(reinterpret_cast<const __m256i*>(init[2]));
+		auto s3 = _mm256_load_si256(reinterpret_cast<const __m256i*>(init[3]));
+
+		const auto scale = _mm256_set1_ps((max - min) * (1.0f / 16777216.0f));
+		const auto vmin = _mm256_set1_ps(min);
+		std::size_t i = 0;
+		for (; i + num_lanes <= count; i += num_lanes)
+		{
+			const auto res = _mm256_add_epi32(s0, s3);
+			const auto t = _mm256_slli_epi32(s1, 9);
+			s2 = _mm256_xor_si256(s2, s0);
+			s3 = _mm256_xor_si256(s3, s1);
+			s1 = _mm256_xor_si256(s1, s2);
+			s0 = _mm256_xor_si256(s0, s3);
+			s2 = _mm256_xor_si256(s2, t);
+			s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+
+			const auto f = _mm256_cvtepi32_ps(_mm256_srli_epi32(res, 8));
+			_mm256_storeu_ps(out + i, _mm256_add_ps(vmin, _mm256_mul_ps(f, scale)));
+		}
+		return i;
+	}
+#endif
+
+	void Random::fill(float* out, std::size_t count, float min, float max)
+	{
+		std::size_t i = 0;
+		if (count >= 64)
+		{
+#ifdef DUKAT_AVX2
+			if (cpu_has_avx2())
+				i = fill_lanes8(*this, out, count, min, max);
+			else
+#endif
+				i = fill_lanes(*this, out, count, min, max);
+		}
+		for (; i < count; i++)
+		{
+			out[i] = range(min, max);
+		}
+	}
+
+	uint64_t next_thread_seed(void)
+	{
+		static std::atomic<uint64_t> thread_index(0);
+		auto x = default_seed + thread_index.fetch_add(1);
+		return splitmix64(x);
+	}
+}
@@ -10,7 +10,7 @@
 namespace dukat
 {
 	Renderer::Renderer(Window* window, ShaderCache* shader_cache)
-		: window(window), shader_cache(shader_cache), active_program(0), show_wireframe(false), blending(false)
+		: window(window), shader_cache(shader_cache), active_program(0), show_wireframe(false), blending(false), alpha(1.0f)
 	{
 		test_capabilities();
 		uniform_buffers = std::make_unique<GenericBuffer>(UniformBuffer::_COUNT);
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include <dukat/camera2.h>
 #include <dukat/log.h>
+#include <dukat/profiler.h>
 #include <dukat/renderer2.h>
 #include <dukat/renderlayer2.h>
 #include <dukat/shadercache.h>
@@ -60,7 +61,7 @@ namespace dukat
 	{
 		// Create buffer for particle rendering
 		particle_buffer = std::make_unique<VertexBuffer>(1);
-		particle_buffer->load_data(0, GL_ARRAY_BUFFER, max_particles, sizeof(Vertex2PSC), nullptr, GL_STREAM_DRAW);
+		particle_buffer->load_data(0, GL_ARRAY_BUFFER, particle_batch_size, sizeof(Vertex2PSC), nullptr, GL_STREAM_DRAW);
 	}
 
 	void Renderer2::initialize_frame_buffers(void)
@@ -249,6 +250,7 @@ namespace dukat
 
 	void Renderer2::render(void)
 	{
+		PROFILE_SCOPE("renderer2.render");
 		// Call glFinish to avoid buffer updates on older Intel GPU.
 		// The goal is to wait until all pending render operations of
 		// the previous frame have finished.
@@ -265,24 +267,33 @@ namespace dukat
 		update_uniforms();
 #endif
 		// Composite pass - rendered to screenbuffer via framebuffer
-		for (auto& layer : layers)
 		{
-			if (!layer->visible() || layer->stage != RenderLayer2::Composite)
-				continue;
-			render_layer(*layer);
+			PROFILE_SCOPE("renderer2.composite");
+			for (auto& layer : layers)
+			{
+				if (!layer->visible() || layer->stage != RenderLayer2::Composite)
+					continue;
+				render_layer(*layer);
+			}
 		}
 
 		// Direct pass - rendered directly to screen buffer
-		for (auto& layer : layers)
 		{
-			if (!layer->visible() || layer->stage != RenderLayer2::Direct)
-				continue;
-			if (layer->id == "fade_mask")
-				continue;
-			render_layer(*layer);
+			PROFILE_SCOPE("renderer2.direct");
+			for (auto& layer : layers)
+			{
+				if (!layer->visible() || layer->stage != RenderLayer2::Direct)
+					continue;
+				if (layer->id == "fade_mask")
+					continue;
+				render_layer(*layer);
+			}
 		}
 
-		render_screenbuffer();
+		{
+			PROFILE_SCOPE("renderer2.present");
+			render_screenbuffer();
+		}
 
 #if OPENGL_VERSION < 30
 		// invalidate active program to force uniforms rebind during
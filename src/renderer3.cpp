@@ -6,6 +6,7 @@
 #include <dukat/meshbuilder2.h>
 #include <dukat/meshgroup.h>
 #include <dukat/perfcounter.h>
+#include <dukat/profiler.h>
 #include <dukat/shadercache.h>
 #include <dukat/shaderprogram.h>
 #include <dukat/sysutil.h>
@@ -16,7 +17,7 @@ namespace dukat
 	constexpr int Renderer3::fbo_size;
 
 	Renderer3::Renderer3(Window* window, ShaderCache* shader_cache, TextureCache* textures)
-		: Renderer(window, shader_cache), effects_enabled(false)
+		: Renderer(window, shader_cache), effects_enabled(false), culling_enabled(true)
 	{
 		// Enable transparency
 		set_blending(true);
@@ -83,8 +84,40 @@ namespace dukat
 		glClear(GL_COLOR_BUFFER_BIT);
 	}
 
+	void Renderer3::cull(const std::vector<Mesh*>& meshes)
+	{
+		culled.assign(meshes.size(), 0);
+		if (!culling_enabled || camera == nullptr)
+			return;
+
+		cull_boxes.clear();
+		cull_indices.clear();
+		for (auto i = 0; i < (int)meshes.size(); i++)
+		{
+			const auto mesh = meshes[i];
+			if (!mesh->visible || mesh->stage != RenderStage::SCENE)
+				continue;
+			if (auto bb = mesh->get_world_bb())
+			{
+				cull_boxes.push_back(*bb);
+				cull_indices.push_back(i);
+			}
+		}
+		if (cull_boxes.empty())
+			return;
+
+		cull_results.resize(cull_boxes.size());
+		camera->get_frustum().classify(cull_boxes.data(), (int)cull_boxes.size(), cull_results.data());
+		perfc.inc(PerformanceCounter::BB_CHECKS, (int)cull_boxes.size());
+		for (auto i = 0; i < (int)cull_results.size(); i++)
+		{
+			culled[cull_indices[i]] = (cull_results[i] == Frustum::Outside) ? 1 : 0;
+		}
+	}
+
 	void Renderer3::render(const std::vector<Mesh*>& meshes)
 	{
+		PROFILE_SCOPE("renderer3.render");
 #if OPENGL_VERSION >= 30
 		// Update uniform buffers once per frame.
 		update_uniforms();
@@ -104,11 +137,16 @@ namespace dukat
 		// Scene pass
 		glEnable(GL_DEPTH_TEST);
 
-		for (auto& it : meshes)
 		{
-			if (it->visible && it->stage == RenderStage::SCENE)
+			PROFILE_SCOPE("renderer3.scene");
+			cull(meshes);
+			for (auto i = 0; i < (int)meshes.size(); i++)
 			{
-				it->render(this);
+				auto mesh = meshes[i];
+				if (mesh->visible && mesh->stage == RenderStage::SCENE && !culled[i])
+				{
+					mesh->render(this);
+				}
 			}
 		}
 
@@ -123,6 +161,7 @@ namespace dukat
 #if OPENGL_VERSION >= 30
 		if (effects_enabled)
 		{
+			PROFILE_SCOPE("renderer3.effects");
 			// TODO: review how useful this is - effects passes are currently using fixed
 			// size texture 
 			// Effects passes
@@ -175,15 +214,21 @@ namespace dukat
 #endif
 
 		// Overlay pass
-		for (auto& it : meshes)
 		{
-			if (it->visible && it->stage == RenderStage::OVERLAY)
+			PROFILE_SCOPE("renderer3.overlay");
+			for (auto& it : meshes)
 			{
-				it->render(this);
+				if (it->visible && it->stage == RenderStage::OVERLAY)
+				{
+					it->render(this);
+				}
 			}
 		}
 
-        window->present();
+		{
+			PROFILE_SCOPE("renderer3.present");
+			window->present();
+		}
 
 #if OPENGL_VERSION < 30
 		// invalidate active program to force uniforms rebind during
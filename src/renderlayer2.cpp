@@ -7,6 +7,7 @@
 #include <dukat/effect2.h>
 #include <dukat/matrix4.h>
 #include <dukat/particle.h>
+#include <dukat/particledata.h>
 #include <dukat/perfcounter.h>
 #include <dukat/shadercache.h>
 #include <dukat/sprite.h>
@@ -19,11 +20,11 @@ namespace dukat
 	typedef Vertex2PSRC PVertex;
 
 	// module-global buffer for particle data used during rendering
-	static PVertex particle_data[Renderer2::max_particles];
+	static PVertex particle_data[Renderer2::particle_batch_size];
 
 	RenderLayer2::RenderLayer2(ShaderCache* shader_cache, VertexBuffer* sprite_buffer, VertexBuffer* particle_buffer,
 	    const std::string& id, float priority, float parallax) : render_target(nullptr), composite_binder(nullptr),
-		 sprite_buffer(sprite_buffer), particle_buffer(particle_buffer), is_visible(true),
+		 sprite_buffer(sprite_buffer), particle_buffer(particle_buffer), particles(nullptr), particle_layer(-1), is_visible(true),
 		id(id), parallax(parallax), priority(priority), stage(Composite)
 	{
 		sprite_program = shader_cache->get_program("sc_sprite.vsh", "sc_sprite.fsh");
@@ -66,16 +67,6 @@ namespace dukat
 		}
 	}
 
-	void RenderLayer2::add(Particle* particle)
-	{
-		particles.push_front(particle);
-	}
-
-	void RenderLayer2::remove(Particle* p)
-	{
-		particles.erase(std::remove(particles.begin(), particles.end(), p), particles.end());
-	}
-
 	void RenderLayer2::add(TextMeshInstance * text)
 	{
 		texts.push_back(text);
@@ -116,7 +107,7 @@ namespace dukat
 	{
 		sprites.clear();
 		effects.clear();
-		particles.clear();
+		particles = nullptr;
 		texts.clear();
 	}
 
@@ -318,48 +309,73 @@ namespace dukat
 
 	void RenderLayer2::render_particles(Renderer2* renderer, const AABB2& camera_bb)
 	{
+		if (particles == nullptr || particle_layer < 0)
+			return;
+
 		// increase camera bb slightly to avoid culling particles with size > 1
 		// which fall just outside of screen rect; otherwise these will cause flickering
 		const Vector2 padding{ 4, 4 };
 		const auto bb = AABB2{ camera_bb.min - padding, camera_bb.max + padding };
-		auto particle_count = 0;
-		for (auto it = particles.begin(); it != particles.end(); )
+		auto& d = *particles;
+		auto batch_count = 0;
+		auto total_count = 0;
+		auto bound = false;
+		const auto end = d.get_layer_end(particle_layer);
+		for (auto i = d.get_layer_begin(particle_layer); i < end; i++)
 		{
-			Particle* p = (*it);
-			// remove dead particles
-			if (p->ttl <= 0)
+			// check if particle visible and store result in flags
+			if (bb.contains(Vector2{ d.px[i], d.py[i] }))
 			{
-				it = particles.erase(it);
-				continue;
+				d.flags[i] |= Particle::Rendered;
+				auto& v = particle_data[batch_count++];
+				v.px = d.px[i];
+				v.py = d.py[i];
+				v.size = d.size[i];
+				v.ry = d.ry[i];
+				v.cr = d.cr[i];
+				v.cg = d.cg[i];
+				v.cb = d.cb[i];
+				v.ca = d.ca[i];
+			}
+			else
+			{
+				d.flags[i] &= ~Particle::Rendered;
 			}
 
-			// check if particle visible and store result in ->rendered
-			if (bb.contains(p->pos))
+			// submit staging buffer once it's full
+			if (batch_count == Renderer2::particle_batch_size)
 			{
-				p->flags |= Particle::Rendered;
-				particle_data[particle_count].px = p->pos.x;
-				particle_data[particle_count].py = p->pos.y;
-				particle_data[particle_count].size = p->size;
-				particle_data[particle_count].ry = p->ry;
-				particle_data[particle_count].cr = p->color.r;
-				particle_data[particle_count].cg = p->color.g;
-				particle_data[particle_count].cb = p->color.b;
-				particle_data[particle_count].ca = p->color.a;
-				particle_count++;
+				if (!bound)
+				{
+					bind_particle_buffer(renderer);
+					bound = true;
+				}
+				draw_particle_batch(batch_count);
+				total_count += batch_count;
+				batch_count = 0;
 			}
-			else
+		}
+
+		if (batch_count > 0)
+		{
+			if (!bound)
 			{
-				p->flags &= ~Particle::Rendered;
+				bind_particle_buffer(renderer);
+				bound = true;
 			}
-			++it;
+			draw_particle_batch(batch_count);
+			total_count += batch_count;
 		}
-		perfc.inc(PerformanceCounter::PARTICLES, particle_count);
+		perfc.inc(PerformanceCounter::PARTICLES, total_count);
 
-		if (particle_count == 0)
+		if (bound)
 		{
-			return; // no particles left to render
+			unbind_particle_buffer();
 		}
+	}
 
+	void RenderLayer2::bind_particle_buffer(Renderer2* renderer)
+	{
 		renderer->switch_shader(particle_program);
 
 		// Set parallax value for this layer
@@ -369,9 +385,6 @@ namespace dukat
 		// bind particle vertex buffers
 		glBindVertexArray(particle_buffer->vao);
 		glBindBuffer(GL_ARRAY_BUFFER, particle_buffer->buffers[0]);
-		// Orphan buffer to improve streaming performance
-		glBufferData(GL_ARRAY_BUFFER, Renderer2::max_particles * sizeof(PVertex), nullptr, GL_STREAM_DRAW);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, particle_count * sizeof(PVertex), particle_data);
 		// bind vertex position
 		auto pos_id = particle_program->attr(Renderer::at_pos);
 		glEnableVertexAttribArray(pos_id);
@@ -386,11 +399,6 @@ namespace dukat
 		glEnableClientState(GL_VERTEX_ARRAY);
 		glEnableClientState(GL_COLOR_ARRAY);
 		glBindBuffer(GL_ARRAY_BUFFER, particle_buffer->buffers[0]);
-
-		// Orphan buffer to improve streaming performance
-		glBufferData(GL_ARRAY_BUFFER, Renderer2::max_particles * sizeof(PVertex), NULL, GL_STREAM_DRAW);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, particle_count * sizeof(PVertex), particle_data);
-
 		// bind vertex position
 		glVertexPointer(4, GL_FLOAT, sizeof(PVertex),
 			reinterpret_cast<const GLvoid*>(offsetof(PVertex, px)));
@@ -398,13 +406,23 @@ namespace dukat
 		glColorPointer(4, GL_FLOAT, sizeof(PVertex),
 			reinterpret_cast<const GLvoid*>(offsetof(PVertex, cr)));
 #endif
+	}
 
-		glDrawArrays(GL_POINTS, 0, particle_count);
+	void RenderLayer2::draw_particle_batch(int count)
+	{
+		// Orphan buffer to improve streaming performance; the previous batch
+		// may still be in use by the driver.
+		glBufferData(GL_ARRAY_BUFFER, Renderer2::particle_batch_size * sizeof(PVertex), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(PVertex), particle_data);
+		glDrawArrays(GL_POINTS, 0, count);
+	}
 
+	void RenderLayer2::unbind_particle_buffer(void)
+	{
 #ifdef _DEBUG
 	#if OPENGL_VERSION >= 30
-		glDisableVertexAttribArray(pos_id);
-		glDisableVertexAttribArray(color_id);
+		glDisableVertexAttribArray(particle_program->attr(Renderer::at_pos));
+		glDisableVertexAttribArray(particle_program->attr(Renderer::at_color));
 		glBindVertexArray(0);
 	#else
 		glDisableClientState(GL_VERTEX_ARRAY);
@@ -7,12 +7,14 @@ namespace dukat
 	void Scene2::update(float delta)
 	{
 		// Execute any delayed actions once
-		while (!delayed_actions.empty())
+		// Actions added while running are executed as well. Each action is moved
+		// out first, as adding actions may reallocate the list.
+		for (std::size_t i = 0; i < delayed_actions.size(); i++)
 		{
-			const auto& action = delayed_actions.front();
+			const auto action = std::move(delayed_actions[i]);
 			action();
-			delayed_actions.pop();
 		}
+		delayed_actions.clear();
 	}
 
 	void Scene2::render(void)
@@ -0,0 +1,44 @@
+#include "stdafx.h"
+#include <dukat/simd.h>
+
+#if defined(DUKAT_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace dukat
+{
+#ifdef DUKAT_AVX2
+	static bool detect_avx2(void)
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		// OSXSAVE and AVX
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+			return false;
+		// OS saves YMM state
+		if ((_xgetbv(0) & 0x6) != 0x6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+
+	bool cpu_has_avx2(void)
+	{
+		static const bool supported = detect_avx2();
+		return supported;
+	}
+#else
+	bool cpu_has_avx2(void)
+	{
+		return false;
+	}
+#endif
+}
@@ -0,0 +1,127 @@
+#include "stdafx.h"
+#include <dukat/skeleton.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace dukat
+{
+	void AnimationClip::add_joint(void)
+	{
+		rotation_begin.push_back(static_cast<uint32_t>(rotation.size()));
+		translation_begin.push_back(static_cast<uint32_t>(translation.size()));
+	}
+
+	void AnimationClip::add_rotation_key(float time, const Quaternion& q)
+	{
+		rotation_time.push_back(time);
+		rotation.push_back(q);
+		duration = std::max(duration, time);
+	}
+
+	void AnimationClip::add_translation_key(float time, const Vector3& t)
+	{
+		translation_time.push_back(time);
+		translation.push_back(t);
+		duration = std::max(duration, time);
+	}
+
+	// Returns index of first key in [begin..end) after time.
+	static uint32_t find_key(const std::vector<float>& times, uint32_t begin, uint32_t end, float time)
+	{
+		const auto first = times.begin() + begin;
+		const auto last = times.begin() + end;
+		return static_cast<uint32_t>(std::upper_bound(first, last, time) - times.begin());
+	}
+
+	void AnimationClip::sample(int joint, float time, Quaternion& q, Vector3& t) const
+	{
+		const auto last_joint = joint + 1 == get_joint_count();
+
+		const auto rb = rotation_begin[joint];
+		const auto re = last_joint ? static_cast<uint32_t>(rotation.size()) : rotation_begin[joint + 1];
+		if (rb == re)
+		{
+			q.identity();
+		}
+		else
+		{
+			const auto k = find_key(rotation_time, rb, re, time);
+			if (k == rb)
+				q = rotation[rb];
+			else if (k == re)
+				q = rotation[re - 1];
+			else
+			{
+				const auto t0 = rotation_time[k - 1];
+				const auto u = (time - t0) / (rotation_time[k] - t0);
+				q = slerp(rotation[k - 1], rotation[k], u);
+			}
+		}
+
+		const auto tb = translation_begin[joint];
+		const auto te = last_joint ? static_cast<uint32_t>(translation.size()) : translation_begin[joint + 1];
+		if (tb == te)
+		{
+			t = Vector3{ 0.0f, 0.0f, 0.0f };
+		}
+		else
+		{
+			const auto k = find_key(translation_time, tb, te, time);
+			if (k == tb)
+				t = translation[tb];
+			else if (k == te)
+				t = translation[te - 1];
+			else
+			{
+				const auto t0 = translation_time[k - 1];
+				const auto u = (time - t0) / (translation_time[k] - t0);
+				t = translation[k - 1] + (translation[k] - translation[k - 1]) * u;
+			}
+		}
+	}
+
+	int Skeleton::add_joint(int parent, const Matrix4& local)
+	{
+		const auto idx = get_joint_count();
+		if (parent >= idx)
+			throw std::runtime_error("Parent joint has to be added before its children.");
+		this->parent.push_back(parent);
+		this->local.push_back(local);
+		// (P * L)^-1 = L^-1 * P^-1
+		if (parent < 0)
+			inverse_bind.push_back(local.inverse());
+		else
+			inverse_bind.push_back(local.inverse() * inverse_bind[parent]);
+		return idx;
+	}
+
+	void Skeleton::build_palette(const AnimationClip& clip, float time, Matrix4* palette) const
+	{
+		const auto n = get_joint_count();
+		const auto animated = std::min(n, clip.get_joint_count());
+		Quaternion q;
+		Vector3 t;
+		Matrix4 key;
+		// Absolute joint transforms; parents are always computed first.
+		for (auto i = 0; i < n; i++)
+		{
+			const auto& bind = parent[i] < 0 ? local[i] : palette[parent[i]] * local[i];
+			if (i < animated)
+			{
+				clip.sample(i, time, q, t);
+				key.setup_rotation(q);
+				key.m[12] = t.x; key.m[13] = t.y; key.m[14] = t.z;
+				palette[i] = bind * key;
+			}
+			else
+			{
+				palette[i] = bind;
+			}
+		}
+		for (auto i = 0; i < n; i++)
+		{
+			palette[i] = root * palette[i] * inverse_bind[i];
+		}
+		palette[n] = root;
+	}
+}
@@ -0,0 +1,119 @@
+#include "stdafx.h"
+#include <dukat/skinnedmesh.h>
+#include <dukat/matrix4.h>
+#include <dukat/simd.h>
+#include <dukat/threadpool.h>
+#include <dukat/vector3.h>
+#include <algorithm>
+#include <numeric>
+
+namespace dukat
+{
+	// Number of vertices transformed per SIMD step
+	static constexpr int vertex_block = 8;
+
+	void SkinnedMesh::set_vertices(const Vector3* positions, const Vector3* normals, const int* joints, int count)
+	{
+		order.resize(count);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [joints](int a, int b) { return joints[a] < joints[b]; });
+
+		px.resize(count); py.resize(count); pz.resize(count);
+		nx.resize(count); ny.resize(count); nz.resize(count);
+		runs.clear();
+		for (auto i = 0; i < count; i++)
+		{
+			const auto src = order[i];
+			px[i] = positions[src].x; py[i] = positions[src].y; pz[i] = positions[src].z;
+			nx[i] = normals[src].x; ny[i] = normals[src].y; nz[i] = normals[src].z;
+			if (runs.empty() || runs.back().joint != joints[src])
+				runs.push_back(Run{ joints[src], i, i });
+			runs.back().end = i + 1;
+		}
+	}
+
+#ifdef DUKAT_AVX2
+	// Transforms vertices [begin..end) in blocks of 8. Returns index of first
+	// vertex not transformed.
+	DUKAT_TARGET_AVX2 static int skin_avx2(const float* m, const float* px, const float* py, const float* pz,
+		const float* nx, const float* ny, const float* nz, const int* order, int begin, int end, Model3::Vertex* out)
+	{
+		const auto m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+		const auto m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]);
+		const auto m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]);
+		const auto m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]);
+		alignas(32) float res[6][vertex_block];
+
+		auto i = begin;
+		for (; i + vertex_block <= end; i += vertex_block)
+		{
+			auto x = _mm256_loadu_ps(px + i), y = _mm256_loadu_ps(py + i), z = _mm256_loadu_ps(pz + i);
+			_mm256_store_ps(res[0], _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m0), _mm256_mul_ps(y, m4)),
+				_mm256_add_ps(_mm256_mul_ps(z, m8), m12)));
+			_mm256_store_ps(res[1], _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m1), _mm256_mul_ps(y, m5)),
+				_mm256_add_ps(_mm256_mul_ps(z, m9), m13)));
+			_mm256_store_ps(res[2], _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m2), _mm256_mul_ps(y, m6)),
+				_mm256_add_ps(_mm256_mul_ps(z, m10), m14)));
+
+			x = _mm256_loadu_ps(nx + i); y = _mm256_loadu_ps(ny + i); z = _mm256_loadu_ps(nz + i);
+			_mm256_store_ps(res[3], _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m0), _mm256_mul_ps(y, m4)),
+				_mm256_mul_ps(z, m8)));
+			_mm256_store_ps(res[4], _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m1), _mm256_mul_ps(y, m5)),
+				_mm256_mul_ps(z, m9)));
+			_mm256_store_ps(res[5], _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m2), _mm256_mul_ps(y, m6)),
+				_mm256_mul_ps(z, m10)));
+
+			// scatter back to original vertex order
+			for (auto k = 0; k < vertex_block; k++)
+			{
+				auto& v = out[order[i + k]];
+				v.pos[0] = res[0][k]; v.pos[1] = res[1][k]; v.pos[2] = res[2][k];
+				v.nor[0] = res[3][k]; v.nor[1] = res[4][k]; v.nor[2] = res[5][k];
+			}
+		}
+		return i;
+	}
+#endif
+
+	void SkinnedMesh::skin_range(const Matrix4& mat, int begin, int end, Model3::Vertex* out) const
+	{
+		const auto m = mat.m;
+		auto i = begin;
+#ifdef DUKAT_AVX2
+		if (cpu_has_avx2())
+		{
+			i = skin_avx2(m, px.data(), py.data(), pz.data(), nx.data(), ny.data(), nz.data(),
+				order.data(), begin, end, out);
+		}
+#endif
+		for (; i < end; i++)
+		{
+			auto& v = out[order[i]];
+			v.pos[0] = (px[i] * m[0] + py[i] * m[4]) + (pz[i] * m[8] + m[12]);
+			v.pos[1] = (px[i] * m[1] + py[i] * m[5]) + (pz[i] * m[9] + m[13]);
+			v.pos[2] = (px[i] * m[2] + py[i] * m[6]) + (pz[i] * m[10] + m[14]);
+			v.nor[0] = (nx[i] * m[0] + ny[i] * m[4]) + nz[i] * m[8];
+			v.nor[1] = (nx[i] * m[1] + ny[i] * m[5]) + nz[i] * m[9];
+			v.nor[2] = (nx[i] * m[2] + ny[i] * m[6]) + nz[i] * m[10];
+		}
+	}
+
+	void SkinnedMesh::skin(const Matrix4* palette, Model3::Vertex* out) const
+	{
+		for (const auto& run : runs)
+		{
+			skin_range(palette[run.joint], run.begin, run.end, out);
+		}
+	}
+
+	void SkinnedMesh::skin(const Matrix4* palettes, int palette_size, Model3::Vertex* out, int count) const
+	{
+		const auto vertex_count = get_vertex_count();
+		parallel_for(0, count, 1, [&](int begin, int end) {
+			for (auto i = begin; i < end; i++)
+			{
+				skin(palettes + i * palette_size, out + i * vertex_count);
+			}
+		});
+	}
+}
@@ -0,0 +1,180 @@
+#include "stdafx.h"
+#include <dukat/softwareclipmap.h>
+#include <dukat/heightmap.h>
+#include <dukat/simd.h>
+#include <dukat/threadpool.h>
+
+namespace dukat
+{
+	// Minimum number of normal texels processed per parallel work item.
+	static constexpr int min_texels_per_task = 4096;
+
+	// Computes one row of normals from the expanded elevation rows above (up),
+	// at (center) and below (down) the row. Each expanded row holds size + 1
+	// samples, so that row[x] is the elevation the shader reads for texel x.
+	static void normal_row_scalar(const float* up, const float* center, const float* down,
+		int begin, int end, int size, float grid_scale, float* out)
+	{
+		for (auto x = begin; x < end; x++)
+		{
+			const auto zx = center[std::min(size, x + 1)] - center[std::max(0, x - 1)];
+			const auto zy = down[x] - up[x];
+			// pack coordinates in [-1, +1] range to [0, 1] range
+			out[2 * x] = (zx * grid_scale) * 0.5f + 0.5f;
+			out[2 * x + 1] = (zy * grid_scale) * 0.5f + 0.5f;
+		}
+	}
+
+#ifdef DUKAT_AVX2
+	// Processes texels [1..size-1) in blocks of 8 and returns first texel not processed.
+	DUKAT_TARGET_AVX2 static int normal_row_avx2(const float* up, const float* center, const float* down,
+		int size, float grid_scale, float* out)
+	{
+		const auto gs = _mm256_set1_ps(grid_scale);
+		const auto half = _mm256_set1_ps(0.5f);
+		auto x = 1;
+		for (; x + 8 <= size; x += 8)
+		{
+			const auto zx = _mm256_sub_ps(_mm256_loadu_ps(center + x + 1), _mm256_loadu_ps(center + x - 1));
+			const auto zy = _mm256_sub_ps(_mm256_loadu_ps(down + x), _mm256_loadu_ps(up + x));
+			const auto r = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(zx, gs), half), half);
+			const auto g = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(zy, gs), half), half);
+			// interleave into RG pairs
+			const auto lo = _mm256_unpacklo_ps(r, g);
+			const auto hi = _mm256_unpackhi_ps(r, g);
+			_mm256_storeu_ps(out + 2 * x, _mm256_permute2f128_ps(lo, hi, 0x20));
+			_mm256_storeu_ps(out + 2 * x + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+		}
+		return x;
+	}
+#endif
+
+	void generate_clipmap_normals(const float* elevation, int texture_size, int u, int v,
+		float scale_factor, float* normals)
+	{
+		const auto size = 2 * texture_size;
+		const auto stride = size + 1;
+		// ratio of z to x/y grid spacing, see ClipMap::update_normal_maps
+		const auto grid_scale = -0.5f * scale_factor;
+#ifdef DUKAT_AVX2
+		const auto use_avx2 = cpu_has_avx2();
+#endif
+
+		// Expand elevation rows to normal map resolution. The shader samples the
+		// elevation sampler with torroidal offset at half the normal map resolution,
+		// so normal texel x reads elevation texel (x / 2 + u) mod texture_size.
+		std::vector<float> expanded(texture_size * stride);
+		std::vector<int> columns(stride);
+		for (auto x = 0; x < stride; x++)
+		{
+			columns[x] = ((x >> 1) + u) % texture_size;
+		}
+		const auto row_grain = std::max(1, min_texels_per_task / stride);
+		parallel_for(0, texture_size, row_grain, [&](int begin, int end) {
+			for (auto y = begin; y < end; y++)
+			{
+				const auto src = elevation + y * texture_size;
+				auto dst = expanded.data() + y * stride;
+				for (auto x = 0; x < stride; x++)
+				{
+					dst[x] = src[columns[x]];
+				}
+			}
+		});
+
+		const auto row = [&](int y) {
+			return expanded.data() + (((y >> 1) + v) % texture_size) * stride;
+		};
+		parallel_for(0, size, row_grain, [&](int begin, int end) {
+			for (auto y = begin; y < end; y++)
+			{
+				const auto up = row(std::max(0, y - 1));
+				const auto center = row(y);
+				const auto down = row(std::min(size, y + 1));
+				auto out = normals + 2 * y * size;
+				auto x = 0;
+#ifdef DUKAT_AVX2
+				if (use_avx2)
+				{
+					normal_row_scalar(up, center, down, 0, 1, size, grid_scale, out);
+					x = normal_row_avx2(up, center, down, size, grid_scale, out);
+				}
+#endif
+				normal_row_scalar(up, center, down, x, size, size, grid_scale, out);
+			}
+		});
+	}
+
+	SoftwareClipMap::SoftwareClipMap(int num_levels, int level_size, const HeightMap* height_map)
+		: height_map(height_map), state(num_levels, level_size, height_map), prefetching(true), normals(true)
+	{
+		const auto texture_size = state.get_texture_size();
+		prefetcher = std::make_unique<ClipMapPrefetcher>(height_map, num_levels, texture_size);
+		buffer.resize(texture_size * texture_size);
+		elevation_maps.resize(num_levels);
+		normal_maps.resize(num_levels);
+		for (auto i = 0; i < num_levels; i++)
+		{
+			elevation_maps[i].resize(texture_size * texture_size);
+			normal_maps[i].resize(2 * (2 * texture_size) * (2 * texture_size));
+		}
+
+		// build initial height and normal maps
+		refresh();
+	}
+
+	void SoftwareClipMap::apply_update(const ClipMapUpdate& u)
+	{
+		const auto texture_size = state.get_texture_size();
+		auto& dst = elevation_maps[u.level];
+		for (auto y = 0; y < u.texture.h; y++)
+		{
+			const auto ty = (u.texture.y + y) % texture_size;
+			const auto src = buffer.data() + y * u.world.w;
+			for (auto x = 0; x < u.texture.w; x++)
+			{
+				dst[ty * texture_size + (u.texture.x + x) % texture_size] = src[x];
+			}
+		}
+	}
+
+	int SoftwareClipMap::update(const Vector3& observer_pos, float delta)
+	{
+		prefetcher->update_observer(observer_pos, delta);
+		state.update(observer_pos);
+		const auto max_index = refresh();
+
+		if (prefetching)
+		{
+			prefetcher->predict(state.get_levels());
+		}
+
+		return max_index;
+	}
+
+	int SoftwareClipMap::refresh(void)
+	{
+		updates.clear();
+		const auto max_index = state.collect_updates(updates);
+		for (const auto& u : updates)
+		{
+			if (!prefetching || !prefetcher->fetch(u.level, u.world, buffer))
+			{
+				height_map->get_data(u.level, u.world, buffer);
+			}
+			apply_update(u);
+		}
+
+		if (normals)
+		{
+			for (auto i = max_index; i >= 0; i--)
+			{
+				const auto& level = state.get_level(i);
+				generate_clipmap_normals(elevation_maps[i].data(), state.get_texture_size(),
+					level.u, level.v, height_map->get_scale_factor(), normal_maps[i].data());
+			}
+		}
+
+		return max_index;
+	}
+}
@@ -54,6 +54,29 @@ namespace dukat
 		}
 	}
 
+	uint32_t compute_checksum(const uint8_t* data, size_t size)
+	{
+		// process data as 32-bit words with 64-bit running sums
+		uint64_t sum1 = 0, sum2 = 0;
+		const auto num_words = size / sizeof(uint32_t);
+		for (auto i = 0u; i < num_words; i++)
+		{
+			uint32_t word;
+			std::memcpy(&word, data + i * sizeof(uint32_t), sizeof(uint32_t));
+			sum1 += word;
+			sum2 += sum1;
+		}
+		// trailing bytes
+		for (auto i = num_words * sizeof(uint32_t); i < size; i++)
+		{
+			sum1 += data[i];
+			sum2 += sum1;
+		}
+		sum1 = (sum1 & 0xffffffff) ^ (sum1 >> 32);
+		sum2 = (sum2 & 0xffffffff) ^ (sum2 >> 32);
+		return static_cast<uint32_t>(sum1 ^ (sum2 << 16) ^ (sum2 >> 16));
+	}
+
 	void save_screenshot(const std::string& filename)
 	{
 		log->info("Saving screenshot to: {}", filename);
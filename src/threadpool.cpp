@@ -0,0 +1,146 @@
+#include "stdafx.h"
+#include <dukat/threadpool.h>
+#include <atomic>
+
+namespace dukat
+{
+	ThreadPool::ThreadPool(int num_threads) : done(false)
+	{
+		if (num_threads <= 0)
+		{
+			num_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+		}
+		workers.reserve(num_threads);
+		for (auto i = 0; i < num_threads; i++)
+		{
+			workers.push_back(std::thread(&ThreadPool::worker_loop, this));
+		}
+	}
+
+	ThreadPool::~ThreadPool(void)
+	{
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			done = true;
+		}
+		cv.notify_all();
+		std::for_each(workers.begin(), workers.end(), std::mem_fn(&std::thread::join));
+	}
+
+	void ThreadPool::worker_loop(void)
+	{
+		while (true)
+		{
+			std::function<void(void)> task;
+			{
+				std::unique_lock<std::mutex> lk(mtx);
+				cv.wait(lk, [this] { return done || !tasks.empty(); });
+				if (tasks.empty())
+				{
+					return; // done
+				}
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+	std::future<void> ThreadPool::submit(std::function<void(void)> task)
+	{
+		auto packaged = std::make_shared<std::packaged_task<void(void)>>(std::move(task));
+		auto res = packaged->get_future();
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			tasks.push_back([packaged](void) { (*packaged)(); });
+		}
+		cv.notify_one();
+		return res;
+	}
+
+	void ThreadPool::parallel_for(int begin, int end, int grain_size, const std::function<void(int, int)>& fn)
+	{
+		if (end <= begin)
+		{
+			return;
+		}
+
+		grain_size = std::max(1, grain_size);
+		const auto num_chunks = (end - begin + grain_size - 1) / grain_size;
+		if (num_chunks == 1 || workers.empty())
+		{
+			fn(begin, end);
+			return;
+		}
+
+		// Chunks are claimed dynamically by helpers and the calling thread alike. The
+		// caller only waits for chunks to complete, not for helpers to start, so helpers
+		// queued behind other work cannot stall it. Shared state outlives this call for
+		// helpers that start late and find no work left.
+		// If a chunk throws, remaining chunks are skipped and the first exception is
+		// rethrown on the caller once no chunk is running anymore.
+		struct ForState
+		{
+			std::atomic<int> next_chunk;
+			std::atomic<int> completed;
+			std::atomic<bool> failed;
+			std::exception_ptr error;
+			std::mutex mtx;
+			std::condition_variable cv;
+			const std::function<void(int, int)>* fn;
+		};
+		auto state = std::make_shared<ForState>();
+		state->next_chunk = 0;
+		state->completed = 0;
+		state->failed = false;
+		state->fn = &fn;
+
+		auto run_chunks = [state, begin, end, grain_size, num_chunks](void) {
+			int chunk;
+			while ((chunk = state->next_chunk.fetch_add(1)) < num_chunks)
+			{
+				if (!state->failed.load())
+				{
+					const auto chunk_begin = begin + chunk * grain_size;
+					try
+					{
+						(*state->fn)(chunk_begin, std::min(end, chunk_begin + grain_size));
+					}
+					catch (...)
+					{
+						std::lock_guard<std::mutex> lk(state->mtx);
+						if (!state->failed.exchange(true))
+							state->error = std::current_exception();
+					}
+				}
+				if (state->completed.fetch_add(1) + 1 == num_chunks)
+				{
+					std::lock_guard<std::mutex> lk(state->mtx);
+					state->cv.notify_all();
+				}
+			}
+		};
+
+		const auto num_helpers = std::min(static_cast<int>(workers.size()), num_chunks - 1);
+		{
+			std::lock_guard<std::mutex> lk(mtx);
+			for (auto i = 0; i < num_helpers; i++)
+			{
+				tasks.push_back(run_chunks);
+			}
+		}
+		cv.notify_all();
+
+		run_chunks();
+		std::unique_lock<std::mutex> lk(state->mtx);
+		state->cv.wait(lk, [&] { return state->completed == num_chunks; });
+		if (state->error != nullptr)
+			std::rethrow_exception(state->error);
+	}
+
+	ThreadPool& ThreadPool::shared(void)
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+}
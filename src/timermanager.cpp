@@ -1,57 +1,128 @@
 #include "stdafx.h"
 #include <dukat/timermanager.h>
 #include <dukat/perfcounter.h>
+#include <dukat/profiler.h>
 
 namespace dukat
 {
-	Timer* TimerManager::create_timer(float interval, std::function<void(void)> callback, bool recurring)
+	TimerManager::TimerManager(GameBase* game) : Manager(game), generation(0u), serial(0u), active_group(0u), timers(true)
+	{
+		for (auto& g : groups)
+		{
+			g.time = 0.0;
+			g.count = 0;
+		}
+	}
+
+	Timer* TimerManager::create_timer(float interval, Delegate<void(void)> callback, bool recurring)
     {
-		// Find unused timer
 		Timer* t = timers.acquire();
-		if (t == nullptr) // no timers available
-			return nullptr; 
 
 		// initialize timer
-		t->callback = callback;
+		t->callback = std::move(callback);
 		t->generation = generation;
+		t->serial = serial++;
 		t->group = active_group;
 		t->interval = interval;
 		t->recurring = recurring;
-		t->runtime = 0.0f;
+
+		auto& g = groups[t->group];
+		t->expiry = g.time + interval;
+		g.count++;
+		schedule(g, Entry{ t->expiry, t->serial, timers.handle(t) });
 		return t;
     }
-    
-    void TimerManager::update(float delta)
-    {
-		generation++;
 
-		auto alive = 0;
-		timers.free_index = 0;
-		for (auto& t : timers.data)
+	void TimerManager::schedule(Group& group, const Entry& entry)
+	{
+		group.queue.push_back(entry);
+		std::push_heap(group.queue.begin(), group.queue.end(), later);
+	}
+
+	void TimerManager::release(Timer* timer)
+	{
+		if (!timer->alive)
+			return;
+		auto& g = groups[timer->group];
+		g.count--;
+		timers.release(timer);
+
+		// Cancelled timers stay queued until they expire; drop them once they
+		// make up most of the queue.
+		if (g.queue.size() > 64 && g.queue.size() > 4 * static_cast<std::size_t>(g.count))
 		{
-			// only process live timers
-			if (!t.alive)
+			g.queue.erase(std::remove_if(g.queue.begin(), g.queue.end(), [&](const Entry& e) {
+				return lookup(e) == nullptr;
+			}), g.queue.end());
+			std::make_heap(g.queue.begin(), g.queue.end(), later);
+		}
+	}
+
+	void TimerManager::advance(Group& group, float delta)
+	{
+		group.time += delta;
+		requeue.clear();
+		while (!group.queue.empty() && group.queue.front().expiry <= group.time)
+		{
+			std::pop_heap(group.queue.begin(), group.queue.end(), later);
+			auto e = group.queue.back();
+			group.queue.pop_back();
+
+			auto t = lookup(e);
+			if (t == nullptr) // cancelled
 				continue;
 			// only process timers that have been created before this frame
-			if (t.generation == generation)
+			if (t->generation == generation)
+			{
+				requeue.push_back(e);
 				continue;
-			// only process timers of group 0 or active group
-			if (t.group != active_group && t.group > 0)
-				continue;
-			alive++;
-			t.runtime += delta;
-            // check if timer has expired
-            if (t.runtime >= t.interval)
-            {
-                if (t.callback)
-                    t.callback();
-
-                if (t.recurring) // reset timer, accounting for any time over interval
-                    t.runtime = t.runtime - t.interval;
-                else
-					timers.release(t);
-            }
-        }
-		perfc.inc(PerformanceCounter::TIMERS, alive);
+			}
+
+			if (t->callback)
+			{
+				t->callback();
+				// callback may have cancelled this timer
+				if (lookup(e) == nullptr)
+					continue;
+			}
+
+			if (t->recurring) // reschedule, accounting for any time over interval
+			{
+				t->expiry += t->interval;
+				e.expiry = t->expiry;
+				requeue.push_back(e); // fires at most once per update
+			}
+			else
+			{
+				release(t);
+			}
+		}
+		for (const auto& e : requeue)
+		{
+			schedule(group, e);
+		}
+	}
+    
+    void TimerManager::update(float delta)
+    {
+		PROFILE_SCOPE("timers.update");
+		generation++;
+
+		// only group 0 and active group advance
+		advance(groups[0], delta);
+		if (active_group > 0)
+			advance(groups[active_group], delta);
+
+		perfc.inc(PerformanceCounter::TIMERS, static_cast<int>(timers.size()));
     }
-}
\ No newline at end of file
+
+	void TimerManager::clear(void)
+	{
+		timers.clear();
+		for (auto& g : groups)
+		{
+			g.count = 0;
+			g.queue.clear();
+		}
+	}
+}
@@ -1,7 +1,7 @@
 #include "stdafx.h"
 #include <dukat/vector2.h>
 #include <dukat/mathutil.h>
-#include <random>
+#include <dukat/rand.h>
 
 namespace dukat
 {
@@ -46,14 +46,14 @@ namespace dukat
 
 	void generate_distribution(std::vector<Vector2>& data, const Vector2& min_v, const Vector2& max_v)
 	{
-		std::random_device rd;
-		std::mt19937 gen(rd());
-		std::uniform_real_distribution<float> x_dist(min_v.x, max_v.x);
-		std::uniform_real_distribution<float> y_dist(min_v.y, max_v.y);
-		for (auto& el : data)
+		// batch fill unit values, then scale per component
+		std::vector<float> buffer(data.size() * 2);
+		thread_random().fill(buffer.data(), buffer.size(), 0.0f, 1.0f);
+		const auto range = max_v - min_v;
+		for (auto i = 0u; i < data.size(); i++)
 		{
-			el.x = x_dist(gen);
-			el.y = y_dist(gen);
+			data[i].x = min_v.x + range.x * buffer[2 * i];
+			data[i].y = min_v.y + range.y * buffer[2 * i + 1];
 		}
 	}
 
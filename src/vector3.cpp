@@ -1,7 +1,6 @@
 #include "stdafx.h"
 #include <dukat/vector3.h>
 #include <dukat/mathutil.h>
-#include <random>
 #include <dukat/rand.h>
 
 namespace dukat
@@ -62,16 +61,14 @@ namespace dukat
 
 	void generate_distribution(std::vector<Vector3>& data, const Vector3& min_v, const Vector3& max_v)
 	{
-		std::random_device rd;
-		std::mt19937 gen(rd());
-		std::uniform_real_distribution<float> x_dist(min_v.x, max_v.x);
-		std::uniform_real_distribution<float> y_dist(min_v.y, max_v.y);
-		std::uniform_real_distribution<float> z_dist(min_v.z, max_v.z);
-		for (auto& el : data)
+		// batch fill unit values, then scale per component
+		std::vector<float> buffer(data.size() * 3);
+		thread_random().fill(buffer.data(), buffer.size(), 0.0f, 1.0f);
+		for (auto i = 0u; i < data.size(); i++)
 		{
-			el.x = x_dist(gen);
-			el.y = y_dist(gen);
-			el.z = z_dist(gen);
+			data[i].x = min_v.x + (max_v.x - min_v.x) * buffer[3 * i];
+			data[i].y = min_v.y + (max_v.y - min_v.y) * buffer[3 * i + 1];
+			data[i].z = min_v.z + (max_v.z - min_v.z) * buffer[3 * i + 2];
 		}
 	}
 